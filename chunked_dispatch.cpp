@@ -0,0 +1,122 @@
+#include "chunked_dispatch.h"
+
+#include "rvv_kernels.h"
+
+#include <algorithm>
+
+arrow::Result<std::vector<ColumnSlice>> AlignChunks(
+    const std::vector<std::shared_ptr<arrow::ChunkedArray>>& columns,
+    int64_t max_rows) {
+  std::vector<ColumnSlice> slices;
+  if (columns.empty()) {
+    return slices;
+  }
+  const int64_t length = columns[0]->length();
+  for (const auto& column : columns) {
+    if (column->length() != length) {
+      return arrow::Status::Invalid("Cannot align columns of length ", length,
+                                    " and ", column->length());
+    }
+  }
+
+  // Per column: current chunk and position inside it
+  std::vector<int> chunk(columns.size(), 0);
+  std::vector<int64_t> pos(columns.size(), 0);
+  for (int64_t row = 0; row < length;) {
+    int64_t len = length - row;
+    if (max_rows > 0) {
+      len = std::min(len, max_rows);
+    }
+    for (size_t c = 0; c < columns.size(); c++) {
+      while (pos[c] == columns[c]->chunk(chunk[c])->length()) {
+        chunk[c]++;
+        pos[c] = 0;
+      }
+      len = std::min(len, columns[c]->chunk(chunk[c])->length() - pos[c]);
+    }
+
+    ColumnSlice slice{row, len, {}};
+    for (size_t c = 0; c < columns.size(); c++) {
+      slice.columns.push_back(columns[c]->chunk(chunk[c])->Slice(pos[c], len));
+      pos[c] += len;
+    }
+    slices.push_back(std::move(slice));
+    row += len;
+  }
+  return slices;
+}
+
+arrow::Result<std::vector<ColumnSlice>> SliceBatch(
+    const arrow::RecordBatch& batch, const std::vector<std::string>& names,
+    int64_t max_rows) {
+  std::vector<std::shared_ptr<arrow::ChunkedArray>> columns;
+  for (const auto& name : names) {
+    auto array = batch.GetColumnByName(name);
+    if (!array) {
+      return arrow::Status::Invalid("Column not in batch: ", name);
+    }
+    columns.push_back(std::make_shared<arrow::ChunkedArray>(array));
+  }
+  return AlignChunks(columns, max_rows);
+}
+
+void DropNulls(const arrow::Array& array, uint8_t* selection,
+               int64_t selection_offset) {
+  if (array.null_count() == 0 || array.null_bitmap_data() == nullptr) {
+    return;
+  }
+  rvv::and_bitmap(selection, selection_offset, array.null_bitmap_data(),
+                  array.offset(), array.length());
+}
+
+arrow::Status DictionaryLookup(
+    const arrow::Array& array,
+    const std::function<int32_t(std::string_view entry)>& entry_value,
+    int32_t* out) {
+  if (array.type_id() != arrow::Type::DICTIONARY) {
+    return arrow::Status::Invalid("Not a dictionary-encoded column: ",
+                                  array.type()->ToString());
+  }
+  const auto& dict_array = static_cast<const arrow::DictionaryArray&>(array);
+  const auto& dict_type = static_cast<const arrow::DictionaryType&>(*array.type());
+  if (dict_type.index_type()->id() != arrow::Type::INT32 ||
+      dict_type.value_type()->id() != arrow::Type::STRING) {
+    return arrow::Status::Invalid("Unsupported dictionary type: ",
+                                  dict_type.ToString());
+  }
+
+  const auto& dictionary =
+      static_cast<const arrow::StringArray&>(*dict_array.dictionary());
+  // Entry 0 always exists so that null rows can point at it
+  std::vector<int32_t> table(std::max<int64_t>(dictionary.length(), 1), 0);
+  for (int64_t k = 0; k < dictionary.length(); k++) {
+    table[k] = entry_value(dictionary.GetView(k));
+  }
+
+  const int64_t n = array.length();
+  const int32_t* index =
+      static_cast<const arrow::Int32Array&>(*dict_array.indices()).raw_values();
+  if (array.null_count() != 0) {
+    // Indices under null rows are arbitrary. The gather reads each strip of
+    // indices before writing it, so out can serve as the index array.
+    std::copy(index, index + n, out);
+    for (int64_t i = 0; i < n; i++) {
+      if (array.IsNull(i)) {
+        out[i] = 0;
+      }
+    }
+    index = out;
+  }
+  rvv::gather_int32(table.data(), index, out, n);
+  return arrow::Status::OK();
+}
+
+void ContainsBitmap(const arrow::StringArray& array, std::string_view needle,
+                    uint8_t* selection, int64_t selection_offset) {
+  // An all-empty array may have no data buffer; the kernel then reads none
+  const uint8_t* data =
+      array.value_data() ? array.value_data()->data() : nullptr;
+  rvv::contains_bitmap(array.raw_value_offsets(), data, array.length(),
+                       needle.data(), needle.size(), selection,
+                       selection_offset);
+}
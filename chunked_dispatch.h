@@ -0,0 +1,67 @@
+// Chunk-aware dispatch over Arrow columns for the RVV kernels.
+//
+// The kernels take raw pointers, which is only valid for one contiguous
+// Array at a time. Columns of one table need not share a chunk layout, and
+// any Array may be a slice with a non-zero offset and a validity bitmap.
+// AlignChunks() cuts a set of equal-length columns into row ranges where
+// every column is a single Array; each range can be processed on its own,
+// in any order and on any thread.
+#pragma once
+
+#include <arrow/array.h>
+#include <arrow/chunked_array.h>
+#include <arrow/record_batch.h>
+#include <arrow/result.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct ColumnSlice {
+  int64_t row_offset;  // first row of the slice within the input columns
+  int64_t length;
+  // One Array per input column, in input order. raw_values() on these
+  // already accounts for the slice offset; validity bitmaps do not (use
+  // DropNulls).
+  std::vector<std::shared_ptr<arrow::Array>> columns;
+
+  template <typename ArrayT>
+  const ArrayT& column(size_t i) const {
+    return static_cast<const ArrayT&>(*columns[i]);
+  }
+};
+
+// Splits columns into aligned slices no longer than max_rows (0 means only
+// chunk boundaries split). Fails if the columns differ in length.
+arrow::Result<std::vector<ColumnSlice>> AlignChunks(
+    const std::vector<std::shared_ptr<arrow::ChunkedArray>>& columns,
+    int64_t max_rows = 0);
+
+// The same for the named columns of a record batch.
+arrow::Result<std::vector<ColumnSlice>> SliceBatch(
+    const arrow::RecordBatch& batch, const std::vector<std::string>& names,
+    int64_t max_rows = 0);
+
+// Clears bit selection_offset + i of selection for every null row i of
+// array. A no-op when the array has no nulls.
+void DropNulls(const arrow::Array& array, uint8_t* selection,
+               int64_t selection_offset = 0);
+
+// Maps every row of a dictionary-encoded string column (DictionaryArray
+// with int32 indices, see ScanOptions::dictionary_columns) to an int32:
+// entry_value runs once per dictionary entry, then out[i] = table[index[i]]
+// is one vector gather. Typical values are predicate results (0 / 1) or
+// group ids. Values of null rows are unspecified (use DropNulls).
+arrow::Status DictionaryLookup(
+    const arrow::Array& array,
+    const std::function<int32_t(std::string_view entry)>& entry_value,
+    int32_t* out);
+
+// Sets bit selection_offset + i of selection to whether row i of array
+// contains needle (LIKE '%needle%'). Null rows get an unspecified bit (use
+// DropNulls).
+void ContainsBitmap(const arrow::StringArray& array, std::string_view needle,
+                    uint8_t* selection, int64_t selection_offset = 0);
@@ -0,0 +1,717 @@
+#include "column_cache.h"
+
+#include <arrow/api.h>
+#include <arrow/buffer.h>
+#include <arrow/io/file.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+// Bump when the layout changes
+constexpr uint32_t kFormatVersion = 1;
+constexpr char kMagic[8] = {'R', 'V', 'V', 'C', 'O', 'L', 'S', '1'};
+constexpr char kEndMagic[8] = {'R', 'V', 'V', 'C', 'E', 'N', 'D', '1'};
+// A cache line, and a multiple of every vector register width in use
+constexpr uint64_t kAlignment = 64;
+// Directory offset and size, then kEndMagic
+constexpr size_t kFooterSize = 2 * sizeof(uint64_t) + sizeof(kEndMagic);
+
+using Kind = ColumnCache::Kind;
+
+int64_t ValueWidth(Kind kind) {
+  switch (kind) {
+    case Kind::kInt64:
+      return 8;
+    case Kind::kDecimal128:
+      return 16;
+    default:
+      return 4;  // int32, date32, string offsets and dictionary codes
+  }
+}
+
+std::shared_ptr<arrow::DataType> ArrowType(const ColumnCache::Column& column,
+                                           bool as_dictionary) {
+  switch (column.kind) {
+    case Kind::kInt32:
+      return arrow::int32();
+    case Kind::kDate32:
+      return arrow::date32();
+    case Kind::kInt64:
+      return arrow::int64();
+    case Kind::kDecimal128:
+      return arrow::decimal128(column.precision, column.scale);
+    case Kind::kString:
+    case Kind::kDictionary:
+      return as_dictionary ? arrow::dictionary(arrow::int32(), arrow::utf8())
+                           : arrow::utf8();
+  }
+  return nullptr;
+}
+
+// Appends raw values to an in-memory directory
+class DirectoryWriter {
+ public:
+  template <typename T>
+  void Value(const T& value) {
+    static_assert(std::is_trivially_copyable<T>::value, "raw copies only");
+    bytes_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void String(const std::string& value) {
+    Value(static_cast<uint64_t>(value.size()));
+    bytes_ += value;
+  }
+
+  const std::string& bytes() const { return bytes_; }
+
+ private:
+  std::string bytes_;
+};
+
+// Reads fail (return false) instead of running past the directory.
+class DirectoryReader {
+ public:
+  DirectoryReader(const uint8_t* data, size_t size)
+      : data_(data), size_(size) {}
+
+  template <typename T>
+  bool Value(T* value) {
+    static_assert(std::is_trivially_copyable<T>::value, "raw copies only");
+    if (sizeof(T) > size_ - pos_) {
+      return false;
+    }
+    std::memcpy(value, data_ + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return true;
+  }
+
+  bool String(std::string* value) {
+    uint64_t length;
+    if (!Value(&length) || length > size_ - pos_) {
+      return false;
+    }
+    value->assign(reinterpret_cast<const char*>(data_ + pos_), length);
+    pos_ += length;
+    return true;
+  }
+
+  bool AtEnd() const { return pos_ == size_; }
+
+ private:
+  const uint8_t* data_;
+  size_t size_;
+  size_t pos_ = 0;
+};
+
+// Writes the buffers of the file, each at the next kAlignment boundary
+class BufferWriter {
+ public:
+  explicit BufferWriter(arrow::io::OutputStream* out) : out_(out) {}
+
+  void Write(const void* data, size_t size) {
+    if (status_.ok() && size > 0) {
+      status_ = out_->Write(data, static_cast<int64_t>(size));
+      position_ += size;
+    }
+  }
+
+  // Returns the offset and size of the buffer.
+  std::pair<uint64_t, uint64_t> Buffer(const void* data, size_t size) {
+    static const char kZeros[kAlignment] = {};
+    Write(kZeros, (kAlignment - position_ % kAlignment) % kAlignment);
+    uint64_t offset = position_;
+    Write(data, size);
+    return {offset, size};
+  }
+
+  uint64_t position() const { return position_; }
+  const arrow::Status& status() const { return status_; }
+
+ private:
+  arrow::io::OutputStream* out_;
+  arrow::Status status_;
+  uint64_t position_ = 0;
+};
+
+arrow::Result<Kind> KindOf(const arrow::Field& field) {
+  switch (field.type()->id()) {
+    case arrow::Type::INT32:
+      return Kind::kInt32;
+    case arrow::Type::DATE32:
+      return Kind::kDate32;
+    case arrow::Type::INT64:
+      return Kind::kInt64;
+    case arrow::Type::DECIMAL128:
+      return Kind::kDecimal128;
+    case arrow::Type::STRING:
+      return Kind::kString;
+    default:
+      return arrow::Status::TypeError(
+          "Cannot cache column ", field.name(), " of type ",
+          field.type()->ToString(), "; leave it out with --columns");
+  }
+}
+
+// Whether offsets[0 .. count] ascend from 0 to end, as the offsets of a
+// string array whose data buffer has end bytes must
+bool ValidOffsets(const int32_t* offsets, int64_t count, uint64_t end) {
+  bool ascending = offsets[0] == 0;
+  for (int64_t i = 0; i < count; i++) {
+    ascending &= offsets[i] <= offsets[i + 1];
+  }
+  return ascending && static_cast<uint64_t>(offsets[count]) == end;
+}
+
+// int32 offsets from 0 of a string array, which may be a slice
+std::vector<int32_t> RebasedOffsets(const arrow::StringArray& array) {
+  std::vector<int32_t> offsets(array.length() + 1);
+  int32_t base = array.value_offset(0);
+  for (int64_t i = 0; i <= array.length(); i++) {
+    offsets[i] = array.value_offset(i) - base;
+  }
+  return offsets;
+}
+
+// What the first pass learns of a column
+struct ColumnPlan {
+  std::string name;
+  Kind kind;
+  int32_t precision = 0;
+  int32_t scale = 0;
+  // Distinct values of a string column while there are few enough
+  std::set<std::string> distinct;
+  bool too_many_distinct = false;
+  // Sorted dictionary and its codes, for dictionary columns
+  std::vector<std::string> dictionary;
+  std::unordered_map<std::string_view, int32_t> codes;
+};
+
+arrow::Status PlanColumns(const std::string& parquet_path,
+                          const ScanOptions& scan_options,
+                          const ColumnCacheOptions& options,
+                          std::vector<ColumnPlan>* plans) {
+  std::unique_ptr<ParquetScanner> scanner;
+  ARROW_ASSIGN_OR_RAISE(scanner,
+                        ParquetScanner::Open(parquet_path, scan_options));
+  std::shared_ptr<arrow::RecordBatch> batch;
+  while (true) {
+    ARROW_ASSIGN_OR_RAISE(batch, scanner->Next());
+    if (!batch) {
+      break;
+    }
+    if (plans->empty()) {
+      for (const auto& field : batch->schema()->fields()) {
+        ColumnPlan plan;
+        plan.name = field->name();
+        ARROW_ASSIGN_OR_RAISE(plan.kind, KindOf(*field));
+        if (plan.kind == Kind::kDecimal128) {
+          const auto& type =
+              static_cast<const arrow::DecimalType&>(*field->type());
+          plan.precision = type.precision();
+          plan.scale = type.scale();
+        }
+        plans->push_back(std::move(plan));
+      }
+    }
+    for (int c = 0; c < batch->num_columns(); c++) {
+      const arrow::Array& array = *batch->column(c);
+      ColumnPlan& plan = (*plans)[c];
+      if (array.null_count() > 0) {
+        return arrow::Status::Invalid("Cannot cache column ", plan.name,
+                                      ": it has nulls");
+      }
+      if (plan.kind != Kind::kString || plan.too_many_distinct) {
+        continue;
+      }
+      const auto& strings = static_cast<const arrow::StringArray&>(array);
+      for (int64_t i = 0; i < strings.length(); i++) {
+        plan.distinct.emplace(strings.GetView(i));
+        if (static_cast<int64_t>(plan.distinct.size()) >
+            options.max_dictionary_size) {
+          plan.too_many_distinct = true;
+          plan.distinct.clear();
+          break;
+        }
+      }
+    }
+  }
+  if (plans->empty()) {
+    return arrow::Status::Invalid("Nothing to cache: ", parquet_path,
+                                  " has no rows");
+  }
+
+  for (auto& plan : *plans) {
+    if (plan.kind == Kind::kString && !plan.too_many_distinct) {
+      plan.kind = Kind::kDictionary;
+      // std::set iterates in order, so codes compare like the strings
+      plan.dictionary.assign(plan.distinct.begin(), plan.distinct.end());
+      plan.distinct.clear();
+      for (size_t code = 0; code < plan.dictionary.size(); code++) {
+        plan.codes.emplace(plan.dictionary[code], static_cast<int32_t>(code));
+      }
+    }
+  }
+  return arrow::Status::OK();
+}
+
+template <typename T>
+void WriteRange(const T* values, int64_t n, DirectoryWriter* directory) {
+  int64_t min = 0, max = 0;
+  if (n > 0) {
+    auto range = std::minmax_element(values, values + n);
+    min = *range.first;
+    max = *range.second;
+  }
+  directory->Value(min);
+  directory->Value(max);
+}
+
+// Writes one column of a block and its directory entry: values, data and
+// the zone map.
+arrow::Status WriteChunk(const arrow::Array& array, const ColumnPlan& plan,
+                         BufferWriter* out, DirectoryWriter* directory) {
+  int64_t n = array.length();
+  std::pair<uint64_t, uint64_t> values{0, 0}, data{0, 0};
+  const int32_t* int32_values = nullptr;
+  const int64_t* int64_values = nullptr;
+  std::vector<int32_t> converted;
+  switch (plan.kind) {
+    case Kind::kInt32:
+    case Kind::kDate32:
+      int32_values = array.data()->GetValues<int32_t>(1);
+      values = out->Buffer(int32_values, n * sizeof(int32_t));
+      break;
+    case Kind::kInt64:
+      int64_values = array.data()->GetValues<int64_t>(1);
+      values = out->Buffer(int64_values, n * sizeof(int64_t));
+      break;
+    case Kind::kDecimal128:
+      values = out->Buffer(
+          static_cast<const arrow::Decimal128Array&>(array).raw_values(),
+          n * arrow::Decimal128Type::kByteWidth);
+      break;
+    case Kind::kString: {
+      const auto& strings = static_cast<const arrow::StringArray&>(array);
+      converted = RebasedOffsets(strings);
+      values = out->Buffer(converted.data(), converted.size() * sizeof(int32_t));
+      // Arrow may leave the data buffer out when every string is empty
+      const uint8_t* bytes =
+          strings.value_data()
+              ? strings.value_data()->data() + strings.value_offset(0)
+              : nullptr;
+      data = out->Buffer(bytes, converted.back());
+      break;
+    }
+    case Kind::kDictionary: {
+      const auto& strings = static_cast<const arrow::StringArray&>(array);
+      converted.resize(n);
+      for (int64_t i = 0; i < n; i++) {
+        auto it = plan.codes.find(strings.GetView(i));
+        if (it == plan.codes.end()) {
+          return arrow::Status::Invalid("Column ", plan.name,
+                                        " changed between the two passes");
+        }
+        converted[i] = it->second;
+      }
+      values = out->Buffer(converted.data(), n * sizeof(int32_t));
+      break;
+    }
+  }
+  directory->Value(values.first);
+  directory->Value(values.second);
+  directory->Value(data.first);
+  directory->Value(data.second);
+  if (int32_values) {
+    WriteRange(int32_values, n, directory);
+  } else if (int64_values) {
+    WriteRange(int64_values, n, directory);
+  } else {
+    WriteRange<int64_t>(nullptr, 0, directory);
+  }
+  return arrow::Status::OK();
+}
+
+// Everything after the header: dictionaries, blocks, directory and footer
+arrow::Status WriteBuffers(const std::string& parquet_path,
+                           const ScanOptions& scan_options,
+                           const std::vector<ColumnPlan>& plans,
+                           BufferWriter* out) {
+  out->Write(kMagic, sizeof(kMagic));
+
+  DirectoryWriter directory;
+  directory.Value(kFormatVersion);
+  size_t num_rows_at = directory.bytes().size();
+  directory.Value(int64_t{0});  // patched below
+  directory.Value(static_cast<uint32_t>(plans.size()));
+  for (const auto& plan : plans) {
+    std::pair<uint64_t, uint64_t> offsets{0, 0}, data{0, 0};
+    if (plan.kind == Kind::kDictionary) {
+      std::vector<int32_t> entry_offsets = {0};
+      std::string bytes;
+      for (const auto& entry : plan.dictionary) {
+        bytes += entry;
+        entry_offsets.push_back(static_cast<int32_t>(bytes.size()));
+      }
+      offsets = out->Buffer(entry_offsets.data(),
+                           entry_offsets.size() * sizeof(int32_t));
+      data = out->Buffer(bytes.data(), bytes.size());
+    }
+    directory.String(plan.name);
+    directory.Value(plan.kind);
+    directory.Value(plan.precision);
+    directory.Value(plan.scale);
+    directory.Value(offsets.first);
+    directory.Value(offsets.second);
+    directory.Value(data.first);
+    directory.Value(data.second);
+    directory.Value(static_cast<uint64_t>(plan.dictionary.size()));
+  }
+
+  // Blocks are the batches of a second scan
+  DirectoryWriter blocks;
+  uint32_t num_blocks = 0;
+  int64_t num_rows = 0;
+  std::unique_ptr<ParquetScanner> scanner;
+  ARROW_ASSIGN_OR_RAISE(scanner,
+                        ParquetScanner::Open(parquet_path, scan_options));
+  while (out->status().ok()) {
+    std::shared_ptr<arrow::RecordBatch> batch;
+    ARROW_ASSIGN_OR_RAISE(batch, scanner->Next());
+    if (!batch) {
+      break;
+    }
+    blocks.Value(batch->num_rows());
+    for (int c = 0; c < batch->num_columns(); c++) {
+      ARROW_RETURN_NOT_OK(
+          WriteChunk(*batch->column(c), plans[c], out, &blocks));
+    }
+    num_blocks++;
+    num_rows += batch->num_rows();
+  }
+  directory.Value(num_blocks);
+
+  std::string directory_bytes = directory.bytes() + blocks.bytes();
+  std::memcpy(&directory_bytes[num_rows_at], &num_rows, sizeof(num_rows));
+  uint64_t directory_offset = out->position();
+  uint64_t directory_size = directory_bytes.size();
+  out->Write(directory_bytes.data(), directory_bytes.size());
+  out->Write(&directory_offset, sizeof(directory_offset));
+  out->Write(&directory_size, sizeof(directory_size));
+  out->Write(kEndMagic, sizeof(kEndMagic));
+
+  return out->status();
+}
+
+}  // namespace
+
+arrow::Result<bool> ColumnCache::IsCacheFile(
+    arrow::io::RandomAccessFile* file) {
+  ARROW_ASSIGN_OR_RAISE(int64_t size, file->GetSize());
+  if (size < static_cast<int64_t>(sizeof(kMagic))) {
+    return false;
+  }
+  char magic[sizeof(kMagic)];
+  ARROW_ASSIGN_OR_RAISE(int64_t read, file->ReadAt(0, sizeof(magic), magic));
+  return read == static_cast<int64_t>(sizeof(magic)) &&
+         std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+arrow::Result<std::shared_ptr<ColumnCache>> ColumnCache::Open(
+    const std::string& file_path) {
+  std::shared_ptr<ColumnCache> cache(new ColumnCache());
+  ARROW_ASSIGN_OR_RAISE(cache->file_, arrow::io::MemoryMappedFile::Open(
+                                          file_path, arrow::io::FileMode::READ));
+  ARROW_ASSIGN_OR_RAISE(int64_t size, cache->file_->GetSize());
+  ARROW_ASSIGN_OR_RAISE(cache->mapping_, cache->file_->ReadAt(0, size));
+  const uint8_t* bytes = cache->mapping_->data();
+  auto corrupt = [&file_path](const char* what) {
+    return arrow::Status::IOError("Invalid column cache ", file_path, ": ",
+                                  what);
+  };
+
+  if (size < static_cast<int64_t>(sizeof(kMagic) + kFooterSize) ||
+      std::memcmp(bytes, kMagic, sizeof(kMagic)) != 0) {
+    return corrupt("no header");
+  }
+  DirectoryReader footer(bytes + size - kFooterSize, kFooterSize);
+  uint64_t directory_offset, directory_size;
+  char end_magic[sizeof(kEndMagic)];
+  footer.Value(&directory_offset);
+  footer.Value(&directory_size);
+  footer.Value(&end_magic);
+  uint64_t buffers_end = static_cast<uint64_t>(size) - kFooterSize;
+  if (std::memcmp(end_magic, kEndMagic, sizeof(kEndMagic)) != 0 ||
+      directory_offset > buffers_end ||
+      directory_size != buffers_end - directory_offset) {
+    return corrupt("truncated or incomplete");
+  }
+
+  // A buffer must lie in the buffer area, aligned, with the expected size
+  auto valid = [&](const BufferRef& ref, uint64_t expected) {
+    return ref.offset % kAlignment == 0 && ref.size == expected &&
+           ref.offset <= directory_offset &&
+           ref.size <= directory_offset - ref.offset;
+  };
+  auto offsets_end = [&](const BufferRef& ref, int64_t count) {
+    int32_t end;
+    std::memcpy(&end, bytes + ref.offset + count * sizeof(int32_t),
+                sizeof(end));
+    return static_cast<uint64_t>(end);
+  };
+
+  DirectoryReader directory(bytes + directory_offset, directory_size);
+  uint32_t version, num_columns, num_blocks;
+  if (!directory.Value(&version) || version != kFormatVersion) {
+    return corrupt("other format version");
+  }
+  if (!directory.Value(&cache->num_rows_) || !directory.Value(&num_columns)) {
+    return corrupt("bad directory");
+  }
+  for (uint32_t c = 0; c < num_columns; c++) {
+    Column column;
+    BufferRef offsets, data;
+    uint64_t dictionary_size;
+    if (!directory.String(&column.name) || !directory.Value(&column.kind) ||
+        !directory.Value(&column.precision) ||
+        !directory.Value(&column.scale) || !directory.Value(&offsets) ||
+        !directory.Value(&data) || !directory.Value(&dictionary_size) ||
+        column.kind < Kind::kInt32 || column.kind > Kind::kDictionary) {
+      return corrupt("bad column");
+    }
+    if (column.kind == Kind::kDictionary) {
+      if (dictionary_size > INT32_MAX ||
+          !valid(offsets, (dictionary_size + 1) * sizeof(int32_t)) ||
+          !valid(data, offsets_end(offsets, dictionary_size)) ||
+          !ValidOffsets(reinterpret_cast<const int32_t*>(bytes + offsets.offset),
+                        dictionary_size, data.size)) {
+        return corrupt("bad dictionary");
+      }
+      column.dictionary = std::make_shared<arrow::StringArray>(
+          dictionary_size, cache->Slice(offsets), cache->Slice(data));
+    }
+    cache->columns_.push_back(std::move(column));
+  }
+
+  if (!directory.Value(&num_blocks)) {
+    return corrupt("bad directory");
+  }
+  int64_t rows = 0;
+  for (uint32_t b = 0; b < num_blocks; b++) {
+    Block block;
+    if (!directory.Value(&block.num_rows) || block.num_rows < 0) {
+      return corrupt("bad block");
+    }
+    for (const auto& column : cache->columns_) {
+      Chunk chunk;
+      if (!directory.Value(&chunk.values) || !directory.Value(&chunk.data) ||
+          !directory.Value(&chunk.min) || !directory.Value(&chunk.max)) {
+        return corrupt("bad block");
+      }
+      int64_t count = block.num_rows + (column.kind == Kind::kString ? 1 : 0);
+      if (!valid(chunk.values, count * ValueWidth(column.kind)) ||
+          (column.kind == Kind::kString &&
+           !valid(chunk.data, offsets_end(chunk.values, block.num_rows)))) {
+        return corrupt("bad block");
+      }
+      block.chunks.push_back(chunk);
+    }
+    rows += block.num_rows;
+    cache->blocks_.push_back(std::move(block));
+  }
+  if (!directory.AtEnd() || rows != cache->num_rows_) {
+    return corrupt("bad directory");
+  }
+  cache->validated_ = std::vector<std::atomic<bool>>(
+      cache->blocks_.size() * cache->columns_.size());
+  cache->file_path_ = file_path;
+  return cache;
+}
+
+int ColumnCache::ColumnIndex(const std::string& name) const {
+  for (int i = 0; i < num_columns(); i++) {
+    if (columns_[i].name == name) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool ColumnCache::BlockRange(int block, int column, int64_t* min,
+                             int64_t* max) const {
+  Kind kind = columns_[column].kind;
+  if (kind != Kind::kInt32 && kind != Kind::kDate32 && kind != Kind::kInt64) {
+    return false;
+  }
+  const Chunk& chunk = blocks_[block].chunks[column];
+  *min = chunk.min;
+  *max = chunk.max;
+  return true;
+}
+
+std::vector<arrow::io::ReadRange> ColumnCache::ColumnBytes(int block,
+                                                           int column) const {
+  const Chunk& chunk = blocks_[block].chunks[column];
+  std::vector<arrow::io::ReadRange> ranges = {
+      {static_cast<int64_t>(chunk.values.offset),
+       static_cast<int64_t>(chunk.values.size)}};
+  if (chunk.data.size > 0) {
+    ranges.push_back({static_cast<int64_t>(chunk.data.offset),
+                      static_cast<int64_t>(chunk.data.size)});
+  }
+  return ranges;
+}
+
+std::shared_ptr<arrow::Buffer> ColumnCache::Slice(const BufferRef& ref) const {
+  return arrow::SliceBuffer(mapping_, static_cast<int64_t>(ref.offset),
+                            static_cast<int64_t>(ref.size));
+}
+
+arrow::Status ColumnCache::ValidateChunk(int block, int column) const {
+  std::atomic<bool>& validated = validated_[block * columns_.size() + column];
+  if (validated.load(std::memory_order_acquire)) {
+    return arrow::Status::OK();
+  }
+  const Column& info = columns_[column];
+  const Chunk& chunk = blocks_[block].chunks[column];
+  int64_t n = blocks_[block].num_rows;
+  const auto* values =
+      reinterpret_cast<const int32_t*>(mapping_->data() + chunk.values.offset);
+  bool ok = true;
+  if (info.kind == Kind::kString) {
+    ok = ValidOffsets(values, n, chunk.data.size);
+  } else if (info.kind == Kind::kDictionary) {
+    auto size = static_cast<uint32_t>(info.dictionary->length());
+    for (int64_t i = 0; i < n; i++) {
+      ok &= static_cast<uint32_t>(values[i]) < size;
+    }
+  }
+  if (!ok) {
+    return arrow::Status::IOError("Invalid column cache ", file_path_,
+                                  ": bad ", info.name, " in block ", block);
+  }
+  // Racing first reads both check; either result is the same
+  validated.store(true, std::memory_order_release);
+  return arrow::Status::OK();
+}
+
+arrow::Result<std::shared_ptr<arrow::Array>> ColumnCache::ReadColumn(
+    int block, int column, bool as_dictionary) const {
+  ARROW_RETURN_NOT_OK(ValidateChunk(block, column));
+  const Column& info = columns_[column];
+  const Chunk& chunk = blocks_[block].chunks[column];
+  int64_t n = blocks_[block].num_rows;
+  auto type = ArrowType(info, as_dictionary);
+  if (info.kind == Kind::kString && as_dictionary) {
+    // Encoded on the fly, in order of first appearance
+    arrow::StringArray strings(n, Slice(chunk.values), Slice(chunk.data));
+    arrow::StringBuilder dictionary;
+    std::unordered_map<std::string_view, int32_t> codes;
+    ARROW_ASSIGN_OR_RAISE(auto indices,
+                          arrow::AllocateBuffer(n * sizeof(int32_t)));
+    auto* out = reinterpret_cast<int32_t*>(indices->mutable_data());
+    for (int64_t i = 0; i < n; i++) {
+      auto inserted = codes.emplace(strings.GetView(i),
+                                    static_cast<int32_t>(codes.size()));
+      if (inserted.second) {
+        ARROW_RETURN_NOT_OK(dictionary.Append(strings.GetView(i)));
+      }
+      out[i] = inserted.first->second;
+    }
+    std::shared_ptr<arrow::Array> entries;
+    ARROW_RETURN_NOT_OK(dictionary.Finish(&entries));
+    auto data = arrow::ArrayData::Make(
+        type, n, {nullptr, std::shared_ptr<arrow::Buffer>(std::move(indices))},
+        0);
+    data->dictionary = entries->data();
+    return arrow::MakeArray(data);
+  }
+  if (info.kind == Kind::kDictionary && !as_dictionary) {
+    // Materialized for callers that want plain strings
+    const auto& entries =
+        static_cast<const arrow::StringArray&>(*info.dictionary);
+    const auto* codes =
+        reinterpret_cast<const int32_t*>(mapping_->data() + chunk.values.offset);
+    arrow::StringBuilder strings;
+    ARROW_RETURN_NOT_OK(strings.Reserve(n));
+    for (int64_t i = 0; i < n; i++) {
+      ARROW_RETURN_NOT_OK(strings.Append(entries.GetView(codes[i])));
+    }
+    std::shared_ptr<arrow::Array> array;
+    ARROW_RETURN_NOT_OK(strings.Finish(&array));
+    return array;
+  }
+
+  std::vector<std::shared_ptr<arrow::Buffer>> buffers = {nullptr,
+                                                        Slice(chunk.values)};
+  if (info.kind == Kind::kString) {
+    buffers.push_back(Slice(chunk.data));
+  }
+  auto data = arrow::ArrayData::Make(type, n, std::move(buffers), 0);
+  if (info.kind == Kind::kDictionary) {
+    data->dictionary = info.dictionary->data();
+  }
+  return arrow::MakeArray(data);
+}
+
+arrow::Result<std::shared_ptr<arrow::RecordBatch>> ColumnCache::ReadBlock(
+    int block, const std::vector<int>& columns,
+    const std::vector<bool>& as_dictionary) const {
+  std::vector<std::shared_ptr<arrow::Field>> fields;
+  std::vector<std::shared_ptr<arrow::Array>> arrays;
+  for (size_t i = 0; i < columns.size(); i++) {
+    std::shared_ptr<arrow::Array> array;
+    ARROW_ASSIGN_OR_RAISE(array,
+                          ReadColumn(block, columns[i], as_dictionary[i]));
+    fields.push_back(arrow::field(columns_[columns[i]].name, array->type(),
+                                  /*nullable=*/false));
+    arrays.push_back(std::move(array));
+  }
+  return arrow::RecordBatch::Make(arrow::schema(std::move(fields)),
+                                  blocks_[block].num_rows, std::move(arrays));
+}
+
+arrow::Status WriteColumnCache(const std::string& parquet_path,
+                               const std::string& cache_path,
+                               const ColumnCacheOptions& options) {
+  if (options.block_rows < 1 || options.block_rows > INT32_MAX) {
+    return arrow::Status::Invalid("Block rows must be in [1, 2^31)");
+  }
+  ScanOptions scan_options;
+  scan_options.columns = options.columns;
+  scan_options.batch_size = options.block_rows;
+  scan_options.input = options.input;
+  std::vector<ColumnPlan> plans;
+  ARROW_RETURN_NOT_OK(
+      PlanColumns(parquet_path, scan_options, options, &plans));
+
+  std::string temp_path = cache_path + ".tmp" + std::to_string(getpid());
+  std::shared_ptr<arrow::io::FileOutputStream> file;
+  ARROW_ASSIGN_OR_RAISE(file, arrow::io::FileOutputStream::Open(temp_path));
+  BufferWriter out(file.get());
+  arrow::Status st = WriteBuffers(parquet_path, scan_options, plans, &out);
+  arrow::Status close_st = file->Close();
+  if (st.ok()) {
+    st = close_st;
+  }
+  if (st.ok() && std::rename(temp_path.c_str(), cache_path.c_str()) != 0) {
+    st = arrow::Status::IOError("Cannot rename ", temp_path, " to ",
+                                cache_path, ": ", std::strerror(errno));
+  }
+  if (!st.ok()) {
+    std::remove(temp_path.c_str());
+  }
+  return st;
+}
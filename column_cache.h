@@ -0,0 +1,156 @@
+// Native columnar cache of a Parquet file, for inputs that are scanned over
+// and over. parquet_to_cache writes it; ParquetScanner reads it wherever a
+// Parquet file is accepted, so every rvv_query binary and the server take
+// either. Parquet stays the interchange format.
+//
+// Columns are stored decoded, in the Arrow in-memory layout, in blocks of at
+// most block_rows rows:
+//
+//   int32, date32, int64   the values
+//   decimal128             16-byte little-endian unscaled integers
+//   string                 int32 offsets from 0 plus the bytes
+//   dictionary             int32 codes into one sorted dictionary per
+//                          file, for low-cardinality strings (flags, modes)
+//
+// Every buffer starts on a 64-byte boundary. The scan maps the file and
+// hands out Arrow arrays over the mapping, so a row group costs no
+// decompression, no decoding and no copy: the kernels load straight from the
+// page cache. Each block keeps min/max per integer and date column (zone
+// maps), which prune blocks as Parquet statistics prune row groups.
+//
+// File layout: kMagic, the buffers, the directory (columns, then blocks with
+// their buffer locations and zone maps), its offset and size, kEndMagic. The
+// file holds raw host-endian memory, so it is only meant for little-endian
+// hosts, and it has no nulls: the converter rejects columns that have any.
+#pragma once
+
+#include <arrow/array.h>
+#include <arrow/io/file.h>
+#include <arrow/io/interfaces.h>
+#include <arrow/record_batch.h>
+#include <arrow/result.h>
+#include <arrow/status.h>
+
+#include "parquet_scan.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ColumnCache {
+ public:
+  enum class Kind : int32_t {
+    kInt32,
+    kDate32,
+    kInt64,
+    kDecimal128,
+    kString,
+    kDictionary,
+  };
+
+  struct Column {
+    std::string name;
+    Kind kind;
+    // Of decimal128 columns
+    int32_t precision = 0;
+    int32_t scale = 0;
+    // Of dictionary columns: a StringArray over the mapping
+    std::shared_ptr<arrow::Array> dictionary;
+  };
+
+  // Whether file starts like a cache file, as opposed to e.g. Parquet.
+  static arrow::Result<bool> IsCacheFile(arrow::io::RandomAccessFile* file);
+
+  // Maps file_path and parses its directory. Buffer bounds and the
+  // dictionaries are checked here; the string offsets and dictionary codes
+  // of a block when it is first read (ReadBlock), so a bad file is an error
+  // rather than an out-of-bounds read either way.
+  static arrow::Result<std::shared_ptr<ColumnCache>> Open(
+      const std::string& file_path);
+
+  int num_columns() const { return static_cast<int>(columns_.size()); }
+  const Column& column(int i) const { return columns_[i]; }
+  // -1 if there is no such column
+  int ColumnIndex(const std::string& name) const;
+
+  int num_blocks() const { return static_cast<int>(blocks_.size()); }
+  int64_t num_rows() const { return num_rows_; }
+  int64_t block_rows(int block) const { return blocks_[block].num_rows; }
+
+  // Zone map of a column in a block; false unless it is an int32, date32
+  // or int64 column.
+  bool BlockRange(int block, int column, int64_t* min, int64_t* max) const;
+
+  // File bytes of a column in a block, e.g. for WillNeed().
+  std::vector<arrow::io::ReadRange> ColumnBytes(int block, int column) const;
+
+  // The columns of a block, in the order given, as arrays over the mapping.
+  // A column with as_dictionary set comes as a DictionaryArray (int32
+  // indices into a StringArray), otherwise as the type it had in Parquet;
+  // only these conversions between string and dictionary columns copy.
+  arrow::Result<std::shared_ptr<arrow::RecordBatch>> ReadBlock(
+      int block, const std::vector<int>& columns,
+      const std::vector<bool>& as_dictionary) const;
+
+  // The mapped file, for WillNeed().
+  const std::shared_ptr<arrow::io::MemoryMappedFile>& file() const {
+    return file_;
+  }
+
+ private:
+  struct BufferRef {
+    uint64_t offset = 0;
+    uint64_t size = 0;
+  };
+
+  struct Chunk {
+    BufferRef values;
+    BufferRef data;  // string bytes
+    int64_t min = 0;
+    int64_t max = 0;
+  };
+
+  struct Block {
+    int64_t num_rows = 0;
+    std::vector<Chunk> chunks;  // one per column
+  };
+
+  ColumnCache() = default;
+
+  std::shared_ptr<arrow::Buffer> Slice(const BufferRef& ref) const;
+
+  // Checks the offsets or codes of a chunk, once.
+  arrow::Status ValidateChunk(int block, int column) const;
+
+  arrow::Result<std::shared_ptr<arrow::Array>> ReadColumn(
+      int block, int column, bool as_dictionary) const;
+
+  std::shared_ptr<arrow::io::MemoryMappedFile> file_;
+  std::shared_ptr<arrow::Buffer> mapping_;
+  std::vector<Column> columns_;
+  std::vector<Block> blocks_;
+  int64_t num_rows_ = 0;
+  std::string file_path_;
+  // Per block and column, whether ValidateChunk() passed
+  mutable std::vector<std::atomic<bool>> validated_;
+};
+
+struct ColumnCacheOptions {
+  // Columns to store; empty stores every column.
+  std::vector<std::string> columns;
+  // Blocks never span Parquet row groups, so they may be shorter.
+  int64_t block_rows = kDefaultScanBatchSize;
+  // String columns with at most this many distinct values over the file
+  // are dictionary-coded.
+  int64_t max_dictionary_size = 1024;
+  InputOptions input;
+};
+
+// Converts parquet_path into a cache at cache_path. The Parquet file is read
+// twice: once to find the dictionary columns, once to write the blocks. The
+// cache is written under a temporary name and renamed.
+arrow::Status WriteColumnCache(const std::string& parquet_path,
+                               const std::string& cache_path,
+                               const ColumnCacheOptions& options);
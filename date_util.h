@@ -0,0 +1,62 @@
+// Calendar arithmetic on date32 values (days since 1970-01-01), proleptic
+// Gregorian and timezone-free. Everything is constexpr, so predicate
+// constants such as date_literal("1994-01-01") are compile-time values;
+// rvv::date32_to_year is the vector form of year_from_days.
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+
+// Days since 1970-01-01 of year-month-day (H. Hinnant's days_from_civil).
+constexpr int32_t days_from_civil(int32_t year, int32_t month, int32_t day) {
+  year -= month <= 2;
+  const int32_t era = (year >= 0 ? year : year - 399) / 400;
+  const int32_t yoe = year - era * 400;                                // [0, 399]
+  const int32_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  const int32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;           // [0, 146096]
+  return era * 146097 + doe - 719468;
+}
+
+// Calendar year of a date32 value (civil_from_days, year part only).
+constexpr int32_t year_from_days(int32_t days) {
+  const int32_t z = days + 719468;
+  const int32_t era = (z >= 0 ? z : z - 146096) / 146097;
+  const int32_t doe = z - era * 146097;
+  const int32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const int32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  // The era year starts in March; January and February (doy >= 306) belong
+  // to the next calendar year
+  return yoe + era * 400 + (doy >= 306);
+}
+
+namespace date_detail {
+
+constexpr int32_t digits(const char* s, int count) {
+  int32_t value = 0;
+  for (int i = 0; i < count; i++) {
+    if (s[i] < '0' || s[i] > '9') {
+      throw std::invalid_argument("date literal must be YYYY-MM-DD");
+    }
+    value = value * 10 + (s[i] - '0');
+  }
+  return value;
+}
+
+}  // namespace date_detail
+
+// date32 value of an ISO "YYYY-MM-DD" literal. In a constant expression a
+// malformed literal is a compile error.
+constexpr int32_t date_literal(const char* iso) {
+  if (iso[4] != '-' || iso[7] != '-' || iso[10] != '\0') {
+    throw std::invalid_argument("date literal must be YYYY-MM-DD");
+  }
+  return days_from_civil(date_detail::digits(iso, 4),
+                         date_detail::digits(iso + 5, 2),
+                         date_detail::digits(iso + 8, 2));
+}
+
+static_assert(date_literal("1970-01-01") == 0, "epoch");
+static_assert(date_literal("1998-09-02") == 10471, "TPC-H Q1 cutoff");
+static_assert(year_from_days(date_literal("1992-01-01")) == 1992, "Jan 1");
+static_assert(year_from_days(date_literal("1996-12-31")) == 1996, "Dec 31");
+static_assert(year_from_days(-1) == 1969, "before the epoch");
@@ -0,0 +1,50 @@
+#include "dense_group_by.h"
+
+#include "rvv_kernels.h"
+
+DenseGroupBy::DenseGroupBy(int32_t num_codes) : slots_(num_codes, -1) {}
+
+void DenseGroupBy::Assign(const int32_t* codes, int32_t* ids, size_t n) {
+  if (rvv::gather_int32(slots_.data(), codes, ids, n) == 0) {
+    return;
+  }
+  // New groups only turn up in the first few batches
+  for (size_t i = 0; i < n; i++) {
+    if (ids[i] >= 0) {
+      continue;
+    }
+    int32_t& slot = slots_[codes[i]];
+    if (slot < 0) {
+      slot = static_cast<int32_t>(codes_.size());
+      codes_.push_back(codes[i]);
+    }
+    ids[i] = slot;
+  }
+}
+
+DenseGroupSums::DenseGroupSums(size_t num_groups)
+    : num_groups_(num_groups),
+      lanes_(rvv::group_sum_lanes()),
+      lane_sums_(num_groups * lanes_, 0.0),
+      lane_counts_(num_groups * lanes_, 0) {}
+
+void DenseGroupSums::Add(const int32_t* group_ids, const float* values,
+                         size_t n) {
+  rvv::group_sum(group_ids, values, n, lane_sums_.data(), lane_counts_.data());
+}
+
+double DenseGroupSums::sum(size_t group) const {
+  double total = 0.0;
+  for (size_t lane = 0; lane < lanes_; lane++) {
+    total += lane_sums_[group * lanes_ + lane];
+  }
+  return total;
+}
+
+int64_t DenseGroupSums::count(size_t group) const {
+  int64_t total = 0;
+  for (size_t lane = 0; lane < lanes_; lane++) {
+    total += lane_counts_[group * lanes_ + lane];
+  }
+  return total;
+}
@@ -0,0 +1,51 @@
+// Dense group ids for small-cardinality group-by.
+//
+// Keys that pack into a small integer code (e.g. two single-character
+// strings, see rvv::char_pair_codes) are mapped to group ids 0, 1, ... in
+// order of first appearance through a flat code -> id table, probed with a
+// vector gather. Aggregation kernels then keep one accumulator per group id
+// in a plain array instead of a node-based map; DenseGroupSums is such an
+// aggregation for ids computed directly from the keys.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class DenseGroupBy {
+ public:
+  // Codes must lie in [0, num_codes).
+  explicit DenseGroupBy(int32_t num_codes = 1 << 16);
+
+  // Writes the group id of codes[i] to ids[i], registering unseen codes.
+  void Assign(const int32_t* codes, int32_t* ids, size_t n);
+
+  size_t num_groups() const { return codes_.size(); }
+  int32_t code(size_t group) const { return codes_[group]; }
+
+ private:
+  std::vector<int32_t> slots_;  // code -> group id, -1 if unseen
+  std::vector<int32_t> codes_;  // group id -> code
+};
+
+// SUM(value) and COUNT(*) per group id in [0, num_groups), for ids computed
+// arithmetically from small keys (e.g. nation * 8 + (year - 1992), see
+// rvv::linear_group_ids). Add() is a vector scatter-add into per-lane
+// accumulators (rvv::group_sum); lanes are only reduced when read.
+class DenseGroupSums {
+ public:
+  explicit DenseGroupSums(size_t num_groups);
+
+  // Group ids must lie in [0, num_groups).
+  void Add(const int32_t* group_ids, const float* values, size_t n);
+
+  size_t num_groups() const { return num_groups_; }
+  double sum(size_t group) const;
+  int64_t count(size_t group) const;
+
+ private:
+  size_t num_groups_;
+  size_t lanes_;
+  std::vector<double> lane_sums_;    // group * lanes_ + lane
+  std::vector<int64_t> lane_counts_;
+};
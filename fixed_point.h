@@ -0,0 +1,53 @@
+// Formatting helpers for exact fixed-point (scaled integer) results.
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+using Int128 = __int128;
+
+inline Int128 pow10_int128(int exponent) {
+  Int128 result = 1;
+  for (int i = 0; i < exponent; i++) {
+    result *= 10;
+  }
+  return result;
+}
+
+// Formats (value / 10^scale) / divisor with `digits` decimals, rounding half
+// away from zero. Used for SUM (divisor 1) and AVG (divisor = count).
+inline std::string format_fixed(Int128 value, int scale, int digits,
+                                int64_t divisor = 1) {
+  Int128 num = value;
+  Int128 den = divisor;
+  if (digits >= scale) {
+    num *= pow10_int128(digits - scale);
+  } else {
+    den *= pow10_int128(scale - digits);
+  }
+  bool negative = (num < 0) != (den < 0);
+  if (num < 0) num = -num;
+  if (den < 0) den = -den;
+  Int128 q = (num + den / 2) / den;
+
+  Int128 unit = pow10_int128(digits);
+  Int128 int_part = q / unit;
+  Int128 frac_part = q % unit;
+
+  std::string int_str;
+  do {
+    int_str.insert(int_str.begin(), static_cast<char>('0' + int_part % 10));
+    int_part /= 10;
+  } while (int_part != 0);
+
+  std::string result = (negative && q != 0) ? "-" + int_str : int_str;
+  if (digits > 0) {
+    std::string frac_str(digits, '0');
+    for (int i = digits - 1; i >= 0; i--) {
+      frac_str[i] = static_cast<char>('0' + frac_part % 10);
+      frac_part /= 10;
+    }
+    result += "." + frac_str;
+  }
+  return result;
+}
@@ -0,0 +1,243 @@
+// Flat open-addressing hash tables for join build sides.
+//
+// Keys live in one contiguous array probed linearly, values in a parallel
+// array (absent for FlatHashSet). Capacity is a power of two kept at least
+// twice the size; pass the build row count to the constructor or Reserve()
+// so a build does not rehash on the way. One key value (FlatKeyTraits::
+// empty()) marks free slots; it is still a valid key, kept out of line.
+//
+// Probe() looks up a whole vector of keys: it hashes a block of them and
+// prefetches their home slots before comparing any, so the cache misses of
+// a block overlap instead of serializing.
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Composite join key, e.g. (ps_partkey, ps_suppkey)
+struct Int64Pair {
+  int64_t first;
+  int64_t second;
+
+  bool operator==(const Int64Pair& other) const {
+    return first == other.first && second == other.second;
+  }
+};
+
+// Finalizer of MurmurHash3; spreads sequential keys over all bits.
+inline uint64_t mix_hash64(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+template <typename Key>
+struct FlatKeyTraits;
+
+template <>
+struct FlatKeyTraits<int64_t> {
+  static constexpr int64_t empty() {
+    return std::numeric_limits<int64_t>::min();
+  }
+  static uint64_t hash(int64_t key) {
+    return mix_hash64(static_cast<uint64_t>(key));
+  }
+};
+
+template <>
+struct FlatKeyTraits<Int64Pair> {
+  static constexpr Int64Pair empty() {
+    return {std::numeric_limits<int64_t>::min(),
+            std::numeric_limits<int64_t>::min()};
+  }
+  static uint64_t hash(const Int64Pair& key) {
+    return mix_hash64(mix_hash64(static_cast<uint64_t>(key.first)) ^
+                      static_cast<uint64_t>(key.second));
+  }
+};
+
+// Value type of FlatHashSet; takes no storage.
+struct FlatEmpty {};
+
+template <typename Key, typename Value>
+class FlatHashMap {
+  // Values are handed out by pointer, which std::vector<bool> cannot do
+  static_assert(!std::is_same<Value, bool>::value, "use uint8_t for flags");
+
+ public:
+  using Traits = FlatKeyTraits<Key>;
+
+  explicit FlatHashMap(size_t expected_size = 0) {
+    Rehash(CapacityFor(expected_size));
+  }
+
+  // Grows the table so that expected_size keys fit without rehashing.
+  void Reserve(size_t expected_size) {
+    size_t capacity = CapacityFor(expected_size);
+    if (capacity > mask_ + 1) {
+      Rehash(capacity);
+    }
+  }
+
+  // Value of key, default-constructed if key was not present, and whether
+  // it was inserted. The pointer is invalidated by the next insertion.
+  std::pair<Value*, bool> Insert(const Key& key) {
+    if (key == Traits::empty()) {
+      bool inserted = !has_empty_key_;
+      if (inserted) {
+        has_empty_key_ = true;
+        size_++;
+      }
+      return {value_at(mask_ + 1), inserted};
+    }
+    if ((size_ + 1) * 2 > mask_ + 1) {
+      Rehash((mask_ + 1) * 2);
+    }
+    for (size_t slot = Traits::hash(key) & mask_;; slot = (slot + 1) & mask_) {
+      if (keys_[slot] == key) {
+        return {value_at(slot), false};
+      }
+      if (keys_[slot] == Traits::empty()) {
+        keys_[slot] = key;
+        size_++;
+        return {value_at(slot), true};
+      }
+    }
+  }
+
+  Value& operator[](const Key& key) { return *Insert(key).first; }
+
+  // Value of key, or nullptr if absent.
+  const Value* Find(const Key& key) const {
+    return FindFrom(key, Traits::hash(key) & mask_);
+  }
+
+  bool Contains(const Key& key) const { return Find(key) != nullptr; }
+
+  // out[i] = Find(keys[i]) for i < n.
+  void Probe(const Key* keys, size_t n, const Value** out) const {
+    size_t home[kProbeBlock];
+    for (size_t i = 0; i < n; i += kProbeBlock) {
+      size_t block = std::min(kProbeBlock, n - i);
+      for (size_t j = 0; j < block; j++) {
+        home[j] = Traits::hash(keys[i + j]) & mask_;
+        __builtin_prefetch(&keys_[home[j]]);
+        if constexpr (!kEmptyValue) {
+          __builtin_prefetch(&values_[home[j]]);
+        }
+      }
+      for (size_t j = 0; j < block; j++) {
+        out[i + j] = FindFrom(keys[i + j], home[j]);
+      }
+    }
+  }
+
+  size_t size() const { return size_; }
+
+  // Raw table for JoinCache (join_cache.h); Key and Value must be trivially
+  // copyable. Load() rejects a table that is not consistent.
+  template <typename Writer>
+  void Save(Writer& out) const {
+    out.Array(keys_);
+    out.Array(values_);
+    out.Value(size_);
+    out.Value(has_empty_key_);
+  }
+  template <typename Reader>
+  bool Load(Reader& in) {
+    if (!in.Array(&keys_) || !in.Array(&values_) || !in.Value(&size_) ||
+        !in.Value(&has_empty_key_)) {
+      return false;
+    }
+    size_t capacity = keys_.size();
+    mask_ = capacity - 1;
+    return capacity >= 16 && (capacity & mask_) == 0 && size_ * 2 <= capacity &&
+           values_.size() == (kEmptyValue ? 0 : capacity + 1);
+  }
+
+ private:
+  static constexpr bool kEmptyValue = std::is_empty<Value>::value;
+  static constexpr size_t kProbeBlock = 16;
+
+  static size_t CapacityFor(size_t expected_size) {
+    size_t capacity = 16;
+    while (capacity < expected_size * 2) {
+      capacity *= 2;
+    }
+    return capacity;
+  }
+
+  const Value* FindFrom(const Key& key, size_t slot) const {
+    if (key == Traits::empty()) {
+      return has_empty_key_ ? value_at(mask_ + 1) : nullptr;
+    }
+    for (;; slot = (slot + 1) & mask_) {
+      if (keys_[slot] == key) {
+        return value_at(slot);
+      }
+      if (keys_[slot] == Traits::empty()) {
+        return nullptr;
+      }
+    }
+  }
+
+  // Slot mask_ + 1 holds the value of the empty key
+  Value* value_at(size_t slot) {
+    if constexpr (kEmptyValue) {
+      return &empty_value_;
+    } else {
+      return &values_[slot];
+    }
+  }
+  const Value* value_at(size_t slot) const {
+    return const_cast<FlatHashMap*>(this)->value_at(slot);
+  }
+
+  void Rehash(size_t capacity) {
+    std::vector<Key> old_keys(capacity, Traits::empty());
+    std::vector<Value> old_values;
+    if constexpr (!kEmptyValue) {
+      old_values.resize(capacity + 1);
+    }
+    // The fresh arrays swap in; the old contents are then reinserted
+    old_keys.swap(keys_);
+    old_values.swap(values_);
+    mask_ = capacity - 1;
+    if constexpr (!kEmptyValue) {
+      if (has_empty_key_) {
+        values_[capacity] = std::move(old_values.back());
+      }
+    }
+    for (size_t slot = 0; slot < old_keys.size(); slot++) {
+      if (old_keys[slot] == Traits::empty()) {
+        continue;
+      }
+      size_t to = Traits::hash(old_keys[slot]) & mask_;
+      while (!(keys_[to] == Traits::empty())) {
+        to = (to + 1) & mask_;
+      }
+      keys_[to] = old_keys[slot];
+      if constexpr (!kEmptyValue) {
+        values_[to] = std::move(old_values[slot]);
+      }
+    }
+  }
+
+  std::vector<Key> keys_;
+  std::vector<Value> values_;
+  size_t mask_ = 0;
+  size_t size_ = 0;
+  bool has_empty_key_ = false;
+  FlatEmpty empty_value_;
+};
+
+template <typename Key>
+using FlatHashSet = FlatHashMap<Key, FlatEmpty>;
@@ -0,0 +1,209 @@
+#include "join_cache.h"
+
+#include <arrow/buffer.h>
+#include <arrow/io/file.h>
+#include <arrow/result.h>
+
+#include "query_profile.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+namespace {
+
+// Bump when the layout of an entry or of a Save()d structure changes
+constexpr uint32_t kFormatVersion = 1;
+constexpr char kMagic[8] = {'J', 'O', 'I', 'N', 'C', 'A', 'C', 'H'};
+constexpr char kEndMagic[8] = {'J', 'O', 'I', 'N', 'D', 'O', 'N', 'E'};
+
+// Entry layout: kMagic, version, key text (length, bytes), the fields the
+// structures saved, their byte count and kEndMagic.
+constexpr size_t kFooterSize = sizeof(uint64_t) + sizeof(kEndMagic);
+
+// FNV-1a; only has to be stable on one machine
+uint64_t HashText(const std::string& text) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (unsigned char c : text) {
+    hash = (hash ^ c) * 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+}  // namespace
+
+JoinCacheKey::JoinCacheKey(const std::string& label) : label_(label) {
+  text_ = label + '\n';
+}
+
+arrow::Status JoinCacheKey::AddFile(const std::string& path,
+                                    const std::vector<std::string>& columns) {
+  struct stat info;
+  if (stat(path.c_str(), &info) != 0) {
+    return arrow::Status::IOError("Cannot stat ", path, ": ",
+                                  std::strerror(errno));
+  }
+  char resolved[PATH_MAX];
+  text_ += "file ";
+  text_ += realpath(path.c_str(), resolved) ? resolved : path.c_str();
+  text_ += ' ' + std::to_string(info.st_size) + ' ' +
+           std::to_string(info.st_mtim.tv_sec) + '.' +
+           std::to_string(info.st_mtim.tv_nsec);
+  for (const auto& column : columns) {
+    text_ += ' ' + column;
+  }
+  text_ += '\n';
+  return arrow::Status::OK();
+}
+
+void JoinCacheKey::Add(const std::string& text) { text_ += text + '\n'; }
+
+void JoinCacheWriter::Write(const void* data, size_t size) {
+  if (status_.ok() && size > 0) {
+    status_ = out_->Write(data, static_cast<int64_t>(size));
+    written_ += size;
+  }
+}
+
+void JoinCacheWriter::Strings(const std::vector<std::string>& values) {
+  Value(static_cast<uint64_t>(values.size()));
+  for (const auto& value : values) {
+    Value(static_cast<uint64_t>(value.size()));
+    Write(value.data(), value.size());
+  }
+}
+
+bool JoinCacheReader::Strings(std::vector<std::string>* values) {
+  uint64_t count;
+  if (!Value(&count) || count > (size_ - pos_) / sizeof(uint64_t)) {
+    return false;
+  }
+  values->resize(count);
+  for (auto& value : *values) {
+    uint64_t length;
+    if (!Value(&length) || length > size_ - pos_) {
+      return false;
+    }
+    value.assign(reinterpret_cast<const char*>(data_ + pos_), length);
+    pos_ += length;
+  }
+  return true;
+}
+
+std::string JoinCache::EntryPath(const JoinCacheKey& key) const {
+  char hash[17];
+  std::snprintf(hash, sizeof(hash), "%016llx",
+                static_cast<unsigned long long>(HashText(key.text())));
+  return directory_ + '/' + key.label() + '-' + hash + ".joincache";
+}
+
+bool JoinCache::Load(const JoinCacheKey& key,
+                     const std::function<bool(JoinCacheReader&)>& load) const {
+  if (!enabled()) {
+    return false;
+  }
+  PhaseTimer timer(Phase::kJoinBuild);
+  auto maybe_file = arrow::io::MemoryMappedFile::Open(
+      EntryPath(key), arrow::io::FileMode::READ);
+  if (!maybe_file.ok()) {
+    return false;
+  }
+  auto file = *maybe_file;
+  auto maybe_size = file->GetSize();
+  if (!maybe_size.ok()) {
+    return false;
+  }
+  auto maybe_buffer = file->ReadAt(0, *maybe_size);
+  if (!maybe_buffer.ok()) {
+    return false;
+  }
+  std::shared_ptr<arrow::Buffer> buffer = *maybe_buffer;
+  const uint8_t* data = buffer->data();
+  size_t size = static_cast<size_t>(buffer->size());
+
+  // Header: the key must match byte for byte
+  JoinCacheReader header(data, size);
+  char magic[sizeof(kMagic)];
+  uint32_t version;
+  uint64_t key_length;
+  if (!header.Read(magic, sizeof(magic)) ||
+      std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+      !header.Value(&version) || version != kFormatVersion ||
+      !header.Value(&key_length) || key_length != key.text().size() ||
+      key_length > size - header.pos_ ||
+      std::memcmp(data + header.pos_, key.text().data(), key_length) != 0) {
+    return false;
+  }
+  size_t payload_start = header.pos_ + key_length;
+
+  // Footer: a complete write ends with the payload size and kEndMagic
+  if (size < payload_start + kFooterSize) {
+    return false;
+  }
+  JoinCacheReader footer(data + size - kFooterSize, kFooterSize);
+  uint64_t payload_size;
+  footer.Value(&payload_size);
+  footer.Read(magic, sizeof(magic));
+  if (std::memcmp(magic, kEndMagic, sizeof(kEndMagic)) != 0 ||
+      payload_size != size - kFooterSize - payload_start) {
+    return false;
+  }
+
+  JoinCacheReader reader(data + payload_start, payload_size);
+  if (!load(reader) || !reader.AtEnd()) {
+    return false;
+  }
+  timer.Count(0, static_cast<int64_t>(size));
+  return true;
+}
+
+arrow::Status JoinCache::Store(
+    const JoinCacheKey& key,
+    const std::function<void(JoinCacheWriter&)>& save) const {
+  if (!enabled()) {
+    return arrow::Status::OK();
+  }
+  PhaseTimer timer(Phase::kJoinBuild);
+  if (mkdir(directory_.c_str(), 0777) != 0 && errno != EEXIST) {
+    return arrow::Status::IOError("Cannot create ", directory_, ": ",
+                                  std::strerror(errno));
+  }
+  std::string path = EntryPath(key);
+  std::string temp_path = path + ".tmp" + std::to_string(getpid());
+  std::shared_ptr<arrow::io::FileOutputStream> file;
+  ARROW_ASSIGN_OR_RAISE(file, arrow::io::FileOutputStream::Open(temp_path));
+
+  JoinCacheWriter header(file.get());
+  header.Write(kMagic, sizeof(kMagic));
+  header.Value(kFormatVersion);
+  header.Value(static_cast<uint64_t>(key.text().size()));
+  header.Write(key.text().data(), key.text().size());
+
+  JoinCacheWriter writer(file.get());
+  save(writer);
+  uint64_t payload_size = writer.written_;
+  writer.Value(payload_size);
+  writer.Write(kEndMagic, sizeof(kEndMagic));
+
+  arrow::Status st = header.status_;
+  if (st.ok()) {
+    st = writer.status_;
+  }
+  arrow::Status close_st = file->Close();
+  if (st.ok()) {
+    st = close_st;
+  }
+  if (st.ok() && std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    st = arrow::Status::IOError("Cannot rename ", temp_path, ": ",
+                                std::strerror(errno));
+  }
+  if (!st.ok()) {
+    unlink(temp_path.c_str());
+  }
+  return st;
+}
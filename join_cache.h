@@ -0,0 +1,150 @@
+// Persistent cache of join build sides, for datasets queried repeatedly.
+//
+// A build side (one or more hash tables, dense arrays and filters) is
+// stored in one file under the cache directory, named after a hash of its
+// JoinCacheKey: a label, the path, size and mtime of every input file with
+// the columns read from it, and whatever else shaped the build (predicate
+// constants). Loading maps the file (arrow::io::MemoryMappedFile) and copies
+// its arrays into the structures in bulk, so a hit skips scanning, decoding
+// and inserting altogether. An entry whose stored key differs, that is
+// truncated or that has another format version is a miss. Entries are
+// written to a temporary name and renamed, so a concurrent run never sees
+// half a file.
+//
+// Structures take part through Save(JoinCacheWriter&) const and
+// Load(JoinCacheReader&), which write and read their fields in the same
+// order. Entries hold raw host-endian memory and are only meant for the
+// machine that wrote them.
+#pragma once
+
+#include <arrow/io/interfaces.h>
+#include <arrow/status.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class JoinCacheKey {
+ public:
+  explicit JoinCacheKey(const std::string& label);
+
+  // Adds an input file and the columns read from it.
+  arrow::Status AddFile(const std::string& path,
+                        const std::vector<std::string>& columns);
+
+  // Adds anything else the build depends on.
+  void Add(const std::string& text);
+
+  const std::string& label() const { return label_; }
+  const std::string& text() const { return text_; }
+
+ private:
+  std::string label_;
+  std::string text_;
+};
+
+class JoinCacheWriter {
+ public:
+  template <typename T>
+  void Value(const T& value) {
+    static_assert(std::is_trivially_copyable<T>::value, "raw copies only");
+    Write(&value, sizeof(T));
+  }
+
+  template <typename T>
+  void Array(const std::vector<T>& values) {
+    static_assert(std::is_trivially_copyable<T>::value, "raw copies only");
+    Value(static_cast<uint64_t>(values.size()));
+    Write(values.data(), values.size() * sizeof(T));
+  }
+
+  void Strings(const std::vector<std::string>& values);
+
+ private:
+  friend class JoinCache;
+
+  explicit JoinCacheWriter(arrow::io::OutputStream* out) : out_(out) {}
+
+  void Write(const void* data, size_t size);
+
+  arrow::io::OutputStream* out_;
+  arrow::Status status_;
+  uint64_t written_ = 0;
+};
+
+// Reads fail (return false) instead of running past the entry.
+class JoinCacheReader {
+ public:
+  template <typename T>
+  bool Value(T* value) {
+    static_assert(std::is_trivially_copyable<T>::value, "raw copies only");
+    return Read(value, sizeof(T));
+  }
+
+  template <typename T>
+  bool Array(std::vector<T>* values) {
+    static_assert(std::is_trivially_copyable<T>::value, "raw copies only");
+    uint64_t count;
+    if (!Value(&count) || count > (size_ - pos_) / sizeof(T)) {
+      return false;
+    }
+    values->resize(count);
+    return Read(values->data(), count * sizeof(T));
+  }
+
+  bool Strings(std::vector<std::string>* values);
+
+  // Whether the whole entry has been read.
+  bool AtEnd() const { return pos_ == size_; }
+
+ private:
+  friend class JoinCache;
+
+  JoinCacheReader(const uint8_t* data, size_t size)
+      : data_(data), size_(size) {}
+
+  bool Read(void* out, size_t size) {
+    if (size > size_ - pos_) {
+      return false;
+    }
+    if (size > 0) {
+      std::memcpy(out, data_ + pos_, size);
+    }
+    pos_ += size;
+    return true;
+  }
+
+  const uint8_t* data_;
+  size_t size_;
+  size_t pos_ = 0;
+};
+
+class JoinCache {
+ public:
+  // An empty directory disables the cache: Load() misses and Store() does
+  // nothing. The directory is created on the first Store().
+  explicit JoinCache(std::string directory)
+      : directory_(std::move(directory)) {}
+
+  bool enabled() const { return !directory_.empty(); }
+
+  // Runs load on the entry for key; it must consume the entry exactly.
+  // Returns false on a miss, including an entry load rejects, in which case
+  // the structures load touched must be rebuilt from scratch.
+  bool Load(const JoinCacheKey& key,
+            const std::function<bool(JoinCacheReader&)>& load) const;
+
+  // Writes the entry for key with save, replacing any previous one.
+  arrow::Status Store(const JoinCacheKey& key,
+                      const std::function<void(JoinCacheWriter&)>& save) const;
+
+ private:
+  std::string EntryPath(const JoinCacheKey& key) const;
+
+  std::string directory_;
+};
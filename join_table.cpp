@@ -0,0 +1,102 @@
+#include "join_table.h"
+
+#include "join_cache.h"
+#include "rvv_kernels.h"
+
+#include <algorithm>
+
+// The gather takes uint32 byte offsets into the array
+constexpr int64_t kMaxDenseSlots = int64_t(1) << 29;
+
+Int32JoinTable::Int32JoinTable(int64_t expected_rows)
+    : hashed_(static_cast<size_t>(expected_rows)) {}
+
+Int32JoinTable Int32JoinTable::ForRange(int64_t min, int64_t max,
+                                        int64_t expected_rows) {
+  // Computed in unsigned arithmetic: max - min can overflow int64
+  uint64_t span = static_cast<uint64_t>(max) - static_cast<uint64_t>(min);
+  if (max < min || span >= static_cast<uint64_t>(kMaxDenseSlots) ||
+      static_cast<int64_t>(span) + 1 > kMaxDenseFactor * expected_rows) {
+    return Int32JoinTable(expected_rows);
+  }
+  Int32JoinTable table;
+  table.dense_ = true;
+  table.base_ = min;
+  table.direct_.assign(span + 1, kMissing);
+  return table;
+}
+
+Int32JoinTable Int32JoinTable::ForColumn(const ParquetScanner& scanner,
+                                         const std::string& key_column) {
+  int64_t min, max;
+  if (!scanner.ColumnRange(key_column, &min, &max)) {
+    return Int32JoinTable(scanner.num_rows());
+  }
+  return ForRange(min, max, scanner.num_rows());
+}
+
+void Int32JoinTable::Insert(int64_t key, int32_t value) {
+  if (!dense_) {
+    hashed_[key] = value;
+    return;
+  }
+  uint64_t index = static_cast<uint64_t>(key) - static_cast<uint64_t>(base_);
+  if (index >= direct_.size()) {
+    // Statistics said otherwise; keep the key rather than lose it
+    hashed_[key] = value;
+    return;
+  }
+  dense_size_ += direct_[index] == kMissing;
+  direct_[index] = value;
+}
+
+int32_t Int32JoinTable::Find(int64_t key) const {
+  if (dense_) {
+    uint64_t index = static_cast<uint64_t>(key) - static_cast<uint64_t>(base_);
+    if (index < direct_.size()) {
+      return direct_[index];
+    }
+  }
+  const int32_t* value = hashed_.Find(key);
+  return value ? *value : kMissing;
+}
+
+void Int32JoinTable::Probe(const int64_t* keys, size_t n, int32_t* out) const {
+  if (dense_) {
+    size_t misses = rvv::gather_dense_int32(direct_.data(), base_,
+                                            direct_.size(), keys, out, n);
+    if (misses == 0 || hashed_.size() == 0) {
+      return;
+    }
+    for (size_t i = 0; i < n; i++) {
+      if (out[i] == kMissing) {
+        const int32_t* value = hashed_.Find(keys[i]);
+        out[i] = value ? *value : kMissing;
+      }
+    }
+    return;
+  }
+  constexpr size_t kBlock = 256;
+  const int32_t* values[kBlock];
+  for (size_t i = 0; i < n; i += kBlock) {
+    size_t block = std::min(kBlock, n - i);
+    hashed_.Probe(keys + i, block, values);
+    for (size_t j = 0; j < block; j++) {
+      out[i + j] = values[j] ? *values[j] : kMissing;
+    }
+  }
+}
+
+void Int32JoinTable::Save(JoinCacheWriter& out) const {
+  out.Value(dense_);
+  out.Value(base_);
+  out.Array(direct_);
+  out.Value(dense_size_);
+  hashed_.Save(out);
+}
+
+bool Int32JoinTable::Load(JoinCacheReader& in) {
+  return in.Value(&dense_) && in.Value(&base_) && in.Array(&direct_) &&
+         in.Value(&dense_size_) && hashed_.Load(in) &&
+         direct_.size() < static_cast<size_t>(kMaxDenseSlots);
+}
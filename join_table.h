@@ -0,0 +1,63 @@
+// Build side of an equi-join on an int64 key with a small non-negative
+// int32 payload (a nation key, a year, a flag, an index into a side table).
+//
+// TPC-H keys are mostly dense: s_suppkey, p_partkey and n_nationkey run
+// 1..N and o_orderkey fills a fixed fraction of its range. When the key
+// range known up front (column min/max) is at most kMaxDenseFactor times the
+// expected row count, keys index a flat array directly and Probe() is a
+// vector gather; otherwise the table falls back to a FlatHashMap.
+#pragma once
+
+#include "flat_hash_map.h"
+#include "parquet_scan.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class JoinCacheReader;
+class JoinCacheWriter;
+
+class Int32JoinTable {
+ public:
+  static constexpr int32_t kMissing = -1;
+  static constexpr int64_t kMaxDenseFactor = 4;
+
+  // Hash table sized for expected_rows.
+  explicit Int32JoinTable(int64_t expected_rows = 0);
+
+  // Direct-address array over [min, max] when that range is dense enough,
+  // a hash table otherwise.
+  static Int32JoinTable ForRange(int64_t min, int64_t max,
+                                 int64_t expected_rows);
+
+  // The same for the rows of scanner keyed by key_column, using its file
+  // statistics; hashes when they are missing.
+  static Int32JoinTable ForColumn(const ParquetScanner& scanner,
+                                  const std::string& key_column);
+
+  // value must be >= 0; inserting a key again overwrites its value.
+  void Insert(int64_t key, int32_t value);
+
+  // Value of key, or kMissing.
+  int32_t Find(int64_t key) const;
+
+  // out[i] = Find(keys[i]) for i < n.
+  void Probe(const int64_t* keys, size_t n, int32_t* out) const;
+
+  bool dense() const { return dense_; }
+  size_t size() const { return dense_size_ + hashed_.size(); }
+
+  // State for JoinCache (join_cache.h).
+  void Save(JoinCacheWriter& out) const;
+  bool Load(JoinCacheReader& in);
+
+ private:
+  bool dense_ = false;
+  int64_t base_ = 0;
+  std::vector<int32_t> direct_;  // key - base_ -> value, kMissing if absent
+  size_t dense_size_ = 0;
+  // Every key when not dense, else keys outside the statistics range
+  FlatHashMap<int64_t, int32_t> hashed_;
+};
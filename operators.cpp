@@ -0,0 +1,493 @@
+#include "operators.h"
+
+#include <arrow/api.h>
+#include <arrow/util/decimal.h>
+
+#include "chunked_dispatch.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace {
+
+int32_t decimal_scale(const arrow::Array& array) {
+  return static_cast<const arrow::DecimalType&>(*array.type()).scale();
+}
+
+arrow::Result<const uint8_t*> DecimalValues(const arrow::Array& array) {
+  if (array.type_id() != arrow::Type::DECIMAL128) {
+    return arrow::Status::TypeError("Expected decimal128 column, got ",
+                                    array.type()->ToString());
+  }
+  return static_cast<const arrow::Decimal128Array&>(array).raw_values();
+}
+
+// x as an unscaled value of the decimal type of array
+arrow::Result<int64_t> unscaled_bound(const arrow::Array& array, double x) {
+  const auto& type = static_cast<const arrow::DecimalType&>(*array.type());
+  ARROW_ASSIGN_OR_RAISE(auto value, arrow::Decimal128::FromReal(
+                                        x, type.precision(), type.scale()));
+  return value.ToInteger<int64_t>();
+}
+
+const uint8_t* string_data(const arrow::StringArray& array) {
+  return array.value_data() ? array.value_data()->data() : nullptr;
+}
+
+}  // namespace
+
+Chunk::Chunk(const ScanMorsel& morsel, int num_slots, ScratchArena& scratch)
+    : worker_(morsel.worker),
+      all_match_(morsel.all_match),
+      batch_(*morsel.batch),
+      num_rows_(static_cast<size_t>(morsel.batch->num_rows())),
+      scratch_(scratch),
+      slots_(num_slots) {
+  PhaseTimer timer(Phase::kFilter);
+  size_t bitmap_bytes = (num_rows_ + 7) / 8;
+  selection_ = scratch_.Allocate<uint8_t>(bitmap_bytes);
+  std::memset(selection_, 0xFF, bitmap_bytes);
+  // A null in any input column drops the row, as in SQL
+  for (const auto& column : batch_.columns()) {
+    DropNulls(*column, selection_);
+  }
+}
+
+arrow::Result<const arrow::Array*> Chunk::column(
+    const std::string& name) const {
+  auto array = batch_.GetColumnByName(name);
+  if (!array) {
+    return arrow::Status::Invalid("Column not in the scan: ", name);
+  }
+  return array.get();
+}
+
+void Chunk::Select() {
+  if (selected_) {
+    return;
+  }
+  PhaseTimer timer(Phase::kFilter);
+  rows_ = scratch_.Allocate<int32_t>(num_rows_);
+  num_selected_ =
+      rvv::with_lmul(rvv::KernelClass::kCompare, [&](auto lmul) {
+        return rvv::bitmap_to_selection<decltype(lmul)::value>(
+            selection_, num_rows_, rows_);
+      });
+  for (auto& slot : slots_) {
+    if (slot.per_row) {
+      int32_t* compacted = scratch_.Allocate<int32_t>(num_selected_);
+      rvv::with_lmul(rvv::KernelClass::kDecode, [&](auto lmul) {
+        rvv::gather_int32<decltype(lmul)::value>(
+            static_cast<const int32_t*>(slot.values), rows_, compacted,
+            num_selected_);
+      });
+      slot.values = compacted;
+      slot.per_row = false;
+    }
+  }
+  selected_ = true;
+}
+
+JoinBuild::JoinBuild(std::string key_column, std::string payload_column,
+                     std::function<int32_t(std::string_view)> entry_value)
+    : key_column_(std::move(key_column)),
+      payload_column_(std::move(payload_column)),
+      entry_value_(std::move(entry_value)) {}
+
+ScanOptions JoinBuild::scan_options() const {
+  ScanOptions options;
+  options.columns = {key_column_, payload_column_};
+  if (entry_value_) {
+    options.dictionary_columns = {payload_column_};
+  }
+  if (keys_) {
+    options.key_filters = {keys_->ScanFilter(key_column_)};
+  }
+  return options;
+}
+
+arrow::Status JoinBuild::Start(const ParquetScanner& file, int num_workers) {
+  int64_t min_key = 0;
+  int64_t max_key = -1;
+  if (keys_ && keys_->KeyRange(&min_key, &max_key)) {
+    table_ = Int32JoinTable::ForRange(min_key, max_key,
+                                      static_cast<int64_t>(keys_->size()));
+  } else {
+    table_ = Int32JoinTable::ForColumn(file, key_column_);
+  }
+  workers_ = std::vector<Worker>(num_workers);
+  return arrow::Status::OK();
+}
+
+arrow::Status JoinBuild::Consume(const ScanMorsel& morsel) {
+  PhaseTimer timer(Phase::kJoinBuild);
+  const arrow::RecordBatch& batch = *morsel.batch;
+  auto key_array = batch.GetColumnByName(key_column_);
+  auto payload_array = batch.GetColumnByName(payload_column_);
+  const int64_t* keys;
+  ARROW_ASSIGN_OR_RAISE(keys, FixedWidthValues<int64_t>(*key_array));
+  size_t n = static_cast<size_t>(batch.num_rows());
+
+  ScratchArena& scratch = ScratchArena::ForThread();
+  scratch.Reset();
+  size_t bitmap_bytes = (n + 7) / 8;
+  uint8_t* valid = scratch.Allocate<uint8_t>(bitmap_bytes);
+  std::memset(valid, 0xFF, bitmap_bytes);
+  DropNulls(*key_array, valid);
+  DropNulls(*payload_array, valid);
+  if (keys_) {
+    // Bloom filter false positives only cost a table entry nobody probes
+    uint8_t* passes = scratch.Allocate<uint8_t>(bitmap_bytes);
+    std::memset(passes, 0, bitmap_bytes);
+    keys_->Probe(keys, n, passes);
+    rvv::and_bitmap(valid, 0, passes, 0, n);
+  }
+
+  const int32_t* payloads;
+  if (entry_value_) {
+    int32_t* mapped = scratch.Allocate<int32_t>(n);
+    ARROW_RETURN_NOT_OK(DictionaryLookup(*payload_array, entry_value_, mapped));
+    payloads = mapped;
+  } else {
+    ARROW_ASSIGN_OR_RAISE(payloads, FixedWidthValues<int32_t>(*payload_array));
+  }
+
+  Worker& worker = workers_[morsel.worker];
+  for (size_t i = 0; i < n; i++) {
+    if ((valid[i / 8] & (1 << (i % 8))) != 0 && payloads[i] >= 0) {
+      worker.keys.push_back(keys[i]);
+      worker.payloads.push_back(payloads[i]);
+    }
+  }
+  timer.Count(n, n * (sizeof(int64_t) + sizeof(int32_t)));
+  return arrow::Status::OK();
+}
+
+arrow::Status JoinBuild::Finish(const ScanStats& stats) {
+  PhaseTimer timer(Phase::kJoinBuild);
+  stats_ = stats;
+  for (auto& worker : workers_) {
+    for (size_t i = 0; i < worker.keys.size(); i++) {
+      table_.Insert(worker.keys[i], worker.payloads[i]);
+    }
+    worker = Worker();
+  }
+  return arrow::Status::OK();
+}
+
+Pipeline::Pipeline(ScanOptions options, const QueryOptions& query_options)
+    : options_(std::move(options)), input_(query_options.input) {}
+
+JoinBuild* Pipeline::AddBuild(
+    const std::string& file_path, std::unique_ptr<JoinBuild> build,
+    std::shared_ptr<parquet::FileMetaData> metadata) {
+  JoinBuild* raw = build.get();
+  builds_.push_back({file_path, std::move(build), std::move(metadata)});
+  return raw;
+}
+
+arrow::Status Pipeline::Start(const ParquetScanner& file, int num_workers) {
+  num_workers_ = num_workers;
+  for (auto& build : builds_) {
+    ARROW_RETURN_NOT_OK(RunSharedScan(build.file_path, {build.build.get()},
+                                      input_, num_workers, build.metadata));
+  }
+  for (auto& op : operators_) {
+    ARROW_RETURN_NOT_OK(op->Start(file, num_workers));
+  }
+  return arrow::Status::OK();
+}
+
+arrow::Status Pipeline::Consume(const ScanMorsel& morsel) {
+  ScratchArena& scratch = ScratchArena::ForThread();
+  scratch.Reset();
+  Chunk chunk(morsel, num_slots_, scratch);
+  for (auto& op : operators_) {
+    ARROW_RETURN_NOT_OK(op->Push(chunk));
+    if (chunk.selected() && chunk.num_selected() == 0) {
+      break;
+    }
+  }
+  return arrow::Status::OK();
+}
+
+arrow::Status Pipeline::Finish(const ScanStats& stats) {
+  for (auto& op : operators_) {
+    ARROW_RETURN_NOT_OK(op->Finish());
+  }
+  return on_finish_ ? on_finish_(stats) : arrow::Status::OK();
+}
+
+arrow::Status Filter::Push(Chunk& chunk) {
+  if (chunk.selected()) {
+    return arrow::Status::Invalid(
+        "Filters and join probes must come before the first projection");
+  }
+  if (implied_by_prune_ && chunk.all_match()) {
+    return arrow::Status::OK();
+  }
+  return PushSelection(chunk);
+}
+
+arrow::Status Int32RangeFilter::PushSelection(Chunk& chunk) {
+  PhaseTimer timer(Phase::kFilter);
+  const arrow::Array* array;
+  ARROW_ASSIGN_OR_RAISE(array, chunk.column(column_));
+  const int32_t* values;
+  ARROW_ASSIGN_OR_RAISE(values, FixedWidthValues<int32_t>(*array));
+  size_t n = chunk.num_rows();
+  uint8_t* matches = chunk.Allocate<uint8_t>((n + 7) / 8);
+  const rvv::Int32Term terms[] = {{rvv::CmpOp::kGe, values, nullptr, min_},
+                                  {rvv::CmpOp::kLt, values, nullptr, end_}};
+  rvv::with_lmul(rvv::KernelClass::kCompare, [&](auto lmul) {
+    constexpr int L = decltype(lmul)::value;
+    rvv::conjunction_bitmap<L>(terms, 2, matches, 0, n);
+    rvv::and_bitmap<L>(chunk.selection(), 0, matches, 0, n);
+  });
+  timer.Count(n, n * sizeof(int32_t));
+  return arrow::Status::OK();
+}
+
+std::unique_ptr<DecimalRangeFilter> DecimalRangeFilter::Below(
+    std::string column, double limit) {
+  auto filter =
+      std::make_unique<DecimalRangeFilter>(std::move(column), 0.0, limit);
+  filter->has_min_ = false;
+  filter->max_exclusive_ = true;
+  return filter;
+}
+
+arrow::Status DecimalRangeFilter::PushSelection(Chunk& chunk) {
+  PhaseTimer timer(Phase::kFilter);
+  const arrow::Array* array;
+  ARROW_ASSIGN_OR_RAISE(array, chunk.column(column_));
+  const uint8_t* values;
+  ARROW_ASSIGN_OR_RAISE(values, DecimalValues(*array));
+  int64_t lo = INT64_MIN;
+  if (has_min_) {
+    ARROW_ASSIGN_OR_RAISE(lo, unscaled_bound(*array, min_));
+  }
+  int64_t hi;
+  ARROW_ASSIGN_OR_RAISE(hi, unscaled_bound(*array, max_));
+  if (max_exclusive_) {
+    hi--;
+  }
+  size_t n = chunk.num_rows();
+  rvv::with_lmul(rvv::KernelClass::kCompare, [&](auto lmul) {
+    rvv::and_decimal128_range<decltype(lmul)::value>(values, lo, hi,
+                                                     chunk.selection(), 0, n);
+  });
+  // Masked loads skip deselected rows, so this is an upper bound
+  timer.Count(n, n * arrow::Decimal128Type::kByteWidth);
+  return arrow::Status::OK();
+}
+
+arrow::Status JoinProbe::PushSelection(Chunk& chunk) {
+  PhaseTimer timer(Phase::kProbe);
+  const arrow::Array* array;
+  ARROW_ASSIGN_OR_RAISE(array, chunk.column(key_column_));
+  const int64_t* keys;
+  ARROW_ASSIGN_OR_RAISE(keys, FixedWidthValues<int64_t>(*array));
+  // Every row is probed: a vector gather over the batch beats compacting
+  // the keys first while most rows are still selected
+  size_t n = chunk.num_rows();
+  int32_t* payloads = chunk.Allocate<int32_t>(n);
+  build_->table().Probe(keys, n, payloads);
+  uint8_t* hits = chunk.Allocate<uint8_t>((n + 7) / 8);
+  rvv::with_lmul(rvv::KernelClass::kCompare, [&](auto lmul) {
+    constexpr int L = decltype(lmul)::value;
+    rvv::compare_scalar_bitmap<int32_t, rvv::CmpOp::kGe, L>(payloads, 0, hits,
+                                                            0, n);
+    rvv::and_bitmap<L>(chunk.selection(), 0, hits, 0, n);
+  });
+  Slot& slot = chunk.slot(slot_);
+  slot.values = payloads;
+  slot.per_row = true;
+  timer.Count(n, n * (sizeof(int64_t) + sizeof(int32_t)));
+  return arrow::Status::OK();
+}
+
+arrow::Status DictionaryFilter::PushSelection(Chunk& chunk) {
+  PhaseTimer timer(Phase::kFilter);
+  const arrow::Array* array;
+  ARROW_ASSIGN_OR_RAISE(array, chunk.column(column_));
+  size_t n = chunk.num_rows();
+  int32_t* values = chunk.Allocate<int32_t>(n);
+  ARROW_RETURN_NOT_OK(DictionaryLookup(*array, entry_value_, values));
+  uint8_t* matches = chunk.Allocate<uint8_t>((n + 7) / 8);
+  rvv::with_lmul(rvv::KernelClass::kCompare, [&](auto lmul) {
+    constexpr int L = decltype(lmul)::value;
+    rvv::compare_scalar_bitmap<int32_t, rvv::CmpOp::kGe, L>(values, 0, matches,
+                                                            0, n);
+    rvv::and_bitmap<L>(chunk.selection(), 0, matches, 0, n);
+  });
+  if (slot_ >= 0) {
+    Slot& slot = chunk.slot(slot_);
+    slot.values = values;
+    slot.per_row = true;
+  }
+  timer.Count(n, n * 2 * sizeof(int32_t));
+  return arrow::Status::OK();
+}
+
+arrow::Status PairGroupBy::Start(const ParquetScanner&, int num_workers) {
+  workers_ = std::vector<DenseGroupBy>(num_workers);
+  return arrow::Status::OK();
+}
+
+arrow::Status PairGroupBy::Push(Chunk& chunk) {
+  // After Select() only the selected rows get an id
+  size_t m = chunk.selected() ? chunk.num_selected() : chunk.num_rows();
+  if (m == 0) {
+    return arrow::Status::OK();
+  }
+  PhaseTimer timer(Phase::kDecode);
+  const arrow::StringArray* columns[2];
+  const std::string* names[2] = {&column_a_, &column_b_};
+  for (int i = 0; i < 2; i++) {
+    const arrow::Array* array;
+    ARROW_ASSIGN_OR_RAISE(array, chunk.column(*names[i]));
+    columns[i] = dynamic_cast<const arrow::StringArray*>(array);
+    if (!columns[i]) {
+      return arrow::Status::TypeError("Expected a string column for ",
+                                      *names[i], ", got ",
+                                      array->type()->ToString());
+    }
+  }
+  // Offsets and data are only read sequentially, so every row is packed
+  // and the selected codes gathered afterwards
+  size_t n = chunk.num_rows();
+  int32_t* codes = chunk.Allocate<int32_t>(n);
+  if (!rvv::char_pair_codes(columns[0]->raw_value_offsets(),
+                            string_data(*columns[0]),
+                            columns[1]->raw_value_offsets(),
+                            string_data(*columns[1]), codes, n)) {
+    return arrow::Status::Invalid(column_a_, " and ", column_b_,
+                                  " must be single characters");
+  }
+  if (chunk.selected()) {
+    int32_t* selected = chunk.Allocate<int32_t>(m);
+    rvv::with_lmul(rvv::KernelClass::kDecode, [&](auto lmul) {
+      rvv::gather_int32<decltype(lmul)::value>(codes, chunk.rows(), selected,
+                                               m);
+    });
+    codes = selected;
+  }
+  timer.Count(n, n * 2 * (sizeof(int32_t) + 1));
+
+  timer.Switch(Phase::kAggregate);
+  DenseGroupBy& groups = workers_[chunk.worker()];
+  int32_t* ids = chunk.Allocate<int32_t>(m);
+  groups.Assign(codes, ids, m);
+  if (groups.num_groups() > static_cast<size_t>(max_groups_)) {
+    return arrow::Status::Invalid("More than ", max_groups_, " groups of ",
+                                  column_a_, ", ", column_b_);
+  }
+  Slot& slot = chunk.slot(slot_);
+  slot.values = ids;
+  slot.per_row = !chunk.selected();
+  return arrow::Status::OK();
+}
+
+arrow::Status PairGroupBy::Finish() {
+  codes_.clear();
+  for (const auto& groups : workers_) {
+    for (size_t g = 0; g < groups.num_groups(); g++) {
+      codes_.push_back(groups.code(g));
+    }
+  }
+  std::sort(codes_.begin(), codes_.end());
+  codes_.erase(std::unique(codes_.begin(), codes_.end()), codes_.end());
+  groups_.assign(workers_.size(), std::vector<int>(max_groups_, -1));
+  for (size_t w = 0; w < workers_.size(); w++) {
+    for (size_t g = 0; g < workers_[w].num_groups(); g++) {
+      groups_[w][g] = static_cast<int>(
+          std::lower_bound(codes_.begin(), codes_.end(),
+                           workers_[w].code(g)) -
+          codes_.begin());
+    }
+  }
+  return arrow::Status::OK();
+}
+
+arrow::Status RuntimeFilter::Start(const ParquetScanner& file,
+                                   int num_workers) {
+  // At most one key per row; the key column's statistics give the range
+  filter_ = SemiJoinFilter::ForColumn(file, key_column_, file.num_rows());
+  workers_ = std::vector<Worker>(num_workers);
+  return arrow::Status::OK();
+}
+
+arrow::Status RuntimeFilter::Push(Chunk& chunk) {
+  chunk.Select();
+  size_t m = chunk.num_selected();
+  if (m == 0) {
+    return arrow::Status::OK();
+  }
+  PhaseTimer timer(Phase::kJoinBuild);
+  const arrow::Array* array;
+  ARROW_ASSIGN_OR_RAISE(array, chunk.column(key_column_));
+  const int64_t* keys;
+  ARROW_ASSIGN_OR_RAISE(keys, FixedWidthValues<int64_t>(*array));
+  const int32_t* payloads = chunk.values<int32_t>(payload_slot_);
+  Worker& worker = workers_[chunk.worker()];
+  const int32_t* rows = chunk.rows();
+  for (size_t i = 0; i < m; i++) {
+    worker.keys.push_back(keys[rows[i]]);
+  }
+  worker.payloads.insert(worker.payloads.end(), payloads, payloads + m);
+  timer.Count(m, m * (sizeof(int64_t) + sizeof(int32_t)));
+  return arrow::Status::OK();
+}
+
+arrow::Status RuntimeFilter::Finish() {
+  PhaseTimer timer(Phase::kJoinBuild);
+  for (auto& worker : workers_) {
+    keys_.insert(keys_.end(), worker.keys.begin(), worker.keys.end());
+    payloads_.insert(payloads_.end(), worker.payloads.begin(),
+                     worker.payloads.end());
+    worker = Worker();
+  }
+  for (int64_t key : keys_) {
+    filter_.Insert(key);
+  }
+  return arrow::Status::OK();
+}
+
+arrow::Status ProjectDecimal::Push(Chunk& chunk) {
+  chunk.Select();
+  PhaseTimer timer(Phase::kDecode);
+  const arrow::Array* array;
+  ARROW_ASSIGN_OR_RAISE(array, chunk.column(column_));
+  const uint8_t* values;
+  ARROW_ASSIGN_OR_RAISE(values, DecimalValues(*array));
+  size_t n = chunk.num_selected();
+  int32_t scale = decimal_scale(*array);
+  Slot& slot = chunk.slot(slot_);
+  slot.scale = scale;
+  if (mode_ == AggMode::kExact) {
+    int32_t* out = chunk.Allocate<int32_t>(n);
+    bool in_range =
+        rvv::with_lmul<4>(rvv::KernelClass::kDecode, [&](auto lmul) {
+          return rvv::gather_decimal128_unscaled<decltype(lmul)::value>(
+              values, chunk.rows(), n, out);
+        });
+    if (!in_range) {
+      return arrow::Status::Invalid(
+          "Decimal value out of int32 range for exact aggregation; "
+          "rerun with --agg=float");
+    }
+    slot.values = out;
+  } else {
+    float* out = chunk.Allocate<float>(n);
+    rvv::with_lmul<4>(rvv::KernelClass::kDecode, [&](auto lmul) {
+      rvv::gather_decimal128<float, decltype(lmul)::value>(
+          values, scale, chunk.rows(), n, out);
+    });
+    slot.values = out;
+  }
+  // The selection vector and one gathered decimal per selected row
+  timer.Count(n, n * (sizeof(int32_t) + arrow::Decimal128Type::kByteWidth));
+  return arrow::Status::OK();
+}
@@ -0,0 +1,778 @@
+// Push-based vectorized operators, so a query is a plan rather than a
+// hand-wired scan loop.
+//
+// A Pipeline is a ScanQuery (shared_scan.h): every batch of the scan is
+// pushed through its operators in order, on the worker thread that decoded
+// it, so pipelines get the parallel, pipelined, mapped and shared scans of
+// the hand-written queries for free. A Q6-like plan:
+//
+//   Pipeline plan(scan_options, options);
+//   plan.Add<Int32RangeFilter>("l_shipdate", start, end)->ImpliedByPrune();
+//   plan.Add<DecimalRangeFilter>("l_discount", 0.05, 0.07);
+//   plan.Add(DecimalRangeFilter::Below("l_quantity", 24));
+//   int price = plan.AddSlot(), discount = plan.AddSlot();
+//   plan.Add<ProjectDecimal>("l_extendedprice", price, mode);
+//   plan.Add<ProjectDecimal>("l_discount", discount, mode);
+//   auto* revenue = plan.Add<Sum<SumExpr::kProduct>>(mode, price, discount);
+//
+// A Chunk starts as the batch and a selection bitmap without the null rows.
+// Filters and join probes clear bits of it. The first operator that needs
+// values selects: the bitmap becomes a selection vector (late
+// materialization) and from then on computed columns (slots) hold one value
+// per selected row, so no rows can be dropped any more. Operators keep their
+// state per worker and merge it in Finish().
+//
+// Kernels are picked at compile time where the plan fixes them:
+// CompareFilter is a template over the column type and comparison, Sum over
+// the summed expression; the LMUL is still chosen at runtime (with_lmul).
+//
+// Q1, Q6, Q12 and Q14 are plans. Q4 and Q9 stay hand-written scans: their
+// build sides live in the join cache (join_cache.h) and are narrowed by
+// runtime filters across several files, which a single-scan Pipeline does
+// not express. There is no Sort or TopN operator either; the plans order
+// their few result groups in OnFinish().
+#pragma once
+
+#include "dense_group_by.h"
+#include "fixed_point.h"
+#include "join_table.h"
+#include "parquet_scan.h"
+#include "query_options.h"
+#include "query_profile.h"
+#include "rvv_dispatch.h"
+#include "rvv_kernels.h"
+#include "scratch_arena.h"
+#include "semi_join_filter.h"
+#include "shared_scan.h"
+
+#include <arrow/array.h>
+#include <arrow/record_batch.h>
+#include <arrow/result.h>
+#include <arrow/status.h>
+#include <arrow/type.h>
+#include <parquet/metadata.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// A computed column of a chunk. Join probes fill int32 slots per batch row
+// (per_row); Select() compacts those, and everything computed afterwards has
+// one value per selected row.
+struct Slot {
+  const void* values = nullptr;
+  bool per_row = false;
+  // Of unscaled decimals
+  int32_t scale = 0;
+};
+
+class Chunk {
+ public:
+  // Every row is selected except those with a null in some column.
+  Chunk(const ScanMorsel& morsel, int num_slots, ScratchArena& scratch);
+
+  int worker() const { return worker_; }
+  bool all_match() const { return all_match_; }
+  size_t num_rows() const { return num_rows_; }
+
+  // A column of the batch, or an error naming it.
+  arrow::Result<const arrow::Array*> column(const std::string& name) const;
+
+  // One bit per batch row; filters may only clear bits before Select().
+  uint8_t* selection() { return selection_; }
+  bool selected() const { return selected_; }
+
+  // Turns the bitmap into the selection vector and compacts per-row slots.
+  // Runs once; later calls return at once.
+  void Select();
+
+  // After Select()
+  const int32_t* rows() const { return rows_; }
+  size_t num_selected() const { return num_selected_; }
+
+  Slot& slot(int id) { return slots_[id]; }
+  template <typename T>
+  const T* values(int id) const {
+    return static_cast<const T*>(slots_[id].values);
+  }
+
+  template <typename T>
+  T* Allocate(size_t n) {
+    return scratch_.Allocate<T>(n);
+  }
+
+ private:
+  int worker_;
+  bool all_match_;
+  const arrow::RecordBatch& batch_;
+  size_t num_rows_;
+  ScratchArena& scratch_;
+  uint8_t* selection_;
+  bool selected_ = false;
+  int32_t* rows_ = nullptr;
+  size_t num_selected_ = 0;
+  std::vector<Slot> slots_;
+};
+
+class Operator {
+ public:
+  virtual ~Operator() = default;
+
+  // Before the scan, as ScanQuery::Start().
+  virtual arrow::Status Start(const ParquetScanner&, int /*num_workers*/) {
+    return arrow::Status::OK();
+  }
+
+  // One chunk; concurrent across workers.
+  virtual arrow::Status Push(Chunk& chunk) = 0;
+
+  // After the scan, before the pipeline's result is produced.
+  virtual arrow::Status Finish() { return arrow::Status::OK(); }
+};
+
+// Build side of an equi-join: an Int32JoinTable from an int64 key column to
+// an int32 payload, built by its own scan (Pipeline::AddBuild). Without
+// entry_value the payload column is int32 and taken as is; with it, it is
+// a dictionary string column and entry_value maps its entries (negative
+// values drop the row).
+class JoinBuild : public ScanQuery {
+ public:
+  JoinBuild(std::string key_column, std::string payload_column,
+            std::function<int32_t(std::string_view entry)> entry_value =
+                nullptr);
+
+  ScanOptions scan_options() const override;
+  arrow::Status Start(const ParquetScanner& file, int num_workers) override;
+  arrow::Status Consume(const ScanMorsel& morsel) override;
+  arrow::Status Finish(const ScanStats& stats) override;
+
+  // Restricts the build to the keys of a runtime filter from an earlier
+  // scan (RuntimeFilter): row groups without any are skipped, rows the
+  // filter rejects are not inserted, and the table is sized for its keys.
+  // keys must be complete before this build's Start().
+  JoinBuild* FilterKeys(const SemiJoinFilter* keys) {
+    keys_ = keys;
+    return this;
+  }
+
+  // Complete once the build scan has finished.
+  const Int32JoinTable& table() const { return table_; }
+  const ScanStats& stats() const { return stats_; }
+
+ private:
+  struct Worker {
+    std::vector<int64_t> keys;
+    std::vector<int32_t> payloads;
+  };
+
+  std::string key_column_;
+  std::string payload_column_;
+  std::function<int32_t(std::string_view)> entry_value_;
+  const SemiJoinFilter* keys_ = nullptr;
+  Int32JoinTable table_;
+  ScanStats stats_;
+  std::vector<Worker> workers_;
+};
+
+class Pipeline : public ScanQuery {
+ public:
+  using FinishFn = std::function<arrow::Status(const ScanStats& stats)>;
+
+  // options names the columns, dictionary columns and prune predicates;
+  // input options are taken from query_options.
+  Pipeline(ScanOptions options, const QueryOptions& query_options);
+
+  // Appends an operator and returns it for further configuration.
+  template <typename Op, typename... Args>
+  Op* Add(Args&&... args) {
+    auto op = std::make_unique<Op>(std::forward<Args>(args)...);
+    Op* raw = op.get();
+    operators_.push_back(std::move(op));
+    return raw;
+  }
+
+  template <typename Op>
+  Op* Add(std::unique_ptr<Op> op) {
+    Op* raw = op.get();
+    operators_.push_back(std::move(op));
+    return raw;
+  }
+
+  // A slot id for a computed column.
+  int AddSlot() { return num_slots_++; }
+
+  // A build side scanned from file_path in Start(), before the pipeline's
+  // own scan; metadata is that file's footer, if parsed already.
+  JoinBuild* AddBuild(
+      const std::string& file_path, std::unique_ptr<JoinBuild> build,
+      std::shared_ptr<parquet::FileMetaData> metadata = nullptr);
+
+  // Produces the result once every operator has finished.
+  void OnFinish(FinishFn fn) { on_finish_ = std::move(fn); }
+
+  // Scan threads, known from Start() on.
+  int num_workers() const { return num_workers_; }
+
+  ScanOptions scan_options() const override { return options_; }
+  arrow::Status Start(const ParquetScanner& file, int num_workers) override;
+  arrow::Status Consume(const ScanMorsel& morsel) override;
+  arrow::Status Finish(const ScanStats& stats) override;
+
+ private:
+  struct Build {
+    std::string file_path;
+    std::unique_ptr<JoinBuild> build;
+    std::shared_ptr<parquet::FileMetaData> metadata;
+  };
+
+  ScanOptions options_;
+  InputOptions input_;
+  std::vector<std::unique_ptr<Operator>> operators_;
+  std::vector<Build> builds_;
+  int num_slots_ = 0;
+  int num_workers_ = 0;
+  FinishFn on_finish_;
+};
+
+// Base of the filters: PushSelection() runs only on chunks that have not
+// selected yet, and is skipped for row groups whose statistics already prove
+// the predicate when ImpliedByPrune() was called.
+class Filter : public Operator {
+ public:
+  Filter* ImpliedByPrune() {
+    implied_by_prune_ = true;
+    return this;
+  }
+
+  arrow::Status Push(Chunk& chunk) final;
+
+ protected:
+  virtual arrow::Status PushSelection(Chunk& chunk) = 0;
+
+ private:
+  bool implied_by_prune_ = false;
+};
+
+// Raw values of a fixed-width column of T (int32 also covers date32), or a
+// type error.
+template <typename T>
+arrow::Result<const T*> FixedWidthValues(const arrow::Array& array) {
+  const auto* type =
+      dynamic_cast<const arrow::FixedWidthType*>(array.type().get());
+  if (!type || type->bit_width() != static_cast<int>(8 * sizeof(T))) {
+    return arrow::Status::TypeError("Expected a ", 8 * sizeof(T),
+                                    "-bit column, got ",
+                                    array.type()->ToString());
+  }
+  return array.data()->template GetValues<T>(1);
+}
+
+// column OP value
+template <typename T, rvv::CmpOp Op>
+class CompareFilter : public Filter {
+ public:
+  CompareFilter(std::string column, T value)
+      : column_(std::move(column)), value_(value) {}
+
+ protected:
+  arrow::Status PushSelection(Chunk& chunk) override {
+    PhaseTimer timer(Phase::kFilter);
+    const arrow::Array* array;
+    ARROW_ASSIGN_OR_RAISE(array, chunk.column(column_));
+    const T* values;
+    ARROW_ASSIGN_OR_RAISE(values, FixedWidthValues<T>(*array));
+    size_t n = chunk.num_rows();
+    uint8_t* matches = chunk.Allocate<uint8_t>((n + 7) / 8);
+    rvv::with_lmul(rvv::KernelClass::kCompare, [&](auto lmul) {
+      constexpr int L = decltype(lmul)::value;
+      rvv::compare_scalar_bitmap<T, Op, L>(values, value_, matches, 0, n);
+      rvv::and_bitmap<L>(chunk.selection(), 0, matches, 0, n);
+    });
+    timer.Count(n, n * sizeof(T));
+    return arrow::Status::OK();
+  }
+
+ private:
+  std::string column_;
+  T value_;
+};
+
+// lhs OP rhs on two columns of T, e.g. l_commitdate < l_receiptdate
+template <typename T, rvv::CmpOp Op>
+class ColumnCompareFilter : public Filter {
+ public:
+  ColumnCompareFilter(std::string lhs, std::string rhs)
+      : lhs_(std::move(lhs)), rhs_(std::move(rhs)) {}
+
+ protected:
+  arrow::Status PushSelection(Chunk& chunk) override {
+    PhaseTimer timer(Phase::kFilter);
+    const arrow::Array* lhs_array;
+    ARROW_ASSIGN_OR_RAISE(lhs_array, chunk.column(lhs_));
+    const arrow::Array* rhs_array;
+    ARROW_ASSIGN_OR_RAISE(rhs_array, chunk.column(rhs_));
+    const T* lhs;
+    ARROW_ASSIGN_OR_RAISE(lhs, FixedWidthValues<T>(*lhs_array));
+    const T* rhs;
+    ARROW_ASSIGN_OR_RAISE(rhs, FixedWidthValues<T>(*rhs_array));
+    size_t n = chunk.num_rows();
+    uint8_t* matches = chunk.Allocate<uint8_t>((n + 7) / 8);
+    rvv::with_lmul(rvv::KernelClass::kCompare, [&](auto lmul) {
+      constexpr int L = decltype(lmul)::value;
+      rvv::compare_bitmap<T, Op, L>(lhs, rhs, matches, 0, n);
+      rvv::and_bitmap<L>(chunk.selection(), 0, matches, 0, n);
+    });
+    timer.Count(n, n * 2 * sizeof(T));
+    return arrow::Status::OK();
+  }
+
+ private:
+  std::string lhs_;
+  std::string rhs_;
+};
+
+// min <= column < end on an int32 or date32 column, both bounds in one
+// fused pass (rvv::conjunction_bitmap).
+class Int32RangeFilter : public Filter {
+ public:
+  Int32RangeFilter(std::string column, int32_t min, int32_t end)
+      : column_(std::move(column)), min_(min), end_(end) {}
+
+ protected:
+  arrow::Status PushSelection(Chunk& chunk) override;
+
+ private:
+  std::string column_;
+  int32_t min_;
+  int32_t end_;
+};
+
+// min <= column <= max on a decimal column, or column < limit (Below()).
+// The bounds are converted to the column's scale; only rows still selected
+// are loaded.
+class DecimalRangeFilter : public Filter {
+ public:
+  DecimalRangeFilter(std::string column, double min, double max)
+      : column_(std::move(column)), min_(min), max_(max) {}
+
+  static std::unique_ptr<DecimalRangeFilter> Below(std::string column,
+                                                   double limit);
+
+ protected:
+  arrow::Status PushSelection(Chunk& chunk) override;
+
+ private:
+  std::string column_;
+  bool has_min_ = true;
+  double min_;
+  double max_;
+  bool max_exclusive_ = false;
+};
+
+// Inner join with a JoinBuild: drops the rows whose key misses and stores
+// the payload of the others in an int32 slot. Runs before Select().
+class JoinProbe : public Filter {
+ public:
+  JoinProbe(const JoinBuild* build, std::string key_column, int slot)
+      : build_(build), key_column_(std::move(key_column)), slot_(slot) {}
+
+ protected:
+  arrow::Status PushSelection(Chunk& chunk) override;
+
+ private:
+  const JoinBuild* build_;
+  std::string key_column_;
+  int slot_;
+};
+
+// Predicate on a dictionary string column (ScanOptions::dictionary_columns),
+// e.g. l_shipmode IN ('MAIL', 'SHIP'): entry_value runs once per dictionary
+// entry (DictionaryLookup) and rows whose entry maps to a negative value are
+// dropped. With a slot, the value of the other rows is stored in it, like a
+// JoinProbe payload. Runs before Select().
+class DictionaryFilter : public Filter {
+ public:
+  DictionaryFilter(std::string column,
+                   std::function<int32_t(std::string_view entry)> entry_value,
+                   int slot = -1)
+      : column_(std::move(column)),
+        entry_value_(std::move(entry_value)),
+        slot_(slot) {}
+
+ protected:
+  arrow::Status PushSelection(Chunk& chunk) override;
+
+ private:
+  std::string column_;
+  std::function<int32_t(std::string_view)> entry_value_;
+  int slot_;
+};
+
+// Probe side of a runtime filter (sideways information passing): collects
+// an int64 key column of the selected rows, with the int32 payload slot of
+// each, and publishes the keys as a SemiJoinFilter once the scan is done, so
+// a build scanned afterwards (JoinBuild::FilterKeys) only reads and inserts
+// what can join. Selects.
+class RuntimeFilter : public Operator {
+ public:
+  RuntimeFilter(std::string key_column, int payload_slot)
+      : key_column_(std::move(key_column)), payload_slot_(payload_slot) {}
+
+  arrow::Status Start(const ParquetScanner& file, int num_workers) override;
+  arrow::Status Push(Chunk& chunk) override;
+  arrow::Status Finish() override;
+
+  // After Finish(): the filter, and every collected row
+  const SemiJoinFilter& filter() const { return filter_; }
+  const std::vector<int64_t>& keys() const { return keys_; }
+  const std::vector<int32_t>& payloads() const { return payloads_; }
+
+ private:
+  struct Worker {
+    std::vector<int64_t> keys;
+    std::vector<int32_t> payloads;
+  };
+
+  std::string key_column_;
+  int payload_slot_;
+  SemiJoinFilter filter_;
+  std::vector<Worker> workers_;
+  std::vector<int64_t> keys_;
+  std::vector<int32_t> payloads_;
+};
+
+// Decodes a decimal column for the selected rows into a slot: unscaled
+// int32 with the column's scale for AggMode::kExact, float otherwise.
+class ProjectDecimal : public Operator {
+ public:
+  ProjectDecimal(std::string column, int slot, AggMode mode)
+      : column_(std::move(column)), slot_(slot), mode_(mode) {}
+
+  arrow::Status Push(Chunk& chunk) override;
+
+ private:
+  std::string column_;
+  int slot_;
+  AggMode mode_;
+};
+
+// GROUP BY two single-character string columns such as (l_returnflag,
+// l_linestatus): rvv::char_pair_codes packs the keys, a DenseGroupBy per
+// worker numbers the keys it meets and the ids go to an int32 slot. Before
+// Select() every row gets an id (a per-row slot, for fused aggregates that
+// apply the selection themselves), after it only the selected rows. Ids are
+// per worker, at most max_groups of them; group() maps them to the ids of
+// Finish(), which number the keys in ascending order, and a Sum grouped by
+// this operator does so itself.
+class PairGroupBy : public Operator {
+ public:
+  PairGroupBy(std::string column_a, std::string column_b, int slot,
+              int max_groups)
+      : column_a_(std::move(column_a)),
+        column_b_(std::move(column_b)),
+        slot_(slot),
+        max_groups_(max_groups) {}
+
+  arrow::Status Start(const ParquetScanner&, int num_workers) override;
+  arrow::Status Push(Chunk& chunk) override;
+  arrow::Status Finish() override;
+
+  int slot() const { return slot_; }
+  int max_groups() const { return max_groups_; }
+
+  // After Finish()
+  int num_groups() const { return static_cast<int>(codes_.size()); }
+  // The key of a group, packed as by rvv::char_pair_codes
+  int32_t code(int group) const { return codes_[group]; }
+  // The group of id local_id of worker, -1 if it has no such id
+  int group(int worker, int local_id) const {
+    return groups_[worker][local_id];
+  }
+
+ private:
+  std::string column_a_;
+  std::string column_b_;
+  int slot_;
+  int max_groups_;
+  std::vector<DenseGroupBy> workers_;
+  std::vector<int32_t> codes_;
+  std::vector<std::vector<int>> groups_;
+};
+
+enum class SumExpr {
+  kValue,               // a
+  kProduct,             // a * b
+  kMulOneMinus,         // a * (1 - b)
+  kMulOneMinusOnePlus,  // a * (1 - b) * (1 + c)
+};
+
+// SUM(expr) and COUNT(*) over decimal slots (ProjectDecimal with the same
+// mode), optionally grouped (GroupBy()). Grouped float sums scatter-add
+// into a DenseGroupSums per worker; grouped exact sums reduce each group
+// with the ungrouped exact kernels. Exact sums have scale() and are
+// unscaled.
+template <SumExpr Expr>
+class Sum : public Operator {
+ public:
+  Sum(AggMode mode, int a, int b = -1, int c = -1)
+      : mode_(mode), a_(a), b_(b), c_(c) {}
+
+  // Groups by an int32 slot of ids in [0, num_groups), e.g. a JoinProbe
+  // payload.
+  Sum* GroupBy(int slot, int num_groups) {
+    group_slot_ = slot;
+    num_groups_ = num_groups;
+    return this;
+  }
+
+  // Groups by the keys of a PairGroupBy earlier in the plan, with its
+  // group ids.
+  Sum* GroupBy(const PairGroupBy* keys) {
+    keys_ = keys;
+    return GroupBy(keys->slot(), keys->max_groups());
+  }
+
+  arrow::Status Start(const ParquetScanner&, int num_workers) override {
+    workers_.assign(num_workers, Partial(num_groups_));
+    return arrow::Status::OK();
+  }
+
+  arrow::Status Push(Chunk& chunk) override {
+    chunk.Select();
+    Partial& partial = workers_[chunk.worker()];
+    size_t n = chunk.num_selected();
+    if (n == 0) {
+      return arrow::Status::OK();
+    }
+    PhaseTimer timer(Phase::kAggregate);
+    size_t num_inputs = 1 + (b_ >= 0) + (c_ >= 0);
+    if (mode_ == AggMode::kExact) {
+      ExactInputs in;
+      in.a = chunk.values<int32_t>(a_);
+      in.b = b_ < 0 ? nullptr : chunk.values<int32_t>(b_);
+      in.c = c_ < 0 ? nullptr : chunk.values<int32_t>(c_);
+      int32_t b_scale = b_ < 0 ? 0 : chunk.slot(b_).scale;
+      int32_t c_scale = c_ < 0 ? 0 : chunk.slot(c_).scale;
+      in.one_b = static_cast<int32_t>(pow10_int128(b_scale));
+      in.one_c = static_cast<int32_t>(pow10_int128(c_scale));
+      partial.scale = ResultScale(chunk.slot(a_).scale, b_scale, c_scale);
+      if (group_slot_ < 0) {
+        partial.exact[0] += rvv::with_lmul<4>(
+            rvv::KernelClass::kReduce, [&](auto lmul) {
+              return SumExact<decltype(lmul)::value>(in, n);
+            });
+        partial.count[0] += n;
+      } else {
+        SumExactGrouped(chunk, in, &partial);
+      }
+      timer.Count(n, n * num_inputs * sizeof(int32_t));
+    } else {
+      const float* a = chunk.values<float>(a_);
+      const float* b = b_ < 0 ? nullptr : chunk.values<float>(b_);
+      const float* c = c_ < 0 ? nullptr : chunk.values<float>(c_);
+      if (group_slot_ < 0) {
+        partial.approx[0] += SumFloat(chunk, a, b, c, n);
+        partial.count[0] += n;
+      } else {
+        partial.sums.Add(chunk.values<int32_t>(group_slot_),
+                         FloatValues(chunk, a, b, c, n), n);
+      }
+      timer.Count(n, n * num_inputs * sizeof(float));
+    }
+    return arrow::Status::OK();
+  }
+
+  arrow::Status Finish() override {
+    total_ = Partial(keys_ ? keys_->num_groups() : num_groups_);
+    for (size_t w = 0; w < workers_.size(); w++) {
+      const Partial& partial = workers_[w];
+      for (int g = 0; g < num_groups_; g++) {
+        int into = keys_ ? keys_->group(static_cast<int>(w), g) : g;
+        if (into < 0) {
+          continue;
+        }
+        total_.exact[into] += partial.exact[g];
+        total_.approx[into] += partial.approx[g] + partial.sums.sum(g);
+        total_.count[into] += partial.count[g] + partial.sums.count(g);
+      }
+      if (partial.scale >= 0) {
+        total_.scale = partial.scale;
+      }
+    }
+    return arrow::Status::OK();
+  }
+
+  // After Finish()
+  Int128 exact(int group = 0) const { return total_.exact[group]; }
+  double approx(int group = 0) const { return total_.approx[group]; }
+  int64_t count(int group = 0) const { return total_.count[group]; }
+  int32_t scale() const { return total_.scale < 0 ? 0 : total_.scale; }
+
+  // The sum divided by divisor (e.g. count() for AVG) with digits
+  // decimals, in either mode.
+  std::string Format(int group = 0, int digits = 2,
+                     int64_t divisor = 1) const {
+    if (mode_ == AggMode::kExact) {
+      return format_fixed(exact(group), scale(), digits, divisor);
+    }
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(digits) << approx(group) / divisor;
+    return out.str();
+  }
+
+ private:
+  struct Partial {
+    explicit Partial(int num_groups = 0)
+        : exact(num_groups, 0), approx(num_groups, 0.0),
+          count(num_groups, 0), sums(num_groups) {}
+    std::vector<Int128> exact;
+    std::vector<double> approx;
+    std::vector<int64_t> count;
+    // Grouped float sums and counts, on top of approx and count
+    DenseGroupSums sums;
+    // -1 until a chunk was summed
+    int32_t scale = -1;
+  };
+
+  // Unscaled inputs; one_b and one_c are 1 at the scales of b and c
+  struct ExactInputs {
+    const int32_t* a = nullptr;
+    const int32_t* b = nullptr;
+    const int32_t* c = nullptr;
+    int32_t one_b = 1;
+    int32_t one_c = 1;
+  };
+
+  static int32_t ResultScale(int32_t a_scale, int32_t b_scale,
+                             int32_t c_scale) {
+    switch (Expr) {
+      case SumExpr::kValue:
+        return a_scale;
+      case SumExpr::kProduct:
+      case SumExpr::kMulOneMinus:
+        return a_scale + b_scale;
+      case SumExpr::kMulOneMinusOnePlus:
+        return a_scale + b_scale + c_scale;
+    }
+    return 0;
+  }
+
+  template <int L>
+  static Int128 SumExact(const ExactInputs& in, size_t n) {
+    switch (Expr) {
+      case SumExpr::kValue:
+        return rvv::sum_exact<L>(in.a, n);
+      case SumExpr::kProduct:
+        return rvv::dot_exact<L>(in.a, in.b, n);
+      case SumExpr::kMulOneMinus:
+        return rvv::sum_mul_one_minus_exact<L>(in.a, in.b, in.one_b, n);
+      case SumExpr::kMulOneMinusOnePlus:
+        return rvv::sum_mul_one_minus_one_plus_exact<L>(in.a, in.b, in.one_b,
+                                                        in.c, in.one_c, n);
+    }
+    return 0;
+  }
+
+  // One pass per group that occurs in the chunk: its rows become a
+  // selection vector, their inputs are gathered and summed by the
+  // ungrouped exact kernel. The next group is that of the first row not
+  // summed yet, so a chunk costs as many passes as it has groups; meant for
+  // the handful of groups of an aggregate such as Q12's or Q14's.
+  void SumExactGrouped(Chunk& chunk, const ExactInputs& in,
+                       Partial* partial) const {
+    const int32_t* groups = chunk.values<int32_t>(group_slot_);
+    size_t n = chunk.num_selected();
+    uint8_t* members = chunk.Allocate<uint8_t>((n + 7) / 8);
+    int32_t* rows = chunk.Allocate<int32_t>(n);
+    ExactInputs gathered = in;
+    int32_t* a = chunk.Allocate<int32_t>(n);
+    int32_t* b = in.b ? chunk.Allocate<int32_t>(n) : nullptr;
+    int32_t* c = in.c ? chunk.Allocate<int32_t>(n) : nullptr;
+    gathered.a = a;
+    gathered.b = b;
+    gathered.c = c;
+    uint8_t* summed = chunk.Allocate<uint8_t>(num_groups_);
+    std::fill(summed, summed + num_groups_, 0);
+    rvv::with_lmul<4>(rvv::KernelClass::kReduce, [&](auto lmul) {
+      constexpr int L = decltype(lmul)::value;
+      for (size_t next = 0;; next++) {
+        while (next < n && summed[groups[next]]) {
+          next++;
+        }
+        if (next == n) {
+          break;
+        }
+        int32_t g = groups[next];
+        summed[g] = 1;
+        rvv::compare_scalar_bitmap<int32_t, rvv::CmpOp::kEq, L>(
+            groups, g, members, 0, n);
+        size_t m = rvv::bitmap_to_selection<L>(members, n, rows);
+        if (m == n) {
+          partial->exact[g] += SumExact<L>(in, n);
+        } else {
+          rvv::gather_int32<L>(in.a, rows, a, m);
+          if (b) {
+            rvv::gather_int32<L>(in.b, rows, b, m);
+          }
+          if (c) {
+            rvv::gather_int32<L>(in.c, rows, c, m);
+          }
+          partial->exact[g] += SumExact<L>(gathered, m);
+        }
+        partial->count[g] += m;
+      }
+    });
+  }
+
+  // expr per row, computed into the chunk's scratch unless it is just a
+  static const float* FloatValues(Chunk& chunk, const float* a,
+                                  const float* b, const float* c, size_t n) {
+    if (Expr == SumExpr::kValue) {
+      return a;
+    }
+    float* values = chunk.Allocate<float>(n);
+    rvv::with_lmul(rvv::KernelClass::kArith, [&](auto lmul) {
+      constexpr int L = decltype(lmul)::value;
+      if (Expr == SumExpr::kProduct) {
+        rvv::mul<float, L>(a, b, values, n);
+        return;
+      }
+      rvv::mul_one_minus<float, L>(a, b, values, n);
+      if (Expr == SumExpr::kMulOneMinusOnePlus) {
+        rvv::mul_one_plus<float, L>(values, c, values, n);
+      }
+    });
+    return values;
+  }
+
+  static double SumFloat(Chunk& chunk, const float* a, const float* b,
+                         const float* c, size_t n) {
+    if (Expr == SumExpr::kProduct) {
+      return rvv::with_lmul(rvv::KernelClass::kReduce, [&](auto lmul) {
+        return rvv::dot<float, decltype(lmul)::value>(a, b, n);
+      });
+    }
+    const float* values = FloatValues(chunk, a, b, c, n);
+    return rvv::with_lmul(rvv::KernelClass::kReduce, [&](auto lmul) {
+      return rvv::sum<float, decltype(lmul)::value>(values, n);
+    });
+  }
+
+  AggMode mode_;
+  int a_;
+  int b_;
+  int c_;
+  int group_slot_ = -1;
+  int num_groups_ = 1;
+  const PairGroupBy* keys_ = nullptr;
+  std::vector<Partial> workers_;
+  Partial total_;
+};
@@ -0,0 +1,84 @@
+#include "parallel_scan.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+int ResolveThreadCount(int requested) {
+  if (requested > 0) {
+    return requested;
+  }
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+arrow::Status ParallelScan(const std::string& file_path,
+                           const ScanOptions& options, int num_threads,
+                           const MorselFn& fn, ScanStats* stats) {
+  std::atomic<int> next_row_group{0};
+
+  std::vector<std::unique_ptr<ParquetScanner>> scanners;
+  std::unique_ptr<ParquetScanner> first;
+  ARROW_ASSIGN_OR_RAISE(first, ParquetScanner::Open(file_path, options));
+  num_threads = std::max(1, std::min(num_threads, first->num_row_groups()));
+  // The other workers reuse the footer the first one parsed
+  ScanOptions worker_options = options;
+  worker_options.metadata = first->metadata();
+  scanners.push_back(std::move(first));
+  for (int w = 1; w < num_threads; w++) {
+    std::unique_ptr<ParquetScanner> scanner;
+    ARROW_ASSIGN_OR_RAISE(scanner,
+                          ParquetScanner::Open(file_path, worker_options));
+    scanners.push_back(std::move(scanner));
+  }
+  for (auto& scanner : scanners) {
+    scanner->share_row_groups(&next_row_group);
+  }
+
+  std::atomic<bool> failed{false};
+  std::vector<arrow::Status> statuses(num_threads);
+  auto work = [&](int worker) {
+    ParquetScanner& scanner = *scanners[worker];
+    while (!failed.load(std::memory_order_relaxed)) {
+      auto maybe_batch = scanner.Next();
+      arrow::Status st = maybe_batch.status();
+      if (st.ok()) {
+        if (!*maybe_batch) {
+          return;
+        }
+        st = fn(worker, scanner, *maybe_batch);
+      }
+      if (!st.ok()) {
+        statuses[worker] = st;
+        failed.store(true, std::memory_order_relaxed);
+        return;
+      }
+    }
+  };
+
+  if (num_threads == 1) {
+    work(0);
+  } else {
+    std::vector<std::thread> threads;
+    for (int w = 0; w < num_threads; w++) {
+      threads.emplace_back(work, w);
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  for (const auto& st : statuses) {
+    ARROW_RETURN_NOT_OK(st);
+  }
+  if (stats) {
+    *stats = ScanStats();
+    stats->num_row_groups = scanners[0]->num_row_groups();
+    for (const auto& scanner : scanners) {
+      stats->row_groups_skipped += scanner->row_groups_skipped();
+      stats->rows_read += scanner->rows_read();
+    }
+  }
+  return arrow::Status::OK();
+}
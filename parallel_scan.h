@@ -0,0 +1,41 @@
+// Morsel-driven parallel scan.
+//
+// Worker threads each own a ParquetScanner over the same file and claim row
+// groups from a shared counter; every batch they decode is a morsel (row
+// group, row range) handed to the callback together with the worker index.
+// Callers keep one aggregate state per worker, indexed by that argument, and
+// merge the states once ParallelScan returns. No locking is needed as long
+// as a callback only touches its own worker's state.
+#pragma once
+
+#include "parquet_scan.h"
+
+#include <arrow/record_batch.h>
+#include <arrow/status.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+using MorselFn = std::function<arrow::Status(
+    int worker, const ParquetScanner& scanner,
+    const std::shared_ptr<arrow::RecordBatch>& batch)>;
+
+struct ScanStats {
+  int num_row_groups = 0;
+  int row_groups_skipped = 0;
+  int64_t rows_read = 0;
+};
+
+// Thread count to use for a requested count; <= 0 means one per hardware
+// thread.
+int ResolveThreadCount(int requested);
+
+// Runs fn on every batch of file_path with up to num_threads workers (never
+// more than there are row groups). num_threads must already be resolved;
+// the workers used are 0 .. num_threads - 1. Stops at the first error,
+// which is returned.
+arrow::Status ParallelScan(const std::string& file_path,
+                           const ScanOptions& options, int num_threads,
+                           const MorselFn& fn, ScanStats* stats = nullptr);
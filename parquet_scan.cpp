@@ -0,0 +1,607 @@
+#include "parquet_scan.h"
+
+#include <arrow/io/api.h>
+#include <arrow/util/byte_size.h>
+#include <arrow/util/thread_pool.h>
+#include <parquet/file_reader.h>
+#include <parquet/metadata.h>
+#include <parquet/properties.h>
+#include <parquet/statistics.h>
+
+#include "column_cache.h"
+#include "query_profile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+namespace {
+
+// What pruning uses of a column chunk: Parquet statistics or a cache zone
+// map.
+struct ChunkStats {
+  bool has_range = false;  // min and max are set
+  bool int32 = false;      // INT32-backed, so Int32Range applies
+  bool no_nulls = false;
+  int64_t min = 0;
+  int64_t max = 0;
+};
+
+ChunkStats ParquetChunkStats(const parquet::ColumnChunkMetaData& chunk) {
+  ChunkStats result;
+  auto stats = chunk.statistics();
+  if (!stats || !stats->HasMinMax()) {
+    return result;
+  }
+  switch (stats->physical_type()) {
+    case parquet::Type::INT32: {
+      const auto& typed = static_cast<const parquet::Int32Statistics&>(*stats);
+      result.min = typed.min();
+      result.max = typed.max();
+      result.int32 = true;
+      break;
+    }
+    case parquet::Type::INT64: {
+      const auto& typed = static_cast<const parquet::Int64Statistics&>(*stats);
+      result.min = typed.min();
+      result.max = typed.max();
+      break;
+    }
+    default:
+      return result;
+  }
+  result.has_range = true;
+  result.no_nulls = stats->HasNullCount() && stats->null_count() == 0;
+  return result;
+}
+
+ChunkStats CacheChunkStats(const ColumnCache& cache, int block, int column) {
+  ChunkStats result;
+  result.has_range = cache.BlockRange(block, column, &result.min, &result.max);
+  ColumnCache::Kind kind = cache.column(column).kind;
+  result.int32 = kind == ColumnCache::Kind::kInt32 ||
+                 kind == ColumnCache::Kind::kDate32;
+  result.no_nulls = true;  // caches have none
+  return result;
+}
+
+// Classifies one column chunk against min <= value <= max. Without usable
+// statistics nothing can be ruled out, so the answer is kSome.
+RowGroupMatch MatchColumnChunk(const ChunkStats& stats,
+                               const Int32Range& range) {
+  if (!stats.has_range || !stats.int32) {
+    return RowGroupMatch::kSome;
+  }
+  if (stats.max < range.min || stats.min > range.max) {
+    return RowGroupMatch::kNone;
+  }
+  // A null never satisfies a comparison, so kAll also needs a null count of
+  // zero.
+  if (stats.no_nulls && stats.min >= range.min && stats.max <= range.max) {
+    return RowGroupMatch::kAll;
+  }
+  return RowGroupMatch::kSome;
+}
+
+// Bytes of a column chunk in the file: the dictionary page, if any, comes
+// before the data pages.
+arrow::io::ReadRange ChunkBytes(const parquet::ColumnChunkMetaData& chunk) {
+  int64_t offset = chunk.data_page_offset();
+  if (chunk.has_dictionary_page() && chunk.dictionary_page_offset() > 0) {
+    offset = std::min(offset, chunk.dictionary_page_offset());
+  }
+  return {offset, chunk.total_compressed_size()};
+}
+
+arrow::Result<std::shared_ptr<arrow::io::RandomAccessFile>> OpenInput(
+    const std::string& file_path, InputMode mode, arrow::MemoryPool* pool) {
+  if (mode == InputMode::kMmap) {
+    return arrow::io::MemoryMappedFile::Open(file_path,
+                                             arrow::io::FileMode::READ);
+  }
+  return arrow::io::ReadableFile::Open(file_path, pool);
+}
+
+// Per row group: whether the prune predicates and key filters of options
+// can hold, from the stats of column col_idx in row group rg.
+arrow::Result<std::vector<RowGroupMatch>> MatchPredicates(
+    int num_row_groups,
+    const std::function<int(const std::string& column)>& column_index,
+    const std::function<ChunkStats(int rg, int col_idx)>& chunk_stats,
+    const ScanOptions& options, const std::string& file_path) {
+  std::vector<RowGroupMatch> match(num_row_groups,
+                                   options.prune.empty() ? RowGroupMatch::kSome
+                                                         : RowGroupMatch::kAll);
+  for (const auto& range : options.prune) {
+    int col_idx = column_index(range.column);
+    if (col_idx < 0) {
+      return arrow::Status::Invalid("Column not found in ", file_path, ": ",
+                                    range.column);
+    }
+    for (int rg = 0; rg < num_row_groups; rg++) {
+      RowGroupMatch m = MatchColumnChunk(chunk_stats(rg, col_idx), range);
+      // AND of the predicates: kNone dominates, kAll needs every one
+      if (m == RowGroupMatch::kNone || match[rg] == RowGroupMatch::kNone) {
+        match[rg] = RowGroupMatch::kNone;
+      } else if (m == RowGroupMatch::kSome) {
+        match[rg] = RowGroupMatch::kSome;
+      }
+    }
+  }
+
+  for (const auto& filter : options.key_filters) {
+    int col_idx = column_index(filter.column);
+    if (col_idx < 0) {
+      return arrow::Status::Invalid("Column not found in ", file_path, ": ",
+                                    filter.column);
+    }
+    for (int rg = 0; rg < num_row_groups; rg++) {
+      if (match[rg] == RowGroupMatch::kNone) {
+        continue;
+      }
+      ChunkStats stats = chunk_stats(rg, col_idx);
+      if (stats.has_range && !filter.may_match(stats.min, stats.max)) {
+        match[rg] = RowGroupMatch::kNone;
+      }
+    }
+  }
+  return match;
+}
+
+arrow::Result<std::vector<RowGroupMatch>> MatchParquet(
+    const parquet::FileMetaData& metadata, const ScanOptions& options,
+    const std::string& file_path) {
+  return MatchPredicates(
+      metadata.num_row_groups(),
+      [&](const std::string& column) {
+        return metadata.schema()->ColumnIndex(column);
+      },
+      [&](int rg, int col_idx) {
+        return ParquetChunkStats(*metadata.RowGroup(rg)->ColumnChunk(col_idx));
+      },
+      options, file_path);
+}
+
+arrow::Result<std::vector<RowGroupMatch>> MatchCache(
+    const ColumnCache& cache, const ScanOptions& options,
+    const std::string& file_path) {
+  return MatchPredicates(
+      cache.num_blocks(),
+      [&](const std::string& column) { return cache.ColumnIndex(column); },
+      [&](int block, int column) {
+        return CacheChunkStats(cache, block, column);
+      },
+      options, file_path);
+}
+
+// Skips the row groups options.read_row_groups leaves out.
+arrow::Status ApplyReadMask(const ScanOptions& options,
+                            const std::string& file_path,
+                            std::vector<RowGroupMatch>* match) {
+  if (options.read_row_groups.empty()) {
+    return arrow::Status::OK();
+  }
+  if (options.read_row_groups.size() != match->size()) {
+    return arrow::Status::Invalid("read_row_groups has ",
+                                  options.read_row_groups.size(), " entries, ",
+                                  file_path, " has ", match->size(),
+                                  " row groups");
+  }
+  for (size_t rg = 0; rg < match->size(); rg++) {
+    if (!options.read_row_groups[rg]) {
+      (*match)[rg] = RowGroupMatch::kNone;
+    }
+  }
+  return arrow::Status::OK();
+}
+
+}  // namespace
+
+ParquetScanner::ParquetScanner(
+    std::string file_path,
+    std::shared_ptr<arrow::io::RandomAccessFile> input_file,
+    std::unique_ptr<parquet::arrow::FileReader> reader,
+    std::vector<int> column_indices, std::vector<RowGroupMatch> match,
+    const InputOptions& input)
+    : file_path_(std::move(file_path)),
+      input_file_(std::move(input_file)),
+      reader_(std::move(reader)),
+      column_indices_(std::move(column_indices)),
+      match_(std::move(match)),
+      will_need_(input.mode == InputMode::kMmap),
+      advised_(match_.size(), false),
+      prefetch_depth_(input.prefetch_row_groups) {}
+
+ParquetScanner::~ParquetScanner() {
+  std::unique_lock<std::mutex> lock(prefetch_mutex_);
+  stopping_ = true;
+  prefetch_cv_.wait(lock, [this] { return !producer_running_; });
+}
+
+arrow::Result<std::unique_ptr<ParquetScanner>> ParquetScanner::Open(
+    const std::string& file_path, const ScanOptions& options,
+    arrow::MemoryPool* pool) {
+  PhaseTimer timer(Phase::kIo);
+  std::shared_ptr<arrow::io::RandomAccessFile> input_file;
+  ARROW_ASSIGN_OR_RAISE(input_file,
+                        OpenInput(file_path, options.input.mode, pool));
+  ARROW_ASSIGN_OR_RAISE(bool is_cache,
+                        ColumnCache::IsCacheFile(input_file.get()));
+  if (is_cache) {
+    ARROW_RETURN_NOT_OK(input_file->Close());
+    return OpenCache(file_path, options);
+  }
+
+  parquet::ReaderProperties reader_properties(pool);
+  if (options.input.buffered_stream_size > 0) {
+    reader_properties.enable_buffered_stream();
+    reader_properties.set_buffer_size(options.input.buffered_stream_size);
+  }
+  parquet::arrow::FileReaderBuilder builder;
+  ARROW_RETURN_NOT_OK(
+      builder.Open(input_file, reader_properties, options.metadata));
+  const parquet::SchemaDescriptor* schema =
+      builder.raw_reader()->metadata()->schema();
+
+  parquet::ArrowReaderProperties properties;
+  properties.set_batch_size(options.batch_size);
+  properties.set_pre_buffer(options.input.pre_buffer);
+  for (const auto& col_name : options.dictionary_columns) {
+    int col_idx = schema->ColumnIndex(col_name);
+    if (col_idx < 0) {
+      return arrow::Status::Invalid("Column not found in ", file_path, ": ",
+                                    col_name);
+    }
+    properties.set_read_dictionary(col_idx, true);
+  }
+  std::unique_ptr<parquet::arrow::FileReader> reader;
+  ARROW_RETURN_NOT_OK(
+      builder.memory_pool(pool)->properties(properties)->Build(&reader));
+
+  std::vector<int> column_indices;
+  if (options.columns.empty()) {
+    for (int i = 0; i < schema->num_columns(); i++) {
+      column_indices.push_back(i);
+    }
+  }
+  for (const auto& col_name : options.columns) {
+    int col_idx = schema->ColumnIndex(col_name);
+    if (col_idx < 0) {
+      return arrow::Status::Invalid("Column not found in ", file_path, ": ",
+                                    col_name);
+    }
+    column_indices.push_back(col_idx);
+  }
+
+  auto metadata = reader->parquet_reader()->metadata();
+  std::vector<RowGroupMatch> match;
+  ARROW_ASSIGN_OR_RAISE(match, MatchParquet(*metadata, options, file_path));
+  ARROW_RETURN_NOT_OK(ApplyReadMask(options, file_path, &match));
+
+  return std::unique_ptr<ParquetScanner>(new ParquetScanner(
+      file_path, std::move(input_file), std::move(reader),
+      std::move(column_indices), std::move(match), options.input));
+}
+
+arrow::Result<std::unique_ptr<ParquetScanner>> ParquetScanner::OpenCache(
+    const std::string& file_path, const ScanOptions& options) {
+  std::shared_ptr<ColumnCache> cache;
+  ARROW_ASSIGN_OR_RAISE(cache, ColumnCache::Open(file_path));
+  std::vector<int> column_indices;
+  if (options.columns.empty()) {
+    for (int i = 0; i < cache->num_columns(); i++) {
+      column_indices.push_back(i);
+    }
+  }
+  for (const auto& col_name : options.columns) {
+    int col_idx = cache->ColumnIndex(col_name);
+    if (col_idx < 0) {
+      return arrow::Status::Invalid("Column not found in ", file_path, ": ",
+                                    col_name);
+    }
+    column_indices.push_back(col_idx);
+  }
+  // File order, as the Parquet reader hands them out
+  std::sort(column_indices.begin(), column_indices.end());
+  std::vector<bool> as_dictionary(column_indices.size(), false);
+  for (const auto& col_name : options.dictionary_columns) {
+    int col_idx = cache->ColumnIndex(col_name);
+    if (col_idx < 0) {
+      return arrow::Status::Invalid("Column not found in ", file_path, ": ",
+                                    col_name);
+    }
+    for (size_t i = 0; i < column_indices.size(); i++) {
+      if (column_indices[i] == col_idx) {
+        as_dictionary[i] = true;
+      }
+    }
+  }
+
+  std::vector<RowGroupMatch> match;
+  ARROW_ASSIGN_OR_RAISE(match, MatchCache(*cache, options, file_path));
+  ARROW_RETURN_NOT_OK(ApplyReadMask(options, file_path, &match));
+
+  // Always mapped, and nothing to decode ahead
+  InputOptions input;
+  input.mode = InputMode::kMmap;
+  std::unique_ptr<ParquetScanner> scanner(
+      new ParquetScanner(file_path, cache->file(), nullptr,
+                         std::move(column_indices), std::move(match), input));
+  scanner->cache_ = std::move(cache);
+  scanner->cache_dictionary_ = std::move(as_dictionary);
+  scanner->batch_size_ = options.batch_size;
+  return scanner;
+}
+
+arrow::Result<std::shared_ptr<arrow::RecordBatch>> ParquetScanner::Next() {
+  if (cache_) {
+    return NextCached();
+  }
+  if (prefetch_depth_ > 0) {
+    return NextPrefetched();
+  }
+  PhaseTimer timer(Phase::kIo);
+  while (true) {
+    if (batch_reader_) {
+      std::shared_ptr<arrow::RecordBatch> batch;
+      ARROW_RETURN_NOT_OK(batch_reader_->ReadNext(&batch));
+      if (batch) {
+        rows_read_ += batch->num_rows();
+        timer.Count(batch->num_rows(), arrow::util::TotalBufferSize(*batch));
+        return batch;
+      }
+      batch_reader_.reset();
+    }
+    int row_group = ClaimRowGroup();
+    if (row_group < 0) {
+      return nullptr;
+    }
+    current_row_group_ = row_group;
+    if (will_need_) {
+      ARROW_RETURN_NOT_OK(WillNeedFrom(current_row_group_));
+    }
+    ARROW_RETURN_NOT_OK(reader_->GetRecordBatchReader(
+        {current_row_group_}, column_indices_, &batch_reader_));
+  }
+}
+
+arrow::Result<std::shared_ptr<arrow::RecordBatch>>
+ParquetScanner::NextCached() {
+  PhaseTimer timer(Phase::kIo);
+  while (next_batch_ == current_batches_.size()) {
+    current_batches_.clear();
+    next_batch_ = 0;
+    int row_group = ClaimRowGroup();
+    if (row_group < 0) {
+      return nullptr;
+    }
+    current_row_group_ = row_group;
+    ARROW_RETURN_NOT_OK(WillNeedFrom(current_row_group_));
+    std::shared_ptr<arrow::RecordBatch> block;
+    ARROW_ASSIGN_OR_RAISE(block, cache_->ReadBlock(current_row_group_,
+                                                   column_indices_,
+                                                   cache_dictionary_));
+    if (block->num_rows() <= batch_size_) {
+      current_batches_.push_back(std::move(block));
+      continue;
+    }
+    for (int64_t offset = 0; offset < block->num_rows();
+         offset += batch_size_) {
+      current_batches_.push_back(block->Slice(offset, batch_size_));
+    }
+  }
+  std::shared_ptr<arrow::RecordBatch> batch =
+      std::move(current_batches_[next_batch_++]);
+  rows_read_ += batch->num_rows();
+  // Bytes referenced in the mapping; the kernels fault them in
+  timer.Count(batch->num_rows(), arrow::util::TotalBufferSize(*batch));
+  return batch;
+}
+
+int ParquetScanner::ClaimRowGroup() {
+  while (true) {
+    int row_group = shared_next_row_group_
+                        ? shared_next_row_group_->fetch_add(1)
+                        : next_row_group_++;
+    if (row_group >= num_row_groups()) {
+      return -1;
+    }
+    if (match_[row_group] != RowGroupMatch::kNone) {
+      return row_group;
+    }
+    row_groups_skipped_++;
+  }
+}
+
+std::vector<arrow::io::ReadRange> ParquetScanner::ProjectedRanges(
+    int row_group) const {
+  if (cache_) {
+    std::vector<arrow::io::ReadRange> ranges;
+    for (int col_idx : column_indices_) {
+      for (const auto& range : cache_->ColumnBytes(row_group, col_idx)) {
+        ranges.push_back(range);
+      }
+    }
+    return ranges;
+  }
+  auto row_group_metadata =
+      reader_->parquet_reader()->metadata()->RowGroup(row_group);
+  std::vector<arrow::io::ReadRange> ranges;
+  for (int col_idx : column_indices_) {
+    ranges.push_back(ChunkBytes(*row_group_metadata->ColumnChunk(col_idx)));
+  }
+  return ranges;
+}
+
+arrow::Status ParquetScanner::WillNeed(int row_group) {
+  if (advised_[row_group]) {
+    return arrow::Status::OK();
+  }
+  advised_[row_group] = true;
+  return input_file_->WillNeed(ProjectedRanges(row_group));
+}
+
+arrow::Status ParquetScanner::WillNeedFrom(int row_group) {
+  ARROW_RETURN_NOT_OK(WillNeed(row_group));
+  // Without a shared counter the next row group is known: let its pages
+  // come in while this one decodes
+  if (!shared_next_row_group_) {
+    int next = row_group + 1;
+    while (next < num_row_groups() && match_[next] == RowGroupMatch::kNone) {
+      next++;
+    }
+    if (next < num_row_groups()) {
+      ARROW_RETURN_NOT_OK(WillNeed(next));
+    }
+  }
+  return arrow::Status::OK();
+}
+
+arrow::Result<std::shared_ptr<arrow::RecordBatch>>
+ParquetScanner::NextPrefetched() {
+  while (next_batch_ == current_batches_.size()) {
+    current_batches_.clear();
+    next_batch_ = 0;
+    std::unique_lock<std::mutex> lock(prefetch_mutex_);
+    ARROW_RETURN_NOT_OK(StartProducer());
+    // Time the consumer waits is what the pipeline failed to hide
+    auto start = std::chrono::steady_clock::now();
+    prefetch_cv_.wait(
+        lock, [this] { return !prefetched_.empty() || producer_done_; });
+    QueryProfile::Global().AddPrefetch(std::chrono::nanoseconds(0),
+                                       std::chrono::steady_clock::now() -
+                                           start);
+    if (prefetched_.empty()) {
+      ARROW_RETURN_NOT_OK(producer_status_);
+      return nullptr;
+    }
+    current_row_group_ = prefetched_.front().row_group;
+    current_batches_ = std::move(prefetched_.front().batches);
+    prefetched_.pop_front();
+    // Refill the slot just taken
+    ARROW_RETURN_NOT_OK(StartProducer());
+  }
+  std::shared_ptr<arrow::RecordBatch> batch =
+      std::move(current_batches_[next_batch_++]);
+  rows_read_ += batch->num_rows();
+  return batch;
+}
+
+arrow::Status ParquetScanner::StartProducer() {
+  if (producer_running_ || producer_done_ ||
+      static_cast<int>(prefetched_.size()) >= prefetch_depth_) {
+    return arrow::Status::OK();
+  }
+  producer_running_ = true;
+  arrow::Status st =
+      arrow::internal::GetCpuThreadPool()->Spawn([this] { Produce(); });
+  if (!st.ok()) {
+    producer_running_ = false;
+  }
+  return st;
+}
+
+void ParquetScanner::Produce() {
+  PhaseTimer timer(Phase::kIo);
+  arrow::Status status;
+  bool done = false;
+  while (true) {
+    {
+      std::lock_guard<std::mutex> lock(prefetch_mutex_);
+      if (stopping_ ||
+          static_cast<int>(prefetched_.size()) >= prefetch_depth_) {
+        break;
+      }
+    }
+    int row_group = lookahead_ >= 0 ? lookahead_ : ClaimRowGroup();
+    lookahead_ = row_group >= 0 ? ClaimRowGroup() : -1;
+    if (lookahead_ >= 0) {
+      // Only a hint: if it fails, the decode reads the pages itself
+      status = arrow::io::default_io_context().executor()->Spawn(
+          [input_file = input_file_, ranges = ProjectedRanges(lookahead_)] {
+            (void)input_file->WillNeed(ranges);
+          });
+      if (!status.ok()) {
+        break;
+      }
+    }
+    if (row_group < 0) {
+      done = true;
+      break;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    DecodedRowGroup decoded{row_group, {}};
+    std::unique_ptr<arrow::RecordBatchReader> batch_reader;
+    status = reader_->GetRecordBatchReader({row_group}, column_indices_,
+                                           &batch_reader);
+    while (status.ok()) {
+      std::shared_ptr<arrow::RecordBatch> batch;
+      status = batch_reader->ReadNext(&batch);
+      if (!status.ok() || !batch) {
+        break;
+      }
+      timer.Count(batch->num_rows(), arrow::util::TotalBufferSize(*batch));
+      decoded.batches.push_back(std::move(batch));
+    }
+    if (!status.ok()) {
+      break;
+    }
+    QueryProfile::Global().AddPrefetch(std::chrono::steady_clock::now() - start,
+                                       std::chrono::nanoseconds(0));
+
+    std::lock_guard<std::mutex> lock(prefetch_mutex_);
+    prefetched_.push_back(std::move(decoded));
+    prefetch_cv_.notify_all();
+  }
+  std::lock_guard<std::mutex> lock(prefetch_mutex_);
+  if (!status.ok()) {
+    producer_status_ = status;
+    done = true;
+  }
+  producer_done_ = producer_done_ || done;
+  producer_running_ = false;
+  prefetch_cv_.notify_all();
+}
+
+bool ParquetScanner::ColumnRange(const std::string& column, int64_t* min,
+                                 int64_t* max) const {
+  int col_idx = cache_ ? cache_->ColumnIndex(column)
+                       : metadata()->schema()->ColumnIndex(column);
+  if (col_idx < 0 || num_row_groups() == 0) {
+    return false;
+  }
+  for (int rg = 0; rg < num_row_groups(); rg++) {
+    ChunkStats stats =
+        cache_ ? CacheChunkStats(*cache_, rg, col_idx)
+               : ParquetChunkStats(*metadata()->RowGroup(rg)->ColumnChunk(
+                     col_idx));
+    if (!stats.has_range) {
+      return false;
+    }
+    *min = rg == 0 ? stats.min : std::min(*min, stats.min);
+    *max = rg == 0 ? stats.max : std::max(*max, stats.max);
+  }
+  return true;
+}
+
+arrow::Result<std::vector<RowGroupMatch>> ParquetScanner::MatchRowGroups(
+    const ScanOptions& options) const {
+  if (cache_) {
+    return MatchCache(*cache_, options, file_path_);
+  }
+  return MatchParquet(*metadata(), options, file_path_);
+}
+
+std::shared_ptr<parquet::FileMetaData> ParquetScanner::metadata() const {
+  return cache_ ? nullptr : reader_->parquet_reader()->metadata();
+}
+
+int ParquetScanner::num_row_groups() const {
+  return cache_ ? cache_->num_blocks() : reader_->num_row_groups();
+}
+
+int64_t ParquetScanner::num_rows() const {
+  return cache_ ? cache_->num_rows()
+                : reader_->parquet_reader()->metadata()->num_rows();
+}
@@ -0,0 +1,245 @@
+// Streaming Parquet scan shared by the rvv_query* binaries.
+//
+// The scanner reads one row group at a time through
+// FileReader::GetRecordBatchReader, decoding only the projected columns, and
+// hands out record batches of at most batch_size rows. Batches never span row
+// groups. Peak memory is one batch per projected column instead of the whole
+// table that ReadTable() would materialize.
+//
+// Row groups can also be pruned up front from their column-chunk min/max
+// statistics: a row group whose range cannot satisfy a predicate is never
+// decoded, and one whose every row satisfies all predicates is flagged so the
+// caller can skip evaluating them. Key filters published by a join build
+// side prune the same way on the key column's range.
+//
+// The file is read with pread into the memory pool by default, or mapped
+// (InputOptions): then page reads are left to the kernel, and each row group
+// about to be decoded gets an madvise(WILLNEED) on its projected column
+// chunks only.
+//
+// With InputOptions::prefetch_row_groups > 0 the scan is pipelined: a
+// producer task on Arrow's CPU thread pool decodes whole row groups ahead of
+// the consumer into a queue of that many row groups, and asks the IO thread
+// pool to page in the row group after the one it is decoding. While the
+// caller runs its kernels on row group N, N + 1 decodes and N + 2 is read.
+// The queue is bounded, so memory stays at a few decoded row groups of the
+// projected columns.
+//
+// A column cache file (column_cache.h) is accepted in place of Parquet
+// wherever a scanner opens one: its blocks are the row groups, its zone maps
+// the statistics, and batches are zero-copy views of the mapped file, so
+// there is nothing to decode or prefetch.
+#pragma once
+
+#include <arrow/io/interfaces.h>
+#include <arrow/memory_pool.h>
+#include <arrow/record_batch.h>
+#include <arrow/result.h>
+#include <arrow/status.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/metadata.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+constexpr int64_t kDefaultScanBatchSize = 64 * 1024;
+
+class ColumnCache;
+
+// min <= column <= max on an INT32-backed (e.g. date32) column. Use
+// INT32_MIN / INT32_MAX for an open end.
+struct Int32Range {
+  std::string column;
+  int32_t min;
+  int32_t max;
+};
+
+enum class RowGroupMatch {
+  kNone,  // no row can satisfy the predicates; the row group is skipped
+  kSome,  // the predicates must be evaluated per row
+  kAll,   // every row satisfies every predicate
+};
+
+// Runtime filter on an INT32 or INT64 key column, e.g. the keys of a join
+// build side (SemiJoinFilter::ScanFilter). A row group is skipped when
+// may_match(min, max) is false for its key statistics. Unlike prune this
+// never makes a row group kAll: surviving rows still need probing.
+struct KeyFilter {
+  std::string column;
+  std::function<bool(int64_t min, int64_t max)> may_match;
+};
+
+enum class InputMode {
+  kRead,  // ReadableFile: pread copies into the memory pool
+  kMmap,  // MemoryMappedFile: column chunks are decoded in place
+};
+
+struct InputOptions {
+  InputMode mode = InputMode::kRead;
+  // When > 0, column chunks are read through a buffer of this many bytes
+  // instead of whole (ReaderProperties::enable_buffered_stream).
+  int64_t buffered_stream_size = 0;
+  // Coalesce the reads of a row group's column chunks and issue them up
+  // front (ArrowReaderProperties::set_pre_buffer). Always set explicitly,
+  // since the Arrow default differs between versions.
+  bool pre_buffer = false;
+  // Row groups decoded ahead of the consumer; 0 decodes inside Next().
+  int prefetch_row_groups = 0;
+};
+
+struct ScanOptions {
+  // Leaf column names to decode; empty reads every column.
+  std::vector<std::string> columns;
+  int64_t batch_size = kDefaultScanBatchSize;
+  // String columns handed out as DictionaryArray (int32 indices into a
+  // StringArray dictionary) instead of StringArray, so predicates can be
+  // evaluated once per entry; see DictionaryLookup().
+  std::vector<std::string> dictionary_columns;
+  // Conjunctive predicates used for row-group pruning only; the columns do
+  // not have to be projected.
+  std::vector<Int32Range> prune;
+  // Only consulted inside Open().
+  std::vector<KeyFilter> key_filters;
+  // When not empty, one flag per row group: unset ones are skipped like
+  // pruned ones (e.g. the row groups no query of a shared scan needs).
+  std::vector<bool> read_row_groups;
+  InputOptions input;
+  // Footer already parsed from this file, so Open() does not read it again.
+  std::shared_ptr<parquet::FileMetaData> metadata;
+};
+
+class ParquetScanner {
+ public:
+  static arrow::Result<std::unique_ptr<ParquetScanner>> Open(
+      const std::string& file_path, const ScanOptions& options,
+      arrow::MemoryPool* pool = arrow::default_memory_pool());
+
+  // Waits for a running producer task.
+  ~ParquetScanner();
+
+  // Returns the next batch, or nullptr once every row group has been read.
+  // Look columns up with GetColumnByName: they come in file order, not in
+  // the order they were requested.
+  arrow::Result<std::shared_ptr<arrow::RecordBatch>> Next();
+
+  // Makes this scanner claim row groups from a counter shared with other
+  // scanners over the same file, so each row group is read by exactly one
+  // of them. Call before the first Next().
+  void share_row_groups(std::atomic<int>* next_row_group) {
+    shared_next_row_group_ = next_row_group;
+  }
+
+  // Row group the most recent batch came from.
+  int current_row_group() const { return current_row_group_; }
+
+  // True when every row of the most recent batch satisfies the prune
+  // predicates, so they need not be evaluated.
+  bool current_all_match() const {
+    return match_[current_row_group_] == RowGroupMatch::kAll;
+  }
+
+  // Min and max of an INT32 or INT64 column over the whole file, taken from
+  // the row-group statistics. Returns false if some row group has none, or
+  // if the column does not exist.
+  bool ColumnRange(const std::string& column, int64_t* min,
+                   int64_t* max) const;
+
+  // What the prune predicates and key filters of options (the other fields
+  // are ignored) make of each row group of this file.
+  arrow::Result<std::vector<RowGroupMatch>> MatchRowGroups(
+      const ScanOptions& options) const;
+
+  // The parsed footer, for ScanOptions::metadata of later scans; nullptr
+  // for a column cache.
+  std::shared_ptr<parquet::FileMetaData> metadata() const;
+
+  int num_row_groups() const;
+  int64_t num_rows() const;
+  int64_t rows_read() const { return rows_read_; }
+  int row_groups_skipped() const { return row_groups_skipped_; }
+
+ private:
+  ParquetScanner(std::string file_path,
+                 std::shared_ptr<arrow::io::RandomAccessFile> input_file,
+                 std::unique_ptr<parquet::arrow::FileReader> reader,
+                 std::vector<int> column_indices,
+                 std::vector<RowGroupMatch> match,
+                 const InputOptions& input);
+
+  static arrow::Result<std::unique_ptr<ParquetScanner>> OpenCache(
+      const std::string& file_path, const ScanOptions& options);
+
+  struct DecodedRowGroup {
+    int row_group;
+    std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+  };
+
+  // Next row group that is not pruned, counting the skipped ones; -1 once
+  // none is left.
+  int ClaimRowGroup();
+
+  std::vector<arrow::io::ReadRange> ProjectedRanges(int row_group) const;
+
+  // Hints the kernel to page in the projected column chunks of row_group.
+  arrow::Status WillNeed(int row_group);
+
+  // WillNeed() on row_group and, without a shared counter, on the next one
+  // to be read, so its pages come in while this one is processed.
+  arrow::Status WillNeedFrom(int row_group);
+
+  // Next() of a column cache: slices the claimed blocks into batches.
+  arrow::Result<std::shared_ptr<arrow::RecordBatch>> NextCached();
+
+  // Next() of a pipelined scan: hands out the queued row groups.
+  arrow::Result<std::shared_ptr<arrow::RecordBatch>> NextPrefetched();
+
+  // Spawns Produce() unless it runs, is done or the queue is full. Needs
+  // prefetch_mutex_.
+  arrow::Status StartProducer();
+
+  // Decodes row groups into prefetched_ until the queue is full.
+  void Produce();
+
+  std::string file_path_;
+  std::shared_ptr<arrow::io::RandomAccessFile> input_file_;
+  std::unique_ptr<parquet::arrow::FileReader> reader_;
+  std::vector<int> column_indices_;
+  std::vector<RowGroupMatch> match_;
+  // Set instead of reader_ for a column cache, with whether each projected
+  // column is read as a dictionary
+  std::shared_ptr<ColumnCache> cache_;
+  std::vector<bool> cache_dictionary_;
+  int64_t batch_size_ = kDefaultScanBatchSize;
+  // Set for mapped input; advised_ marks row groups already hinted
+  bool will_need_;
+  std::vector<bool> advised_;
+
+  // Pipelined scan; everything below lookahead_ is guarded by
+  // prefetch_mutex_. Only one producer runs at a time, so the reader is
+  // never used by two threads.
+  int prefetch_depth_;
+  std::vector<std::shared_ptr<arrow::RecordBatch>> current_batches_;
+  size_t next_batch_ = 0;
+  // Claimed by the producer for the next step, already being read
+  int lookahead_ = -1;
+  std::mutex prefetch_mutex_;
+  std::condition_variable prefetch_cv_;
+  std::deque<DecodedRowGroup> prefetched_;
+  bool producer_running_ = false;
+  bool producer_done_ = false;
+  bool stopping_ = false;
+  arrow::Status producer_status_;
+  std::unique_ptr<arrow::RecordBatchReader> batch_reader_;
+  int next_row_group_ = 0;
+  std::atomic<int>* shared_next_row_group_ = nullptr;
+  int current_row_group_ = -1;
+  int64_t rows_read_ = 0;
+  int row_groups_skipped_ = 0;
+};
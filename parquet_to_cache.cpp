@@ -0,0 +1,92 @@
+// Converts a Parquet file into a column cache (column_cache.h), which every
+// rvv_query binary accepts in its place:
+//
+//   parquet_to_cache <input_parquet> <output_cache> [--columns=A,B,...]
+//                    [--block-rows=N] [--max-dictionary=N] [input options]
+//
+// --columns keeps only those columns (default: all); --block-rows bounds
+// the rows per block (default 65536); string columns with at most
+// --max-dictionary distinct values (default 1024) are dictionary-coded.
+#include <arrow/status.h>
+
+#include "column_cache.h"
+#include "query_options.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+arrow::Status ParsePositive(const std::string& value, const char* what,
+                            int64_t* out) {
+  char* end = nullptr;
+  long long parsed = std::strtoll(value.c_str(), &end, 10);
+  if (value.empty() || *end != '\0' || parsed < 1) {
+    return arrow::Status::Invalid("Invalid ", what, ": ", value);
+  }
+  *out = parsed;
+  return arrow::Status::OK();
+}
+
+arrow::Status ParseOptions(int argc, char** argv, ColumnCacheOptions* options) {
+  // The input options are those of the query binaries
+  std::vector<char*> input_args;
+  for (int i = 3; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg.rfind("--columns=", 0) == 0) {
+      std::istringstream names(arg.substr(10));
+      std::string name;
+      while (std::getline(names, name, ',')) {
+        if (!name.empty()) {
+          options->columns.push_back(name);
+        }
+      }
+    } else if (arg.rfind("--block-rows=", 0) == 0) {
+      ARROW_RETURN_NOT_OK(
+          ParsePositive(arg.substr(13), "block rows", &options->block_rows));
+    } else if (arg.rfind("--max-dictionary=", 0) == 0) {
+      ARROW_RETURN_NOT_OK(ParsePositive(arg.substr(17), "dictionary size",
+                                        &options->max_dictionary_size));
+    } else {
+      input_args.push_back(argv[i]);
+    }
+  }
+  QueryOptions query_options;
+  ARROW_RETURN_NOT_OK(ParseQueryOptions(static_cast<int>(input_args.size()),
+                                        input_args.data(), 0, &query_options));
+  options->input = query_options.input;
+  return arrow::Status::OK();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " <input_parquet> <output_cache> "
+              << "[--columns=A,B,...] [--block-rows=N] [--max-dictionary=N] "
+              << "[--io=read|mmap] [--buffered-stream=BYTES] [--pre-buffer]"
+              << std::endl;
+    return 1;
+  }
+
+  auto start_time = std::chrono::high_resolution_clock::now();
+  ColumnCacheOptions options;
+  arrow::Status st = ParseOptions(argc, argv, &options);
+  if (st.ok()) {
+    st = WriteColumnCache(argv[1], argv[2], options);
+  }
+  if (!st.ok()) {
+    std::cerr << "Error: " << st.ToString() << std::endl;
+    return 1;
+  }
+
+  auto end_time = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double> elapsed = end_time - start_time;
+  std::cout << "Wrote " << argv[2] << " in " << elapsed.count() << " seconds"
+            << std::endl;
+  return 0;
+}
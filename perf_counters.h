@@ -0,0 +1,140 @@
+// Hardware performance counters of the calling thread (perf_event_open),
+// for the phase profile in query_profile.h.
+//
+// Counting is opt-in: it is only set up when QUERY_COUNTERS=1. Each thread
+// lazily opens one counter group (cycles leading instructions and cache
+// misses) of user-mode events. QUERY_VECTOR_EVENT=<hex> adds a raw
+// PMU event for vector instructions, since no generic perf event exists for
+// them; on the SpacemiT K1 it is the vendor event code from the core
+// manual. Counters the kernel or the PMU refuse are left out, and
+// multiplexed groups are scaled by their enabled / running time.
+#pragma once
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+enum class Counter { kCycles, kInstructions, kCacheMisses, kVectorInstructions };
+
+constexpr int kNumCounters = 4;
+
+inline const char* CounterName(Counter counter) {
+  static const char* const kNames[kNumCounters] = {
+      "cycles", "instructions", "cache_misses", "vector_instructions"};
+  return kNames[static_cast<int>(counter)];
+}
+
+inline bool CountersEnabled() {
+  static const bool enabled = [] {
+    const char* value = std::getenv("QUERY_COUNTERS");
+    return value != nullptr && std::strcmp(value, "1") == 0;
+  }();
+  return enabled;
+}
+
+// One reading of every counter; unavailable counters stay at zero.
+struct CounterValues {
+  uint64_t value[kNumCounters] = {};
+};
+
+class ThreadCounters {
+ public:
+  // The counters of the calling thread, or null when counting is disabled
+  // or the leader event cannot be opened.
+  static ThreadCounters* Get() {
+    if (!CountersEnabled()) {
+      return nullptr;
+    }
+    thread_local ThreadCounters counters;
+    return counters.leader_ >= 0 ? &counters : nullptr;
+  }
+
+  ThreadCounters(const ThreadCounters&) = delete;
+  ThreadCounters& operator=(const ThreadCounters&) = delete;
+
+  ~ThreadCounters() {
+    for (int fd : fds_) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+  }
+
+  bool available(Counter counter) const {
+    return fds_[static_cast<int>(counter)] >= 0;
+  }
+
+  // Current totals, scaled for multiplexing.
+  CounterValues Read() const {
+    CounterValues values;
+    // PERF_FORMAT_GROUP layout: nr, time_enabled, time_running, values[nr]
+    uint64_t buffer[3 + kNumCounters] = {};
+    if (read(leader_, buffer, sizeof(buffer)) < 0) {
+      return values;
+    }
+    double scale = buffer[2] != 0 ? static_cast<double>(buffer[1]) / buffer[2]
+                                  : 1.0;
+    for (int c = 0; c < kNumCounters; c++) {
+      if (slot_[c] >= 0 && static_cast<uint64_t>(slot_[c]) < buffer[0]) {
+        values.value[c] = static_cast<uint64_t>(buffer[3 + slot_[c]] * scale);
+      }
+    }
+    return values;
+  }
+
+ private:
+  ThreadCounters() {
+    for (int c = 0; c < kNumCounters; c++) {
+      fds_[c] = -1;
+      slot_[c] = -1;
+    }
+    Open(Counter::kCycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    if (leader_ < 0) {
+      return;
+    }
+    Open(Counter::kInstructions, PERF_TYPE_HARDWARE,
+         PERF_COUNT_HW_INSTRUCTIONS);
+    Open(Counter::kCacheMisses, PERF_TYPE_HARDWARE,
+         PERF_COUNT_HW_CACHE_MISSES);
+    if (const char* raw = std::getenv("QUERY_VECTOR_EVENT")) {
+      Open(Counter::kVectorInstructions, PERF_TYPE_RAW,
+           std::strtoull(raw, nullptr, 16));
+    }
+    ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+
+  void Open(Counter counter, uint32_t type, uint64_t config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    if (leader_ < 0) {
+      attr.disabled = 1;
+      attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                         PERF_FORMAT_TOTAL_TIME_RUNNING;
+    }
+    int fd = static_cast<int>(
+        syscall(SYS_perf_event_open, &attr, 0, -1, leader_, 0));
+    if (fd < 0) {
+      return;
+    }
+    if (leader_ < 0) {
+      leader_ = fd;
+    }
+    fds_[static_cast<int>(counter)] = fd;
+    slot_[static_cast<int>(counter)] = num_open_++;
+  }
+
+  int leader_ = -1;
+  int fds_[kNumCounters];
+  int slot_[kNumCounters];  // position in the group read, -1 if not open
+  int num_open_ = 0;
+};
@@ -0,0 +1,660 @@
+// The kernel library of rvv_kernels.h in portable C++, for build hosts
+// without the V extension (KERNEL_BACKEND=portable). The loops are written
+// so that the compiler vectorizes them for the -march of the build (SSE /
+// AVX2 / AVX-512, NEON / SVE); results match the RVV kernels bit for bit
+// except for the order of float additions in the reductions.
+//
+// LMUL keeps its shape: every variant the RVV backend instantiates exists
+// here too. It only matters for the float reductions, which keep LMUL
+// native vectors' worth of independent partial sums so they vectorize
+// without -ffast-math, the same reassociation the RVV lanes perform.
+#include "rvv_kernels.h"
+
+#include "date_util.h"
+
+#include <cstring>
+#include <string_view>
+
+namespace rvv {
+
+namespace {
+
+// Bytes per native vector register of the build target.
+#if defined(__AVX512F__)
+constexpr size_t kVectorBytes = 64;
+#elif defined(__AVX2__) || defined(__AVX__)
+constexpr size_t kVectorBytes = 32;
+#else
+constexpr size_t kVectorBytes = 16;  // SSE2, NEON
+#endif
+
+// Independent partial sums of a reduction at a given LMUL.
+template <typename T, int LMUL>
+constexpr size_t kPartialSums = kVectorBytes / sizeof(T) * LMUL;
+
+inline bool get_bit(const uint8_t* bitmap, size_t bit) {
+  return (bitmap[bit / 8] >> (bit % 8)) & 1;
+}
+
+inline void put_bit(uint8_t* bitmap, size_t bit, bool value) {
+  uint8_t mask = static_cast<uint8_t>(1u << (bit % 8));
+  bitmap[bit / 8] = value ? (bitmap[bit / 8] | mask) : (bitmap[bit / 8] & ~mask);
+}
+
+// Writes pred(i) to bit out_offset + i of out for i < n, leaving other bits
+// untouched; whole bytes are assembled in registers.
+template <typename Pred>
+void write_bits(uint8_t* out, size_t out_offset, size_t n, Pred pred) {
+  size_t i = 0;
+  for (; i < n && ((out_offset + i) & 7) != 0; i++) {
+    put_bit(out, out_offset + i, pred(i));
+  }
+  for (; i + 8 <= n; i += 8) {
+    unsigned byte = 0;
+    for (unsigned k = 0; k < 8; k++) {
+      byte |= static_cast<unsigned>(pred(i + k)) << k;
+    }
+    out[(out_offset + i) / 8] = static_cast<uint8_t>(byte);
+  }
+  for (; i < n; i++) {
+    put_bit(out, out_offset + i, pred(i));
+  }
+}
+
+template <CmpOp Op, typename T, typename U>
+inline bool compare(T a, U b) {
+  if constexpr (Op == CmpOp::kLt) return a < b;
+  else if constexpr (Op == CmpOp::kLe) return a <= b;
+  else if constexpr (Op == CmpOp::kGt) return a > b;
+  else if constexpr (Op == CmpOp::kGe) return a >= b;
+  else if constexpr (Op == CmpOp::kEq) return a == b;
+  else return a != b;
+}
+
+inline bool compare(CmpOp op, int32_t a, int32_t b) {
+  switch (op) {
+    case CmpOp::kLt: return a < b;
+    case CmpOp::kLe: return a <= b;
+    case CmpOp::kGt: return a > b;
+    case CmpOp::kGe: return a >= b;
+    case CmpOp::kEq: return a == b;
+    default: return a != b;
+  }
+}
+
+// Low and high words of Decimal128 value i.
+inline const int64_t* decimal_words(const uint8_t* values, size_t i) {
+  return reinterpret_cast<const int64_t*>(values) + 2 * i;
+}
+
+inline bool fits_int64(const int64_t* w) { return w[1] == (w[0] >> 63); }
+
+inline bool fits_int32(const int64_t* w) {
+  return fits_int64(w) && w[0] == static_cast<int32_t>(w[0]);
+}
+
+constexpr double kPowersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,
+    1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+    1e20, 1e21, 1e22, 1e23, 1e24, 1e25, 1e26, 1e27, 1e28, 1e29,
+    1e30, 1e31, 1e32, 1e33, 1e34, 1e35, 1e36, 1e37, 1e38};
+
+// Divides rather than multiplies by 10^-scale, as Decimal128::ToDouble.
+inline double decimal_to_double(const int64_t* w, double divisor) {
+  if (fits_int64(w)) {
+    return static_cast<double>(w[0]) / divisor;
+  }
+  double raw = static_cast<double>(w[1]) * 18446744073709551616.0 +
+               static_cast<double>(static_cast<uint64_t>(w[0]));
+  return raw / divisor;
+}
+
+int64_t pow10_int64(int32_t scale) {
+  int64_t result = 1;
+  for (int32_t k = 0; k < scale; k++) {
+    result *= 10;
+  }
+  return result;
+}
+
+// Sums kPartialSums<T, LMUL> interleaved partial sums of term(i).
+template <typename T, int LMUL, typename Term>
+T partial_sum(size_t n, Term term) {
+  constexpr size_t kLanes = kPartialSums<T, LMUL>;
+  T partial[kLanes] = {};
+  size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    for (size_t k = 0; k < kLanes; k++) {
+      partial[k] += term(i + k);
+    }
+  }
+  for (size_t k = 0; i < n; i++, k++) {
+    partial[k] += term(i);
+  }
+  T total = 0;
+  for (size_t k = 0; k < kLanes; k++) {
+    total += partial[k];
+  }
+  return total;
+}
+
+}  // namespace
+
+template <typename T, int LMUL>
+void mul_one_minus(const T* a, const T* b, T* out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = a[i] - a[i] * b[i];
+  }
+}
+
+template <typename T, int LMUL>
+void mul_one_plus(const T* a, const T* b, T* out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = a[i] + a[i] * b[i];
+  }
+}
+
+template <typename T, int LMUL>
+void mul(const T* a, const T* b, T* out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = a[i] * b[i];
+  }
+}
+
+template <typename T, int LMUL>
+void sub(const T* a, const T* b, T* out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = a[i] - b[i];
+  }
+}
+
+template <typename T, int LMUL>
+void mul_one_minus_sub_mul(const T* a, const T* b, const T* c, const T* d,
+                           T* out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = (a[i] - a[i] * b[i]) - c[i] * d[i];
+  }
+}
+
+template <typename T, int LMUL>
+T sum(const T* data, size_t n) {
+  return partial_sum<T, LMUL>(n, [&](size_t i) { return data[i]; });
+}
+
+template <typename T, int LMUL>
+T sum_masked(const T* data, const uint8_t* bitmap, size_t n) {
+  return partial_sum<T, LMUL>(
+      n, [&](size_t i) { return get_bit(bitmap, i) ? data[i] : T(0); });
+}
+
+template <typename T, int LMUL>
+T dot(const T* a, const T* b, size_t n) {
+  return partial_sum<T, LMUL>(n, [&](size_t i) { return a[i] * b[i]; });
+}
+
+template <typename T, CmpOp Op, int LMUL>
+void compare_bitmap(const T* a, const T* b, uint8_t* out, size_t out_offset,
+                    size_t n) {
+  write_bits(out, out_offset, n,
+             [&](size_t i) { return compare<Op>(a[i], b[i]); });
+}
+
+template <typename T, CmpOp Op, int LMUL>
+void compare_scalar_bitmap(const T* a, T value, uint8_t* out,
+                           size_t out_offset, size_t n) {
+  write_bits(out, out_offset, n,
+             [&](size_t i) { return compare<Op>(a[i], value); });
+}
+
+template <int LMUL>
+void conjunction_bitmap(const Int32Term* terms, size_t num_terms, uint8_t* out,
+                        size_t out_offset, size_t n) {
+  write_bits(out, out_offset, n, [&](size_t i) {
+    for (size_t t = 0; t < num_terms; t++) {
+      const Int32Term& term = terms[t];
+      int32_t rhs = term.rhs != nullptr ? term.rhs[i] : term.value;
+      if (!compare(term.op, term.lhs[i], rhs)) {
+        return false;
+      }
+    }
+    return true;
+  });
+}
+
+template <int LMUL>
+void and_bitmap(uint8_t* out, size_t out_offset, const uint8_t* other,
+                size_t other_offset, size_t n) {
+  write_bits(out, out_offset, n, [&](size_t i) {
+    return get_bit(out, out_offset + i) && get_bit(other, other_offset + i);
+  });
+}
+
+template <int LMUL>
+size_t bitmap_to_selection(const uint8_t* bitmap, size_t n, int32_t* rows) {
+  size_t count = 0;
+  for (size_t byte = 0; byte < (n + 7) / 8; byte++) {
+    unsigned bits = bitmap[byte];
+    if (byte == n / 8) {
+      bits &= (1u << (n & 7)) - 1;
+    }
+    for (; bits != 0; bits &= bits - 1) {
+      rows[count++] = static_cast<int32_t>(8 * byte + __builtin_ctz(bits));
+    }
+  }
+  return count;
+}
+
+size_t count_bits(const uint8_t* bitmap, size_t n) {
+  size_t count = 0;
+  for (size_t byte = 0; byte < n / 8; byte++) {
+    count += __builtin_popcount(bitmap[byte]);
+  }
+  if ((n & 7) != 0) {
+    count += __builtin_popcount(bitmap[n / 8] & ((1u << (n & 7)) - 1));
+  }
+  return count;
+}
+
+size_t vector_group_bytes() { return kVectorBytes * kDefaultLmul; }
+
+template <int LMUL>
+bool decode_decimal128_unscaled(const uint8_t* values, int64_t* out, size_t n) {
+  bool fits = true;
+  for (size_t i = 0; i < n; i++) {
+    const int64_t* w = decimal_words(values, i);
+    fits &= fits_int64(w);
+    out[i] = w[0];
+  }
+  return fits;
+}
+
+template <int LMUL>
+bool decode_decimal128_unscaled(const uint8_t* values, int32_t* out, size_t n) {
+  bool fits = true;
+  for (size_t i = 0; i < n; i++) {
+    const int64_t* w = decimal_words(values, i);
+    fits &= fits_int32(w);
+    out[i] = static_cast<int32_t>(w[0]);
+  }
+  return fits;
+}
+
+template <typename T, int LMUL>
+void decode_decimal128(const uint8_t* values, int32_t scale, T* out, size_t n) {
+  const double divisor = kPowersOfTen[scale];
+  for (size_t i = 0; i < n; i++) {
+    out[i] = static_cast<T>(decimal_to_double(decimal_words(values, i), divisor));
+  }
+}
+
+template <int LMUL>
+void and_decimal128_range(const uint8_t* values, int64_t lo, int64_t hi,
+                          uint8_t* out, size_t out_offset, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    if (!get_bit(out, out_offset + i)) {
+      continue;
+    }
+    const int64_t* w = decimal_words(values, i);
+    if (!fits_int64(w) || w[0] < lo || w[0] > hi) {
+      put_bit(out, out_offset + i, false);
+    }
+  }
+}
+
+template <int LMUL>
+Int128 sum_exact(const int32_t* data, size_t n) {
+  int64_t total = 0;
+  for (size_t i = 0; i < n; i++) {
+    total += data[i];
+  }
+  return total;
+}
+
+template <int LMUL>
+Int128 sum_exact_masked(const int32_t* data, const uint8_t* bitmap, size_t n) {
+  int64_t total = 0;
+  for (size_t i = 0; i < n; i++) {
+    total += get_bit(bitmap, i) ? data[i] : 0;
+  }
+  return total;
+}
+
+template <int LMUL>
+Int128 dot_exact(const int32_t* a, const int32_t* b, size_t n) {
+  Int128 total = 0;
+  for (size_t i = 0; i < n; i++) {
+    total += static_cast<int64_t>(a[i]) * b[i];
+  }
+  return total;
+}
+
+template <int LMUL>
+Int128 sum_mul_one_minus_exact(const int32_t* a, const int32_t* b, int32_t one,
+                               size_t n) {
+  Int128 total = 0;
+  for (size_t i = 0; i < n; i++) {
+    total += static_cast<int64_t>(a[i]) * (static_cast<int64_t>(one) - b[i]);
+  }
+  return total;
+}
+
+template <int LMUL>
+Int128 sum_mul_one_minus_one_plus_exact(const int32_t* a, const int32_t* b,
+                                        int32_t one_b, const int32_t* c,
+                                        int32_t one_c, size_t n) {
+  Int128 total = 0;
+  for (size_t i = 0; i < n; i++) {
+    int64_t disc = static_cast<int64_t>(a[i]) *
+                   (static_cast<int64_t>(one_b) - b[i]);
+    total += static_cast<Int128>(disc) * (static_cast<int64_t>(one_c) + c[i]);
+  }
+  return total;
+}
+
+template <int LMUL>
+void date32_to_year(const int32_t* days, int32_t* out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = year_from_days(days[i]);
+  }
+}
+
+template <int LMUL>
+bool char_pair_codes(const int32_t* a_offsets, const uint8_t* a_data,
+                     const int32_t* b_offsets, const uint8_t* b_data,
+                     int32_t* out, size_t n) {
+  bool too_long = false;
+  for (size_t i = 0; i < n; i++) {
+    int32_t a_length = a_offsets[i + 1] - a_offsets[i];
+    int32_t b_length = b_offsets[i + 1] - b_offsets[i];
+    too_long |= a_length > 1 || b_length > 1;
+    int32_t a = a_length != 0 ? a_data[a_offsets[i]] : 0;
+    int32_t b = b_length != 0 ? b_data[b_offsets[i]] : 0;
+    out[i] = a << 8 | b;
+  }
+  return !too_long;
+}
+
+template <int LMUL>
+size_t gather_int32(const int32_t* table, const int32_t* index, int32_t* out,
+                    size_t n) {
+  size_t negative = 0;
+  for (size_t i = 0; i < n; i++) {
+    out[i] = table[index[i]];
+    negative += out[i] < 0;
+  }
+  return negative;
+}
+
+template <int LMUL>
+size_t gather_dense_int32(const int32_t* table, int64_t base, size_t size,
+                          const int64_t* keys, int32_t* out, size_t n) {
+  size_t misses = 0;
+  for (size_t i = 0; i < n; i++) {
+    // Keys below base wrap around to huge unsigned indices
+    uint64_t index = static_cast<uint64_t>(keys[i]) - static_cast<uint64_t>(base);
+    out[i] = index < size ? table[index] : -1;
+    misses += out[i] < 0;
+  }
+  return misses;
+}
+
+template <int LMUL>
+bool gather_decimal128_unscaled(const uint8_t* values, const int32_t* rows,
+                                size_t n, int32_t* out) {
+  bool fits = true;
+  for (size_t i = 0; i < n; i++) {
+    const int64_t* w = decimal_words(values, static_cast<size_t>(rows[i]));
+    fits &= fits_int32(w);
+    out[i] = static_cast<int32_t>(w[0]);
+  }
+  return fits;
+}
+
+template <typename T, int LMUL>
+void gather_decimal128(const uint8_t* values, int32_t scale,
+                       const int32_t* rows, size_t n, T* out) {
+  const double divisor = kPowersOfTen[scale];
+  for (size_t i = 0; i < n; i++) {
+    out[i] = static_cast<T>(decimal_to_double(
+        decimal_words(values, static_cast<size_t>(rows[i])), divisor));
+  }
+}
+
+template <int LMUL>
+void linear_group_ids(const int32_t* a, int32_t scale, const int32_t* b,
+                      int32_t offset, int32_t* out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = a[i] * scale + b[i] + offset;
+  }
+}
+
+// Scalar stores never conflict, so one slot per group suffices.
+template <int LMUL>
+size_t group_sum_lanes() {
+  return 1;
+}
+
+template <int LMUL>
+void group_sum(const int32_t* group_ids, const float* values, size_t n,
+               double* lane_sums, int64_t* lane_counts) {
+  for (size_t i = 0; i < n; i++) {
+    lane_sums[group_ids[i]] += values[i];
+  }
+  if (lane_counts) {
+    for (size_t i = 0; i < n; i++) {
+      lane_counts[group_ids[i]]++;
+    }
+  }
+}
+
+template <int LMUL>
+void probe_bitmap(const uint64_t* words, int64_t base, size_t size,
+                  const int64_t* keys, uint8_t* out, size_t out_offset,
+                  size_t n) {
+  write_bits(out, out_offset, n, [&](size_t i) {
+    uint64_t index = static_cast<uint64_t>(keys[i]) - static_cast<uint64_t>(base);
+    return index < size && ((words[index / 64] >> (index % 64)) & 1) != 0;
+  });
+}
+
+template <int LMUL>
+void probe_bloom(const uint64_t* blocks, int log_blocks, const int64_t* keys,
+                 uint8_t* out, size_t out_offset, size_t n) {
+  write_bits(out, out_offset, n, [&](size_t i) {
+    uint64_t hash = bloom_hash(keys[i]);
+    uint64_t pattern = bloom_pattern(hash);
+    return (blocks[bloom_block(hash, log_blocks)] & pattern) == pattern;
+  });
+}
+
+template <int LMUL>
+void contains_bitmap(const int32_t* offsets, const uint8_t* data, size_t n,
+                     const char* needle, size_t needle_length, uint8_t* out,
+                     size_t out_offset) {
+  if (needle_length == 0) {
+    for (size_t i = 0; i < n; i++) {
+      put_bit(out, out_offset + i, true);
+    }
+    return;
+  }
+  const std::string_view pattern(needle, needle_length);
+  write_bits(out, out_offset, n, [&](size_t i) {
+    std::string_view value(reinterpret_cast<const char*>(data + offsets[i]),
+                           static_cast<size_t>(offsets[i + 1] - offsets[i]));
+    return value.find(pattern) != std::string_view::npos;
+  });
+}
+
+template <int LMUL>
+bool q1_aggregate_exact(const Q1Input& in, size_t n, Q1Sums* groups,
+                        size_t num_groups) {
+  const int64_t disc_one = pow10_int64(in.discount_scale);
+  const int64_t tax_one = pow10_int64(in.tax_scale);
+  for (size_t i = 0; i < n; i++) {
+    if (in.shipdate[i] > in.cutoff ||
+        (in.selection && !get_bit(in.selection, i))) {
+      continue;
+    }
+    const int64_t* qty = decimal_words(in.quantity, i);
+    const int64_t* price = decimal_words(in.price, i);
+    const int64_t* disc = decimal_words(in.discount, i);
+    const int64_t* tax = decimal_words(in.tax, i);
+    if (!fits_int32(qty) || !fits_int32(price) || !fits_int32(disc) ||
+        !fits_int32(tax)) {
+      return false;
+    }
+    int64_t disc_price = price[0] * (disc_one - disc[0]);
+    Q1Sums& sums = groups[in.group_ids[i]];
+    sums.count++;
+    sums.qty += qty[0];
+    sums.price += price[0];
+    sums.disc += disc[0];
+    sums.disc_price += disc_price;
+    sums.charge += static_cast<Int128>(disc_price) * (tax_one + tax[0]);
+  }
+  (void)num_groups;
+  return true;
+}
+
+template <int LMUL>
+bool q1_aggregate_float(const Q1Input& in, size_t n, Q1SumsFloat* groups,
+                        size_t num_groups) {
+  const double qty_div = kPowersOfTen[in.quantity_scale];
+  const double price_div = kPowersOfTen[in.price_scale];
+  const double disc_div = kPowersOfTen[in.discount_scale];
+  const double tax_div = kPowersOfTen[in.tax_scale];
+  for (size_t i = 0; i < n; i++) {
+    if (in.shipdate[i] > in.cutoff ||
+        (in.selection && !get_bit(in.selection, i))) {
+      continue;
+    }
+    const int64_t* qty = decimal_words(in.quantity, i);
+    const int64_t* price = decimal_words(in.price, i);
+    const int64_t* disc = decimal_words(in.discount, i);
+    const int64_t* tax = decimal_words(in.tax, i);
+    if (!fits_int64(qty) || !fits_int64(price) || !fits_int64(disc) ||
+        !fits_int64(tax)) {
+      return false;
+    }
+    double v_price = static_cast<double>(price[0]) / price_div;
+    double v_disc = static_cast<double>(disc[0]) / disc_div;
+    double disc_price = v_price - v_price * v_disc;
+    Q1SumsFloat& sums = groups[in.group_ids[i]];
+    sums.count++;
+    sums.qty += static_cast<double>(qty[0]) / qty_div;
+    sums.price += v_price;
+    sums.disc += v_disc;
+    sums.disc_price += disc_price;
+    sums.charge +=
+        disc_price + disc_price * (static_cast<double>(tax[0]) / tax_div);
+  }
+  (void)num_groups;
+  return true;
+}
+
+// The same instantiations as the RVV backend, so code that links against
+// one links against the other.
+
+#define PORTABLE_INSTANTIATE_FLOAT(T, LMUL)                                   \
+  template void mul_one_minus<T, LMUL>(const T*, const T*, T*, size_t);       \
+  template void mul_one_plus<T, LMUL>(const T*, const T*, T*, size_t);        \
+  template void mul<T, LMUL>(const T*, const T*, T*, size_t);                 \
+  template void sub<T, LMUL>(const T*, const T*, T*, size_t);                 \
+  template void mul_one_minus_sub_mul<T, LMUL>(const T*, const T*, const T*,  \
+                                               const T*, T*, size_t);         \
+  template T sum<T, LMUL>(const T*, size_t);                                  \
+  template T sum_masked<T, LMUL>(const T*, const uint8_t*, size_t);           \
+  template T dot<T, LMUL>(const T*, const T*, size_t);
+
+#define PORTABLE_INSTANTIATE_COMPARE_OP(T, OP, LMUL)                          \
+  template void compare_bitmap<T, CmpOp::OP, LMUL>(const T*, const T*,        \
+                                                   uint8_t*, size_t, size_t); \
+  template void compare_scalar_bitmap<T, CmpOp::OP, LMUL>(                    \
+      const T*, T, uint8_t*, size_t, size_t);
+
+#define PORTABLE_INSTANTIATE_COMPARE(T, LMUL)                                 \
+  PORTABLE_INSTANTIATE_COMPARE_OP(T, kLt, LMUL)                               \
+  PORTABLE_INSTANTIATE_COMPARE_OP(T, kLe, LMUL)                               \
+  PORTABLE_INSTANTIATE_COMPARE_OP(T, kGt, LMUL)                               \
+  PORTABLE_INSTANTIATE_COMPARE_OP(T, kGe, LMUL)                               \
+  PORTABLE_INSTANTIATE_COMPARE_OP(T, kEq, LMUL)                               \
+  PORTABLE_INSTANTIATE_COMPARE_OP(T, kNe, LMUL)
+
+// Kernels the RVV backend instantiates for LMUL 1, 2, 4 and 8
+#define PORTABLE_INSTANTIATE_LMUL(LMUL)                                       \
+  PORTABLE_INSTANTIATE_FLOAT(float, LMUL)                                     \
+  PORTABLE_INSTANTIATE_FLOAT(double, LMUL)                                    \
+  PORTABLE_INSTANTIATE_COMPARE(int32_t, LMUL)                                 \
+  PORTABLE_INSTANTIATE_COMPARE(int64_t, LMUL)                                 \
+  PORTABLE_INSTANTIATE_COMPARE(float, LMUL)                                   \
+  PORTABLE_INSTANTIATE_COMPARE(double, LMUL)                                  \
+  template void conjunction_bitmap<LMUL>(const Int32Term*, size_t, uint8_t*,  \
+                                         size_t, size_t);                     \
+  template void and_bitmap<LMUL>(uint8_t*, size_t, const uint8_t*, size_t,    \
+                                 size_t);                                     \
+  template size_t bitmap_to_selection<LMUL>(const uint8_t*, size_t, int32_t*); \
+  template bool decode_decimal128_unscaled<LMUL>(const uint8_t*, int64_t*,    \
+                                                 size_t);                     \
+  template bool decode_decimal128_unscaled<LMUL>(const uint8_t*, int32_t*,    \
+                                                 size_t);                     \
+  template void decode_decimal128<float, LMUL>(const uint8_t*, int32_t,       \
+                                               float*, size_t);               \
+  template void decode_decimal128<double, LMUL>(const uint8_t*, int32_t,      \
+                                                double*, size_t);             \
+  template void and_decimal128_range<LMUL>(const uint8_t*, int64_t, int64_t,  \
+                                           uint8_t*, size_t, size_t);         \
+  template void date32_to_year<LMUL>(const int32_t*, int32_t*, size_t);       \
+  template bool char_pair_codes<LMUL>(const int32_t*, const uint8_t*,         \
+                                      const int32_t*, const uint8_t*,         \
+                                      int32_t*, size_t);                      \
+  template size_t gather_int32<LMUL>(const int32_t*, const int32_t*,          \
+                                     int32_t*, size_t);                       \
+  template void linear_group_ids<LMUL>(const int32_t*, int32_t,               \
+                                       const int32_t*, int32_t, int32_t*,     \
+                                       size_t);                               \
+  template void probe_bitmap<LMUL>(const uint64_t*, int64_t, size_t,          \
+                                   const int64_t*, uint8_t*, size_t, size_t); \
+  template void probe_bloom<LMUL>(const uint64_t*, int, const int64_t*,       \
+                                  uint8_t*, size_t, size_t);                  \
+  template void contains_bitmap<LMUL>(const int32_t*, const uint8_t*, size_t, \
+                                      const char*, size_t, uint8_t*, size_t);
+
+// Kernels with int64 or wider lanes at twice the LMUL, up to 4
+#define PORTABLE_INSTANTIATE_NARROW(LMUL)                                     \
+  template Int128 sum_exact<LMUL>(const int32_t*, size_t);                    \
+  template Int128 sum_exact_masked<LMUL>(const int32_t*, const uint8_t*,      \
+                                         size_t);                             \
+  template Int128 dot_exact<LMUL>(const int32_t*, const int32_t*, size_t);    \
+  template Int128 sum_mul_one_minus_exact<LMUL>(const int32_t*,               \
+                                                const int32_t*, int32_t,      \
+                                                size_t);                      \
+  template Int128 sum_mul_one_minus_one_plus_exact<LMUL>(                     \
+      const int32_t*, const int32_t*, int32_t, const int32_t*, int32_t,       \
+      size_t);                                                                \
+  template size_t gather_dense_int32<LMUL>(const int32_t*, int64_t, size_t,   \
+                                           const int64_t*, int32_t*, size_t); \
+  template bool gather_decimal128_unscaled<LMUL>(                             \
+      const uint8_t*, const int32_t*, size_t, int32_t*);                      \
+  template void gather_decimal128<float, LMUL>(const uint8_t*, int32_t,       \
+                                               const int32_t*, size_t,        \
+                                               float*);                       \
+  template void gather_decimal128<double, LMUL>(const uint8_t*, int32_t,      \
+                                                const int32_t*, size_t,       \
+                                                double*);                     \
+  template size_t group_sum_lanes<LMUL>();                                    \
+  template void group_sum<LMUL>(const int32_t*, const float*, size_t,         \
+                                double*, int64_t*);                           \
+  template bool q1_aggregate_exact<LMUL>(const Q1Input&, size_t, Q1Sums*,     \
+                                         size_t);                             \
+  template bool q1_aggregate_float<LMUL>(const Q1Input&, size_t,              \
+                                         Q1SumsFloat*, size_t);
+
+PORTABLE_INSTANTIATE_LMUL(1)
+PORTABLE_INSTANTIATE_LMUL(2)
+PORTABLE_INSTANTIATE_LMUL(4)
+PORTABLE_INSTANTIATE_LMUL(8)
+PORTABLE_INSTANTIATE_NARROW(1)
+PORTABLE_INSTANTIATE_NARROW(2)
+PORTABLE_INSTANTIATE_NARROW(4)
+
+}  // namespace rvv
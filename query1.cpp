@@ -7,9 +7,12 @@
 #include <arrow/dataset/api.h>
 #include <arrow/dataset/file_parquet.h>
 #include <arrow/dataset/scanner.h>
+#include <arrow/util/byte_size.h>
 #include <parquet/arrow/reader.h>
 #include <parquet/file_reader.h>
 
+#include "query_profile.h"
+
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -86,6 +89,8 @@ int main(int argc, char** argv) {
 
     std::string input_file = argv[1];
     
+    PhaseTimer timer(Phase::kIo);
+    
     // Initialize Arrow's memory pool
     arrow::MemoryPool* pool = arrow::default_memory_pool();
     
@@ -113,6 +118,7 @@ int main(int argc, char** argv) {
         std::cerr << "Could not read table: " << status.ToString() << std::endl;
         return 1;
     }
+    timer.Count(table->num_rows(), arrow::util::TotalBufferSize(*table));
     
     // Print table schema to debug column types
     // std::cout << "Table schema: " << table->schema()->ToString() << std::endl;
@@ -130,7 +136,9 @@ int main(int argc, char** argv) {
     int32_t cutoff_days = date_string_to_days("1998-09-02");
     // std::cout << "Cutoff days: " << cutoff_days << std::endl;
     
-    // Process data and perform grouping manually
+    // Process data and perform grouping manually; filter, decode and
+    // aggregation share one row loop
+    timer.Switch(Phase::kAggregate);
     std::map<GroupKey, AggregateValues> groups;
     
     // Process each chunk
@@ -266,6 +274,7 @@ int main(int argc, char** argv) {
         [](const auto& a, const auto& b) {
             return a.first < b.first;
         });
+    timer.Stop();
     
     auto end_time = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed = end_time - start_time;
@@ -298,11 +307,18 @@ int main(int argc, char** argv) {
                   << std::setw(15) << std::fixed << std::setprecision(2) << agg.avg_price
                   << std::setw(15) << std::fixed << std::setprecision(6) << agg.avg_disc
                   << std::setw(15) << agg.count_order << std::endl;
+        QueryProfile::Global().AddRow(
+            {key.returnflag, key.linestatus, ResultField(agg.sum_qty),
+             ResultField(agg.sum_base_price), ResultField(agg.sum_disc_price),
+             ResultField(agg.sum_charge), ResultField(agg.avg_qty),
+             ResultField(agg.avg_price), ResultField(agg.avg_disc),
+             ResultField(agg.count_order)});
     }
     
     std::cout << "\nQuery executed in " << elapsed.count() << " seconds" << std::endl;
     std::cout << "Processed " << total_rows << " rows (" << rows_processed << " examined, " 
               << rows_accepted << " passed filter)" << std::endl;
     
+    WriteProfile();
     return 0;
 }
@@ -7,9 +7,12 @@
 #include <arrow/dataset/api.h>
 #include <arrow/dataset/file_parquet.h>
 #include <arrow/dataset/scanner.h>
+#include <arrow/util/byte_size.h>
 #include <parquet/arrow/reader.h>
 #include <parquet/file_reader.h>
 
+#include "query_profile.h"
+
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -58,6 +61,8 @@ int main(int argc, char** argv) {
     
     auto start_time = std::chrono::high_resolution_clock::now();
     
+    PhaseTimer timer(Phase::kIo);
+    
     // Initialize Arrow's memory pool
     arrow::MemoryPool* pool = arrow::default_memory_pool();
     
@@ -82,6 +87,7 @@ int main(int argc, char** argv) {
         std::cerr << "Could not read orders table: " << status.ToString() << std::endl;
         return 1;
     }
+    timer.Count(orders_table->num_rows(), arrow::util::TotalBufferSize(*orders_table));
     
     std::cout << "Orders table loaded with " << orders_table->num_rows() << " rows" << std::endl;
     
@@ -90,6 +96,7 @@ int main(int argc, char** argv) {
     auto o_orderpriority_col = orders_table->GetColumnByName("o_orderpriority");
     
     // Create a map of orderkey -> orderpriority
+    timer.Switch(Phase::kJoinBuild);
     std::map<int64_t, std::string> order_priorities;
     
     for (int chunk_idx = 0; chunk_idx < o_orderkey_col->num_chunks(); chunk_idx++) {
@@ -112,6 +119,7 @@ int main(int argc, char** argv) {
     std::cout << "Loaded " << order_priorities.size() << " order priorities" << std::endl;
     
     // 2. Process lineitem table
+    timer.Switch(Phase::kIo);
     auto maybe_lineitem_file = arrow::io::ReadableFile::Open(lineitem_file);
     if (!maybe_lineitem_file.ok()) {
         std::cerr << "Could not open lineitem file: " << maybe_lineitem_file.status().ToString() << std::endl;
@@ -132,6 +140,7 @@ int main(int argc, char** argv) {
         std::cerr << "Could not read lineitem table: " << status.ToString() << std::endl;
         return 1;
     }
+    timer.Count(lineitem_table->num_rows(), arrow::util::TotalBufferSize(*lineitem_table));
     
     std::cout << "Lineitem table loaded with " << lineitem_table->num_rows() << " rows" << std::endl;
     
@@ -146,7 +155,9 @@ int main(int argc, char** argv) {
     int32_t start_date = date_string_to_days("1994-01-01");
     int32_t end_date = date_string_to_days("1995-01-01"); // One day after end of 1994
     
-    // Map to store results by shipmode
+    // Map to store results by shipmode; the row loop is dominated by the
+    // predicates
+    timer.Switch(Phase::kFilter);
     std::map<std::string, Query12Result> results_by_shipmode;
     std::set<std::string> target_shipmodes = {"MAIL", "SHIP"};
     
@@ -220,6 +231,7 @@ int main(int argc, char** argv) {
     }
     
     // Convert map to vector for sorting
+    timer.Switch(Phase::kAggregate);
     std::vector<Query12Result> results;
     for (const auto& [shipmode, result] : results_by_shipmode) {
         results.push_back(result);
@@ -227,6 +239,7 @@ int main(int argc, char** argv) {
     
     // Sort by shipmode
     std::sort(results.begin(), results.end());
+    timer.Stop();
     
     auto end_time = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed = end_time - start_time;
@@ -242,10 +255,14 @@ int main(int argc, char** argv) {
         std::cout << std::setw(15) << result.l_shipmode
                   << std::setw(20) << result.high_line_count
                   << std::setw(20) << result.low_line_count << std::endl;
+        QueryProfile::Global().AddRow({result.l_shipmode,
+                                       ResultField(result.high_line_count),
+                                       ResultField(result.low_line_count)});
     }
     
     std::cout << "\nQuery executed in " << elapsed.count() << " seconds" << std::endl;
     std::cout << "Processed " << rows_processed << " lineitem rows, " << rows_qualified << " qualified" << std::endl;
     
+    WriteProfile();
     return 0;
 }
\ No newline at end of file
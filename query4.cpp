@@ -7,9 +7,12 @@
 #include <arrow/dataset/api.h>
 #include <arrow/dataset/file_parquet.h>
 #include <arrow/dataset/scanner.h>
+#include <arrow/util/byte_size.h>
 #include <parquet/arrow/reader.h>
 #include <parquet/file_reader.h>
 
+#include "query_profile.h"
+
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -55,6 +58,8 @@ int main(int argc, char** argv) {
     
     auto start_time = std::chrono::high_resolution_clock::now();
     
+    PhaseTimer timer(Phase::kIo);
+    
     // Initialize Arrow's memory pool
     arrow::MemoryPool* pool = arrow::default_memory_pool();
     
@@ -79,6 +84,7 @@ int main(int argc, char** argv) {
         std::cerr << "Could not read lineitem table: " << status.ToString() << std::endl;
         return 1;
     }
+    timer.Count(lineitem_table->num_rows(), arrow::util::TotalBufferSize(*lineitem_table));
     
     std::cout << "Lineitem table loaded with " << lineitem_table->num_rows() << " rows" << std::endl;
     
@@ -88,6 +94,7 @@ int main(int argc, char** argv) {
     auto l_receiptdate_col = lineitem_table->GetColumnByName("l_receiptdate");
     
     // Find all orderkeys where l_commitdate < l_receiptdate
+    timer.Switch(Phase::kJoinBuild);
     std::set<int64_t> qualifying_orderkeys;
     
     for (int chunk_idx = 0; chunk_idx < l_orderkey_col->num_chunks(); chunk_idx++) {
@@ -114,6 +121,7 @@ int main(int argc, char** argv) {
     std::cout << "Found " << qualifying_orderkeys.size() << " qualifying orderkeys" << std::endl;
     
     // 2. Now open and process the orders file
+    timer.Switch(Phase::kIo);
     auto maybe_orders_file = arrow::io::ReadableFile::Open(orders_file);
     if (!maybe_orders_file.ok()) {
         std::cerr << "Could not open orders file: " << maybe_orders_file.status().ToString() << std::endl;
@@ -134,6 +142,7 @@ int main(int argc, char** argv) {
         std::cerr << "Could not read orders table: " << status.ToString() << std::endl;
         return 1;
     }
+    timer.Count(orders_table->num_rows(), arrow::util::TotalBufferSize(*orders_table));
     
     std::cout << "Orders table loaded with " << orders_table->num_rows() << " rows" << std::endl;
     
@@ -149,6 +158,7 @@ int main(int argc, char** argv) {
     std::cout << "Filtering orders between dates: " << start_date << " and " << end_date << std::endl;
     
     // Count orders by priority
+    timer.Switch(Phase::kProbe);
     std::map<std::string, int64_t> priority_counts;
     
     for (int chunk_idx = 0; chunk_idx < o_orderkey_col->num_chunks(); chunk_idx++) {
@@ -177,6 +187,7 @@ int main(int argc, char** argv) {
     }
     
     // Sort results by o_orderpriority
+    timer.Switch(Phase::kAggregate);
     std::vector<OrderPriorityCount> sorted_results;
     for (const auto& pair : priority_counts) {
         OrderPriorityCount result;
@@ -186,6 +197,7 @@ int main(int argc, char** argv) {
     }
     
     std::sort(sorted_results.begin(), sorted_results.end());
+    timer.Stop();
     
     auto end_time = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed = end_time - start_time;
@@ -198,9 +210,11 @@ int main(int argc, char** argv) {
     for (const auto& result : sorted_results) {
         std::cout << std::setw(20) << result.priority 
                   << std::setw(15) << result.count << std::endl;
+        QueryProfile::Global().AddRow({result.priority, ResultField(result.count)});
     }
     
     std::cout << "\nQuery executed in " << elapsed.count() << " seconds" << std::endl;
     
+    WriteProfile();
     return 0;
 }
\ No newline at end of file
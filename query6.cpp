@@ -7,9 +7,12 @@
 #include <arrow/dataset/api.h>
 #include <arrow/dataset/file_parquet.h>
 #include <arrow/dataset/scanner.h>
+#include <arrow/util/byte_size.h>
 #include <parquet/arrow/reader.h>
 #include <parquet/file_reader.h>
 
+#include "query_profile.h"
+
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -63,6 +66,8 @@ int main(int argc, char** argv) {
     
     auto start_time = std::chrono::high_resolution_clock::now();
     
+    PhaseTimer timer(Phase::kIo);
+    
     // Initialize Arrow's memory pool
     arrow::MemoryPool* pool = arrow::default_memory_pool();
     
@@ -87,6 +92,7 @@ int main(int argc, char** argv) {
         std::cerr << "Could not read lineitem table: " << status.ToString() << std::endl;
         return 1;
     }
+    timer.Count(lineitem_table->num_rows(), arrow::util::TotalBufferSize(*lineitem_table));
     
     std::cout << "Lineitem table loaded with " << lineitem_table->num_rows() << " rows" << std::endl;
     // std::cout << "Table schema: " << lineitem_table->schema()->ToString() << std::endl;
@@ -103,7 +109,9 @@ int main(int argc, char** argv) {
     
     // std::cout << "Filtering shipments between dates: " << start_date << " and " << end_date << std::endl;
     
-    // Process data and calculate revenue
+    // Process data and calculate revenue; the row loop is dominated by the
+    // predicates
+    timer.Switch(Phase::kFilter);
     double total_revenue = 0.0;
     int64_t rows_processed = 0;
     int64_t rows_qualified = 0;
@@ -198,6 +206,7 @@ int main(int argc, char** argv) {
         }
     }
     
+    timer.Stop();
     auto end_time = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed = end_time - start_time;
     
@@ -206,9 +215,11 @@ int main(int argc, char** argv) {
     std::cout << "----------------------" << std::endl;
     std::cout << std::setw(15) << "REVENUE" << std::endl;
     std::cout << std::setw(15) << std::fixed << std::setprecision(2) << total_revenue << std::endl;
+    QueryProfile::Global().AddRow({ResultField(total_revenue)});
     
     std::cout << "\nQuery executed in " << elapsed.count() << " seconds" << std::endl;
     std::cout << "Processed " << rows_processed << " rows, " << rows_qualified << " qualified" << std::endl;
     
+    WriteProfile();
     return 0;
 }
\ No newline at end of file
@@ -7,9 +7,12 @@
 #include <arrow/dataset/api.h>
 #include <arrow/dataset/file_parquet.h>
 #include <arrow/dataset/scanner.h>
+#include <arrow/util/byte_size.h>
 #include <parquet/arrow/reader.h>
 #include <parquet/file_reader.h>
 
+#include "query_profile.h"
+
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -110,6 +113,8 @@ int main(int argc, char** argv) {
     
     auto start_time = std::chrono::high_resolution_clock::now();
     
+    PhaseTimer timer(Phase::kIo);
+    
     // Initialize Arrow's memory pool
     arrow::MemoryPool* pool = arrow::default_memory_pool();
     
@@ -134,10 +139,12 @@ int main(int argc, char** argv) {
         std::cerr << "Could not read part table: " << status.ToString() << std::endl;
         return 1;
     }
+    timer.Count(part_table->num_rows(), arrow::util::TotalBufferSize(*part_table));
     
     std::cout << "Part table loaded with " << part_table->num_rows() << " rows" << std::endl;
     
     // Extract required columns from part
+    timer.Switch(Phase::kFilter);
     auto p_partkey_col = part_table->GetColumnByName("p_partkey");
     auto p_name_col = part_table->GetColumnByName("p_name");
     
@@ -164,6 +171,7 @@ int main(int argc, char** argv) {
     std::cout << "Found " << green_parts.size() << " parts with 'green' in the name" << std::endl;
     
     // 2. Process nation table to get nation names
+    timer.Switch(Phase::kIo);
     auto maybe_nation_file = arrow::io::ReadableFile::Open(nation_file);
     if (!maybe_nation_file.ok()) {
         std::cerr << "Could not open nation file: " << maybe_nation_file.status().ToString() << std::endl;
@@ -184,10 +192,12 @@ int main(int argc, char** argv) {
         std::cerr << "Could not read nation table: " << status.ToString() << std::endl;
         return 1;
     }
+    timer.Count(nation_table->num_rows(), arrow::util::TotalBufferSize(*nation_table));
     
     std::cout << "Nation table loaded with " << nation_table->num_rows() << " rows" << std::endl;
     
     // Build a map of nationkey to nation name
+    timer.Switch(Phase::kJoinBuild);
     std::map<int64_t, std::string> nation_map;
     
     auto n_nationkey_col = nation_table->GetColumnByName("n_nationkey");
@@ -210,6 +220,7 @@ int main(int argc, char** argv) {
     }
     
     // 3. Process supplier table to get supplier nation relationships
+    timer.Switch(Phase::kIo);
     auto maybe_supplier_file = arrow::io::ReadableFile::Open(supplier_file);
     if (!maybe_supplier_file.ok()) {
         std::cerr << "Could not open supplier file: " << maybe_supplier_file.status().ToString() << std::endl;
@@ -230,10 +241,12 @@ int main(int argc, char** argv) {
         std::cerr << "Could not read supplier table: " << status.ToString() << std::endl;
         return 1;
     }
+    timer.Count(supplier_table->num_rows(), arrow::util::TotalBufferSize(*supplier_table));
     
     std::cout << "Supplier table loaded with " << supplier_table->num_rows() << " rows" << std::endl;
     
     // Map suppliers to nations
+    timer.Switch(Phase::kJoinBuild);
     std::map<int64_t, int64_t> supplier_nation_map;
     
     auto s_suppkey_col = supplier_table->GetColumnByName("s_suppkey");
@@ -256,6 +269,7 @@ int main(int argc, char** argv) {
     }
     
     // 4. Process partsupp table to get supply costs
+    timer.Switch(Phase::kIo);
     auto maybe_partsupp_file = arrow::io::ReadableFile::Open(partsupp_file);
     if (!maybe_partsupp_file.ok()) {
         std::cerr << "Could not open partsupp file: " << maybe_partsupp_file.status().ToString() << std::endl;
@@ -276,10 +290,12 @@ int main(int argc, char** argv) {
         std::cerr << "Could not read partsupp table: " << status.ToString() << std::endl;
         return 1;
     }
+    timer.Count(partsupp_table->num_rows(), arrow::util::TotalBufferSize(*partsupp_table));
     
     std::cout << "Partsupp table loaded with " << partsupp_table->num_rows() << " rows" << std::endl;
     
     // Create a composite key for partsupp (partkey, suppkey) -> supplycost
+    timer.Switch(Phase::kJoinBuild);
     std::map<std::pair<int64_t, int64_t>, double> partsupp_cost_map;
     
     auto ps_partkey_col = partsupp_table->GetColumnByName("ps_partkey");
@@ -322,6 +338,7 @@ int main(int argc, char** argv) {
     std::cout << "Found " << partsupp_cost_map.size() << " part-supplier combinations for green parts" << std::endl;
     
     // 5. Process orders table to get order dates
+    timer.Switch(Phase::kIo);
     auto maybe_orders_file = arrow::io::ReadableFile::Open(orders_file);
     if (!maybe_orders_file.ok()) {
         std::cerr << "Could not open orders file: " << maybe_orders_file.status().ToString() << std::endl;
@@ -342,10 +359,12 @@ int main(int argc, char** argv) {
         std::cerr << "Could not read orders table: " << status.ToString() << std::endl;
         return 1;
     }
+    timer.Count(orders_table->num_rows(), arrow::util::TotalBufferSize(*orders_table));
     
     std::cout << "Orders table loaded with " << orders_table->num_rows() << " rows" << std::endl;
     
     // Map orderkey to order year
+    timer.Switch(Phase::kJoinBuild);
     std::map<int64_t, int32_t> order_year_map;
     
     auto o_orderkey_col = orders_table->GetColumnByName("o_orderkey");
@@ -371,6 +390,7 @@ int main(int argc, char** argv) {
     }
     
     // 6. Process lineitem table and compute profits
+    timer.Switch(Phase::kIo);
     auto maybe_lineitem_file = arrow::io::ReadableFile::Open(lineitem_file);
     if (!maybe_lineitem_file.ok()) {
         std::cerr << "Could not open lineitem file: " << maybe_lineitem_file.status().ToString() << std::endl;
@@ -391,6 +411,7 @@ int main(int argc, char** argv) {
         std::cerr << "Could not read lineitem table: " << status.ToString() << std::endl;
         return 1;
     }
+    timer.Count(lineitem_table->num_rows(), arrow::util::TotalBufferSize(*lineitem_table));
     
     std::cout << "Lineitem table loaded with " << lineitem_table->num_rows() << " rows" << std::endl;
     
@@ -402,7 +423,9 @@ int main(int argc, char** argv) {
     auto l_extendedprice_col = lineitem_table->GetColumnByName("l_extendedprice");
     auto l_discount_col = lineitem_table->GetColumnByName("l_discount");
     
-    // Calculate profits grouped by nation and year
+    // Calculate profits grouped by nation and year; the row loop is
+    // dominated by the map lookups
+    timer.Switch(Phase::kProbe);
     std::map<NationYearKey, double> profit_by_nation_year;
     int64_t rows_processed = 0;
     int64_t rows_qualified = 0;
@@ -499,6 +522,7 @@ int main(int argc, char** argv) {
     }
     
     // Convert map to vector for sorting
+    timer.Switch(Phase::kAggregate);
     std::vector<Query9Result> results;
     for (const auto& [key, profit] : profit_by_nation_year) {
         Query9Result result;
@@ -510,6 +534,7 @@ int main(int argc, char** argv) {
     
     // Sort results by nation, o_year DESC
     std::sort(results.begin(), results.end());
+    timer.Stop();
     
     auto end_time = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed = end_time - start_time;
@@ -525,10 +550,13 @@ int main(int argc, char** argv) {
         std::cout << std::setw(25) << result.nation
                   << std::setw(10) << result.o_year
                   << std::setw(20) << std::fixed << std::setprecision(2) << result.sum_profit << std::endl;
+        QueryProfile::Global().AddRow({result.nation, ResultField(result.o_year),
+                                       ResultField(result.sum_profit)});
     }
     
     std::cout << "\nQuery executed in " << elapsed.count() << " seconds" << std::endl;
     std::cout << "Processed " << rows_processed << " lineitem rows, " << rows_qualified << " qualified" << std::endl;
     
+    WriteProfile();
     return 0;
 }
\ No newline at end of file
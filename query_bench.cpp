@@ -0,0 +1,668 @@
+// Benchmark driver for the query binaries.
+//
+//   query_bench [options] <query> <input files...> [-- <rvv_query options>]
+//
+// Runs query<N> and/or rvv_query<N> on the same inputs: a few warmup runs,
+// then the measured repetitions. Each run is a fresh process whose phase
+// times and result rows come back through QUERY_PROFILE (query_profile.h);
+// stdout of the query is discarded. Reports min / median / p95 per phase
+// plus the wall time of the whole process, which, unlike each binary's own
+// "Query executed in" line, always includes opening the files. With both
+// implementations the results of their last runs are compared.
+//
+// --counters also collects hardware counters per phase (QUERY_COUNTERS=1,
+// see perf_counters.h) and derives IPC, rows / cycle and bytes / cycle from
+// the work each phase reports.
+//
+// --cold drops the input files from the page cache before every run
+// (posix_fadvise DONTNEED, no root needed), so the io phase includes the
+// device reads; without it all but the first run hit a warm cache.
+//
+// Runs with a pipelined scan (--prefetch=N) also report how much of the
+// background decode time the consumers did not have to wait for.
+#include "query_profile.h"
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+enum class Format { kText, kCsv, kJson };
+
+struct BenchOptions {
+  int warmup = 1;
+  int repeat = 5;
+  bool run_scalar = true;
+  bool run_rvv = true;
+  bool check = true;
+  bool counters = false;
+  bool cold = false;
+  // Relative tolerance of the result check, on top of the precision printed
+  double tolerance = 1e-6;
+  Format format = Format::kText;
+  std::string bin_dir;
+  std::string query;
+  std::vector<std::string> inputs;
+  std::vector<std::string> rvv_args;
+};
+
+// One run of a query binary
+struct RunResult {
+  double wall_seconds = 0;
+  std::map<std::string, double> phase_seconds;
+  // Per phase: "rows", "bytes" and the counters by name
+  std::map<std::string, std::map<std::string, double>> phase_metrics;
+  // Pipelined scans only: background decode and consumer wait time
+  bool has_prefetch = false;
+  double prefetch_decoded = 0;
+  double prefetch_stalled = 0;
+  std::vector<std::vector<std::string>> rows;
+};
+
+struct Stats {
+  double min = 0;
+  double median = 0;
+  double p95 = 0;
+};
+
+// Everything measured for one implementation
+struct ImplResult {
+  std::string binary;
+  std::vector<RunResult> runs;
+  RunResult last;
+};
+
+const char* const kTotal = "total";
+
+const char* Usage() {
+  return "Usage: query_bench [--warmup=N] [--repeat=N] "
+         "[--impl=scalar|rvv|both] [--format=text|csv|json] [--no-check] "
+         "[--counters] [--cold] "
+         "[--tolerance=R] [--bin-dir=DIR] <1|4|6|9|12|14> <input files...> "
+         "[-- <rvv_query options>]";
+}
+
+bool ParseInt(const std::string& text, int min, int* out) {
+  char* end = nullptr;
+  long value = std::strtol(text.c_str(), &end, 10);
+  if (text.empty() || *end != '\0' || value < min || value > 1000000) {
+    return false;
+  }
+  *out = static_cast<int>(value);
+  return true;
+}
+
+std::string DirectoryOfSelf() {
+  char path[4096];
+  ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+  if (length <= 0) {
+    return ".";
+  }
+  std::string self(path, length);
+  size_t slash = self.rfind('/');
+  return slash == std::string::npos ? "." : self.substr(0, slash);
+}
+
+// Returns an error message, empty on success.
+std::string ParseOptions(int argc, char** argv, BenchOptions* options) {
+  int i = 1;
+  for (; i < argc && std::strncmp(argv[i], "--", 2) == 0; i++) {
+    std::string arg = argv[i];
+    if (arg == "--") {
+      return "missing query";
+    } else if (arg.rfind("--warmup=", 0) == 0) {
+      if (!ParseInt(arg.substr(9), 0, &options->warmup)) {
+        return "invalid warmup count: " + arg.substr(9);
+      }
+    } else if (arg.rfind("--repeat=", 0) == 0) {
+      if (!ParseInt(arg.substr(9), 1, &options->repeat)) {
+        return "invalid repetition count: " + arg.substr(9);
+      }
+    } else if (arg == "--impl=scalar" || arg == "--impl=rvv" ||
+               arg == "--impl=both") {
+      options->run_scalar = arg != "--impl=rvv";
+      options->run_rvv = arg != "--impl=scalar";
+    } else if (arg == "--format=text") {
+      options->format = Format::kText;
+    } else if (arg == "--format=csv") {
+      options->format = Format::kCsv;
+    } else if (arg == "--format=json") {
+      options->format = Format::kJson;
+    } else if (arg == "--no-check") {
+      options->check = false;
+    } else if (arg == "--counters") {
+      options->counters = true;
+    } else if (arg == "--cold") {
+      options->cold = true;
+    } else if (arg.rfind("--tolerance=", 0) == 0) {
+      char* end = nullptr;
+      options->tolerance = std::strtod(arg.c_str() + 12, &end);
+      if (*end != '\0' || !(options->tolerance >= 0)) {
+        return "invalid tolerance: " + arg.substr(12);
+      }
+    } else if (arg.rfind("--bin-dir=", 0) == 0) {
+      options->bin_dir = arg.substr(10);
+    } else {
+      return "unknown option: " + arg;
+    }
+  }
+  if (i == argc) {
+    return "missing query";
+  }
+  options->query = argv[i++];
+  static const char* const kQueries[] = {"1", "4", "6", "9", "12", "14"};
+  if (std::find_if(std::begin(kQueries), std::end(kQueries),
+                   [&](const char* q) { return options->query == q; }) ==
+      std::end(kQueries)) {
+    return "unknown query: " + options->query;
+  }
+  // Q14 only exists as rvv_query14
+  if (options->query == "14" && options->run_scalar) {
+    return "there is no scalar Q14; use --impl=rvv";
+  }
+  for (; i < argc && std::strcmp(argv[i], "--") != 0; i++) {
+    options->inputs.push_back(argv[i]);
+  }
+  if (options->inputs.empty()) {
+    return "missing input files";
+  }
+  for (i++; i < argc; i++) {
+    options->rvv_args.push_back(argv[i]);
+  }
+  if (options->bin_dir.empty()) {
+    options->bin_dir = DirectoryOfSelf();
+  }
+  return "";
+}
+
+bool ReadProfile(const std::string& path, RunResult* run) {
+  std::ifstream in(path);
+  if (!in) {
+    return false;
+  }
+  std::string line;
+  while (std::getline(in, line)) {
+    std::vector<std::string> fields;
+    std::istringstream split(line);
+    for (std::string field; std::getline(split, field, '\t');) {
+      fields.push_back(field);
+    }
+    if (fields.size() == 3 && fields[0] == "phase") {
+      run->phase_seconds[fields[1]] = std::strtod(fields[2].c_str(), nullptr);
+    } else if (fields.size() == 4 && fields[0] == "work") {
+      auto& metrics = run->phase_metrics[fields[1]];
+      metrics["rows"] = std::strtod(fields[2].c_str(), nullptr);
+      metrics["bytes"] = std::strtod(fields[3].c_str(), nullptr);
+    } else if (fields.size() == 4 && fields[0] == "counter") {
+      run->phase_metrics[fields[1]][fields[2]] =
+          std::strtod(fields[3].c_str(), nullptr);
+    } else if (fields.size() == 3 && fields[0] == "prefetch") {
+      run->has_prefetch = true;
+      run->prefetch_decoded = std::strtod(fields[1].c_str(), nullptr);
+      run->prefetch_stalled = std::strtod(fields[2].c_str(), nullptr);
+    } else if (!fields.empty() && fields[0] == "row") {
+      fields.erase(fields.begin());
+      run->rows.push_back(std::move(fields));
+    }
+  }
+  return true;
+}
+
+// Asks the kernel to drop the cached pages of each file. Pages that are
+// dirty or still mapped elsewhere stay. Returns an error message, empty on
+// success.
+std::string EvictFromPageCache(const std::vector<std::string>& paths) {
+  for (const auto& path : paths) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return "cannot open " + path + ": " + std::strerror(errno);
+    }
+    int error = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+    if (error != 0) {
+      return "cannot evict " + path + ": " + std::strerror(error);
+    }
+  }
+  return "";
+}
+
+// Runs binary with args in a child process, stdout discarded. Returns an
+// error message, empty on success.
+std::string RunOnce(const std::string& binary,
+                    const std::vector<std::string>& args, bool counters,
+                    RunResult* run) {
+  char profile_path[] = "/tmp/query_bench.XXXXXX";
+  int profile_fd = mkstemp(profile_path);
+  if (profile_fd < 0) {
+    return std::string("cannot create profile file: ") + std::strerror(errno);
+  }
+  close(profile_fd);
+
+  std::vector<char*> argv;
+  argv.push_back(const_cast<char*>(binary.c_str()));
+  for (const auto& arg : args) {
+    argv.push_back(const_cast<char*>(arg.c_str()));
+  }
+  argv.push_back(nullptr);
+
+  auto start = std::chrono::steady_clock::now();
+  pid_t pid = fork();
+  if (pid < 0) {
+    unlink(profile_path);
+    return std::string("fork failed: ") + std::strerror(errno);
+  }
+  if (pid == 0) {
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (null_fd >= 0) {
+      dup2(null_fd, STDOUT_FILENO);
+    }
+    setenv("QUERY_PROFILE", profile_path, 1);
+    if (counters) {
+      setenv("QUERY_COUNTERS", "1", 1);
+    }
+    execv(binary.c_str(), argv.data());
+    std::perror(binary.c_str());
+    _exit(127);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  run->wall_seconds = std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+
+  std::string error;
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    error = binary + " failed with status " + std::to_string(status);
+  } else if (!ReadProfile(profile_path, run)) {
+    error = "cannot read profile of " + binary;
+  }
+  unlink(profile_path);
+  run->phase_seconds[kTotal] = run->wall_seconds;
+  return error;
+}
+
+// Nearest-rank statistics
+Stats Summarize(std::vector<double> samples) {
+  std::sort(samples.begin(), samples.end());
+  Stats stats;
+  size_t n = samples.size();
+  stats.min = samples.front();
+  stats.median = n % 2 == 1 ? samples[n / 2]
+                            : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+  size_t rank = static_cast<size_t>(std::ceil(0.95 * n));
+  stats.p95 = samples[std::max<size_t>(rank, 1) - 1];
+  return stats;
+}
+
+std::vector<std::string> PhaseNames() {
+  std::vector<std::string> names;
+  for (int p = 0; p < kNumPhases; p++) {
+    names.push_back(PhaseName(static_cast<Phase>(p)));
+  }
+  names.push_back(kTotal);
+  return names;
+}
+
+Stats PhaseStats(const ImplResult& impl, const std::string& phase) {
+  std::vector<double> samples;
+  for (const auto& run : impl.runs) {
+    auto it = run.phase_seconds.find(phase);
+    samples.push_back(it == run.phase_seconds.end() ? 0.0 : it->second);
+  }
+  return Summarize(samples);
+}
+
+// Median of a phase metric over the measured runs; NaN if some run did not
+// report it.
+double MetricMedian(const ImplResult& impl, const std::string& phase,
+                    const std::string& metric) {
+  std::vector<double> samples;
+  for (const auto& run : impl.runs) {
+    auto by_phase = run.phase_metrics.find(phase);
+    if (by_phase == run.phase_metrics.end()) {
+      return NAN;
+    }
+    auto it = by_phase->second.find(metric);
+    if (it == by_phase->second.end()) {
+      return NAN;
+    }
+    samples.push_back(it->second);
+  }
+  return samples.empty() ? NAN : Summarize(samples).median;
+}
+
+// Medians over the runs of a pipelined scan; overlap is the share of the
+// background decode time that was not waited for.
+struct PrefetchStats {
+  double decoded = 0;
+  double stalled = 0;
+  double overlap = 0;
+
+  // False unless every run was pipelined.
+  static bool Of(const ImplResult& impl, PrefetchStats* stats) {
+    std::vector<double> decoded, stalled, overlap;
+    for (const auto& run : impl.runs) {
+      if (!run.has_prefetch) {
+        return false;
+      }
+      decoded.push_back(run.prefetch_decoded);
+      stalled.push_back(run.prefetch_stalled);
+      overlap.push_back(run.prefetch_decoded > 0
+                            ? std::max(0.0, 1 - run.prefetch_stalled /
+                                                    run.prefetch_decoded)
+                            : 0.0);
+    }
+    if (impl.runs.empty()) {
+      return false;
+    }
+    stats->decoded = Summarize(decoded).median;
+    stats->stalled = Summarize(stalled).median;
+    stats->overlap = Summarize(overlap).median;
+    return true;
+  }
+};
+
+const char* const kMetrics[] = {"rows",         "bytes",
+                                "cycles",       "instructions",
+                                "cache_misses", "vector_instructions"};
+
+// Medians of kMetrics followed by the derived ratios
+struct PhaseMetrics {
+  std::vector<std::pair<std::string, double>> values;
+
+  static PhaseMetrics Of(const ImplResult& impl, const std::string& phase) {
+    PhaseMetrics metrics;
+    for (const char* name : kMetrics) {
+      metrics.values.push_back({name, MetricMedian(impl, phase, name)});
+    }
+    double rows = metrics.values[0].second;
+    double bytes = metrics.values[1].second;
+    double cycles = metrics.values[2].second;
+    double instructions = metrics.values[3].second;
+    auto ratio = [&](double a) { return cycles > 0 ? a / cycles : NAN; };
+    metrics.values.push_back({"ipc", ratio(instructions)});
+    metrics.values.push_back({"rows_per_cycle", ratio(rows)});
+    metrics.values.push_back({"bytes_per_cycle", ratio(bytes)});
+    return metrics;
+  }
+};
+
+// Digits after the decimal point, or -1 for a field printed in full
+// precision (an integer or an exponent form).
+int Decimals(const std::string& field) {
+  if (field.find_first_of("eE") != std::string::npos) {
+    return -1;
+  }
+  size_t point = field.find('.');
+  return point == std::string::npos ? -1
+                                    : static_cast<int>(field.size() - point - 1);
+}
+
+// Numbers match within the relative tolerance plus one unit in the last
+// place of the less precise side; anything else must match exactly.
+bool FieldsMatch(const std::string& a, const std::string& b, double tolerance) {
+  if (a == b) {
+    return true;
+  }
+  char* end_a = nullptr;
+  char* end_b = nullptr;
+  double x = std::strtod(a.c_str(), &end_a);
+  double y = std::strtod(b.c_str(), &end_b);
+  if (a.empty() || b.empty() || *end_a != '\0' || *end_b != '\0') {
+    return false;
+  }
+  int da = Decimals(a);
+  int db = Decimals(b);
+  int decimals = da < 0 ? db : (db < 0 ? da : std::min(da, db));
+  double unit = decimals < 0 ? 0.0 : std::pow(10.0, -decimals);
+  return std::fabs(x - y) <=
+         unit + tolerance * std::max(std::fabs(x), std::fabs(y));
+}
+
+// Returns the differences between the two result sets, one per line.
+std::vector<std::string> CompareResults(const RunResult& scalar,
+                                        const RunResult& rvv,
+                                        double tolerance) {
+  std::vector<std::string> mismatches;
+  if (scalar.rows.size() != rvv.rows.size()) {
+    mismatches.push_back("row count " + std::to_string(scalar.rows.size()) +
+                         " vs " + std::to_string(rvv.rows.size()));
+    return mismatches;
+  }
+  for (size_t r = 0; r < scalar.rows.size(); r++) {
+    const auto& a = scalar.rows[r];
+    const auto& b = rvv.rows[r];
+    bool same = a.size() == b.size();
+    for (size_t f = 0; same && f < a.size(); f++) {
+      same = FieldsMatch(a[f], b[f], tolerance);
+    }
+    if (!same) {
+      std::string line = "row " + std::to_string(r) + ":";
+      for (const auto& field : a) line += " " + field;
+      line += " vs";
+      for (const auto& field : b) line += " " + field;
+      mismatches.push_back(line);
+    }
+  }
+  return mismatches;
+}
+
+std::string JsonString(const std::string& text) {
+  std::string out = "\"";
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      out += escaped;
+    } else {
+      out += c;
+    }
+  }
+  return out + "\"";
+}
+
+void Report(const BenchOptions& options,
+            const std::vector<std::pair<std::string, ImplResult>>& impls,
+            bool checked, const std::vector<std::string>& mismatches) {
+  const auto phases = PhaseNames();
+  std::ostream& out = std::cout;
+  out.precision(6);
+  if (options.format == Format::kCsv) {
+    out << "query,impl,phase,runs,min_s,median_s,p95_s";
+    for (const char* metric : kMetrics) {
+      out << ',' << metric;
+    }
+    out << ",ipc,rows_per_cycle,bytes_per_cycle\n";
+    for (const auto& [name, impl] : impls) {
+      for (const auto& phase : phases) {
+        Stats stats = PhaseStats(impl, phase);
+        out << options.query << ',' << name << ',' << phase << ','
+            << impl.runs.size() << ',' << stats.min << ',' << stats.median
+            << ',' << stats.p95;
+        // Empty where the phase or the counter reported nothing
+        for (const auto& [metric, value] : PhaseMetrics::Of(impl, phase).values) {
+          out << ',';
+          if (!std::isnan(value)) {
+            out << value;
+          }
+        }
+        out << '\n';
+      }
+    }
+    for (const auto& [name, impl] : impls) {
+      PrefetchStats prefetch;
+      if (PrefetchStats::Of(impl, &prefetch)) {
+        out << "# prefetch " << name << " decoded_s=" << prefetch.decoded
+            << " stalled_s=" << prefetch.stalled
+            << " overlap=" << prefetch.overlap << '\n';
+      }
+    }
+    if (checked) {
+      out << "# results " << (mismatches.empty() ? "match" : "differ")
+          << '\n';
+    }
+  } else if (options.format == Format::kJson) {
+    out << "{\"query\": " << options.query << ", \"warmup\": "
+        << options.warmup << ", \"repeat\": " << options.repeat
+        << ", \"implementations\": [";
+    for (size_t i = 0; i < impls.size(); i++) {
+      const auto& [name, impl] = impls[i];
+      out << (i ? ", " : "") << "{\"impl\": " << JsonString(name)
+          << ", \"binary\": " << JsonString(impl.binary) << ", \"phases\": {";
+      for (size_t p = 0; p < phases.size(); p++) {
+        Stats stats = PhaseStats(impl, phases[p]);
+        out << (p ? ", " : "") << JsonString(phases[p]) << ": {\"min\": "
+            << stats.min << ", \"median\": " << stats.median
+            << ", \"p95\": " << stats.p95;
+        for (const auto& [metric, value] :
+             PhaseMetrics::Of(impl, phases[p]).values) {
+          if (!std::isnan(value)) {
+            out << ", " << JsonString(metric) << ": " << value;
+          }
+        }
+        out << "}";
+      }
+      out << "}";
+      PrefetchStats prefetch;
+      if (PrefetchStats::Of(impl, &prefetch)) {
+        out << ", \"prefetch\": {\"decoded\": " << prefetch.decoded
+            << ", \"stalled\": " << prefetch.stalled
+            << ", \"overlap\": " << prefetch.overlap << "}";
+      }
+      out << "}";
+    }
+    out << "]";
+    if (checked) {
+      out << ", \"check\": {\"match\": "
+          << (mismatches.empty() ? "true" : "false") << ", \"mismatches\": [";
+      for (size_t i = 0; i < mismatches.size(); i++) {
+        out << (i ? ", " : "") << JsonString(mismatches[i]);
+      }
+      out << "]}";
+    }
+    out << "}\n";
+  } else {
+    out << "Query " << options.query << ": " << options.warmup
+        << " warmup, " << options.repeat << " measured runs (seconds; "
+        << "phases summed over threads)\n";
+    for (const auto& [name, impl] : impls) {
+      out << '\n' << name << " (" << impl.binary << ")\n";
+      out << "  phase            min      median         p95\n";
+      for (const auto& phase : phases) {
+        Stats stats = PhaseStats(impl, phase);
+        char line[128];
+        std::snprintf(line, sizeof(line), "  %-10s %11.6f %11.6f %11.6f\n",
+                      phase.c_str(), stats.min, stats.median, stats.p95);
+        out << line;
+      }
+      PrefetchStats prefetch;
+      if (PrefetchStats::Of(impl, &prefetch)) {
+        char line[160];
+        std::snprintf(line, sizeof(line),
+                      "  prefetch: %.6f s decoded ahead, %.6f s stalled, "
+                      "%.1f%% overlapped\n",
+                      prefetch.decoded, prefetch.stalled,
+                      100 * prefetch.overlap);
+        out << line;
+      }
+      if (options.counters) {
+        out << "  phase             rows        bytes       cycles    IPC"
+               "   misses  vector_ins  rows/cyc  bytes/cyc\n";
+        for (const auto& phase : phases) {
+          if (phase == kTotal) {
+            continue;
+          }
+          const auto values = PhaseMetrics::Of(impl, phase).values;
+          auto get = [&](size_t i) {
+            return std::isnan(values[i].second) ? 0.0 : values[i].second;
+          };
+          char line[192];
+          std::snprintf(line, sizeof(line),
+                        "  %-10s %12.0f %12.0f %12.0f %6.2f %8.0f %11.0f "
+                        "%9.4f %10.4f\n",
+                        phase.c_str(), get(0), get(1), get(2), get(6), get(4),
+                        get(5), get(7), get(8));
+          out << line;
+        }
+      }
+    }
+    if (checked) {
+      out << "\nResults " << (mismatches.empty() ? "match" : "differ") << '\n';
+      for (const auto& mismatch : mismatches) {
+        out << "  " << mismatch << '\n';
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  BenchOptions options;
+  std::string error = ParseOptions(argc, argv, &options);
+  if (!error.empty()) {
+    std::cerr << "Error: " << error << '\n' << Usage() << std::endl;
+    return 1;
+  }
+
+  std::vector<std::pair<std::string, ImplResult>> impls;
+  if (options.run_scalar) {
+    impls.push_back({"scalar", {}});
+    impls.back().second.binary = options.bin_dir + "/query" + options.query;
+  }
+  if (options.run_rvv) {
+    impls.push_back({"rvv", {}});
+    impls.back().second.binary = options.bin_dir + "/rvv_query" + options.query;
+  }
+
+  for (auto& [name, impl] : impls) {
+    std::vector<std::string> args = options.inputs;
+    if (name == "rvv") {
+      args.insert(args.end(), options.rvv_args.begin(), options.rvv_args.end());
+    }
+    for (int i = 0; i < options.warmup + options.repeat; i++) {
+      RunResult run;
+      if (options.cold) {
+        error = EvictFromPageCache(options.inputs);
+      }
+      if (error.empty()) {
+        error = RunOnce(impl.binary, args, options.counters, &run);
+      }
+      if (!error.empty()) {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+      }
+      if (i >= options.warmup) {
+        impl.runs.push_back(run);
+      }
+      impl.last = std::move(run);
+    }
+  }
+
+  bool checked = options.check && impls.size() == 2;
+  std::vector<std::string> mismatches;
+  if (checked) {
+    mismatches = CompareResults(impls[0].second.last, impls[1].second.last,
+                                options.tolerance);
+  }
+  Report(options, impls, checked, mismatches);
+  return mismatches.empty() ? 0 : 2;
+}
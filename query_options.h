@@ -0,0 +1,84 @@
+// Command-line options shared by the rvv_query* binaries. Options follow the
+// positional file arguments, e.g. `rvv_query6 lineitem.parquet --agg=float`.
+#pragma once
+
+#include "parquet_scan.h"
+
+#include <arrow/status.h>
+
+#include <cstdlib>
+#include <string>
+
+// How decimal aggregates are accumulated.
+enum class AggMode {
+  kExact,  // scaled integers, 128-bit accumulation; matches the SQL result
+  kFloat,  // floating-point accumulation; result depends on summation order
+};
+
+struct QueryOptions {
+  AggMode agg_mode = AggMode::kExact;
+  // Worker threads for the parallel scan; 0 means one per hardware thread.
+  int num_threads = 0;
+  // How the input files are read; see InputOptions.
+  InputOptions input;
+  // Where built join state is cached across runs (join_cache.h); empty
+  // disables the cache. Used by the queries with a reusable build side.
+  std::string join_cache_dir;
+};
+
+inline const char* QueryOptionsUsage() {
+  return "[--agg=exact|float] [--threads=N] [--io=read|mmap] "
+         "[--buffered-stream=BYTES] [--pre-buffer] [--prefetch=ROW_GROUPS] "
+         "[--join-cache=DIR]";
+}
+
+// Parses argv[first..argc) into options.
+inline arrow::Status ParseQueryOptions(int argc, char** argv, int first,
+                                       QueryOptions* options) {
+  for (int i = first; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--agg=exact") {
+      options->agg_mode = AggMode::kExact;
+    } else if (arg == "--agg=float") {
+      options->agg_mode = AggMode::kFloat;
+    } else if (arg.rfind("--threads=", 0) == 0) {
+      std::string value = arg.substr(10);
+      char* end = nullptr;
+      long threads = std::strtol(value.c_str(), &end, 10);
+      if (value.empty() || *end != '\0' || threads < 1 || threads > 1024) {
+        return arrow::Status::Invalid("Invalid thread count: ", value);
+      }
+      options->num_threads = static_cast<int>(threads);
+    } else if (arg == "--io=read") {
+      options->input.mode = InputMode::kRead;
+    } else if (arg == "--io=mmap") {
+      options->input.mode = InputMode::kMmap;
+    } else if (arg.rfind("--buffered-stream=", 0) == 0) {
+      std::string value = arg.substr(18);
+      char* end = nullptr;
+      long long bytes = std::strtoll(value.c_str(), &end, 10);
+      if (value.empty() || *end != '\0' || bytes < 1) {
+        return arrow::Status::Invalid("Invalid buffer size: ", value);
+      }
+      options->input.buffered_stream_size = bytes;
+    } else if (arg == "--pre-buffer") {
+      options->input.pre_buffer = true;
+    } else if (arg.rfind("--prefetch=", 0) == 0) {
+      std::string value = arg.substr(11);
+      char* end = nullptr;
+      long depth = std::strtol(value.c_str(), &end, 10);
+      if (value.empty() || *end != '\0' || depth < 0 || depth > 64) {
+        return arrow::Status::Invalid("Invalid prefetch depth: ", value);
+      }
+      options->input.prefetch_row_groups = static_cast<int>(depth);
+    } else if (arg.rfind("--join-cache=", 0) == 0) {
+      options->join_cache_dir = arg.substr(13);
+      if (options->join_cache_dir.empty()) {
+        return arrow::Status::Invalid("Empty join cache directory");
+      }
+    } else {
+      return arrow::Status::Invalid("Unknown option: ", arg);
+    }
+  }
+  return arrow::Status::OK();
+}
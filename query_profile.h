@@ -0,0 +1,229 @@
+// Phase timing and result capture for the benchmark driver (query_bench.cpp).
+//
+// Every query* / rvv_query* binary charges its work to the phases below
+// with PhaseTimer and hands its result rows to QueryProfile::AddRow. When
+// the QUERY_PROFILE environment variable names a file, WriteProfile() stores
+// both there, one tab-separated record per line:
+//
+//   phase <name> <seconds>
+//   work <phase> <rows> <bytes>
+//   counter <phase> <counter> <value>
+//   prefetch <decoded_seconds> <stalled_seconds>
+//   row <field> <field> ...
+//
+// Time spent in worker threads is summed over the threads, so a parallel
+// scan can charge a phase more than the wall time of the run. Fused loops
+// that do several things per row charge the phase that dominates them.
+// Work is what the code of a phase reports through PhaseTimer::Count: rows
+// processed and bytes of input columns read. Counter lines only appear with
+// QUERY_COUNTERS=1 (perf_counters.h). The prefetch line only appears for
+// pipelined scans (parquet_scan.h): row-group decoding done on background
+// threads, which is also charged to io, and the time consumers waited for
+// it.
+#pragma once
+
+#include "perf_counters.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <initializer_list>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+enum class Phase {
+  kIo,         // file access and Parquet decoding into Arrow arrays
+  kDecode,     // Arrow columns into kernel inputs (decimals, dictionaries)
+  kFilter,     // predicates and selection
+  kJoinBuild,  // hash tables, maps and semi-join filters over build sides
+  kProbe,      // lookups into them
+  kAggregate,  // grouping, sums and the final result
+};
+
+constexpr int kNumPhases = 6;
+
+inline const char* PhaseName(Phase phase) {
+  static const char* const kNames[kNumPhases] = {
+      "io", "decode", "filter", "join_build", "probe", "aggregate"};
+  return kNames[static_cast<int>(phase)];
+}
+
+class QueryProfile {
+ public:
+  // The profile of this process.
+  static QueryProfile& Global() {
+    static QueryProfile profile;
+    return profile;
+  }
+
+  void AddTime(Phase phase, std::chrono::nanoseconds elapsed) {
+    nanoseconds_[static_cast<int>(phase)].fetch_add(
+        elapsed.count(), std::memory_order_relaxed);
+  }
+
+  void AddWork(Phase phase, int64_t rows, int64_t bytes) {
+    rows_processed_[static_cast<int>(phase)].fetch_add(
+        rows, std::memory_order_relaxed);
+    bytes_read_[static_cast<int>(phase)].fetch_add(bytes,
+                                                   std::memory_order_relaxed);
+  }
+
+  // Adds the counter deltas between two readings of one thread.
+  void AddCounters(Phase phase, const ThreadCounters& counters,
+                   const CounterValues& start, const CounterValues& end) {
+    for (int c = 0; c < kNumCounters; c++) {
+      if (counters.available(static_cast<Counter>(c))) {
+        counter_available_[c].store(true, std::memory_order_relaxed);
+        counters_[static_cast<int>(phase)][c].fetch_add(
+            end.value[c] - start.value[c], std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Background decode time of a pipelined scan, and consumer wait time.
+  void AddPrefetch(std::chrono::nanoseconds decoded,
+                   std::chrono::nanoseconds stalled) {
+    prefetch_decoded_.fetch_add(decoded.count(), std::memory_order_relaxed);
+    prefetch_stalled_.fetch_add(stalled.count(), std::memory_order_relaxed);
+    prefetch_used_.store(true, std::memory_order_relaxed);
+  }
+
+  // One result row. Numbers are compared numerically by the driver, to the
+  // precision the less precise side printed.
+  void AddRow(std::initializer_list<std::string> fields) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rows_.emplace_back(fields);
+  }
+
+  // Writes the profile to $QUERY_PROFILE; a no-op when it is unset.
+  void Write() const {
+    const char* path = std::getenv("QUERY_PROFILE");
+    if (path == nullptr || *path == '\0') {
+      return;
+    }
+    std::ofstream out(path);
+    for (int p = 0; p < kNumPhases; p++) {
+      const char* name = PhaseName(static_cast<Phase>(p));
+      out << "phase\t" << name << '\t'
+          << nanoseconds_[p].load(std::memory_order_relaxed) * 1e-9 << '\n';
+      out << "work\t" << name << '\t'
+          << rows_processed_[p].load(std::memory_order_relaxed) << '\t'
+          << bytes_read_[p].load(std::memory_order_relaxed) << '\n';
+      for (int c = 0; c < kNumCounters; c++) {
+        if (counter_available_[c].load(std::memory_order_relaxed)) {
+          out << "counter\t" << name << '\t'
+              << CounterName(static_cast<Counter>(c)) << '\t'
+              << counters_[p][c].load(std::memory_order_relaxed) << '\n';
+        }
+      }
+    }
+    if (prefetch_used_.load(std::memory_order_relaxed)) {
+      out << "prefetch\t"
+          << prefetch_decoded_.load(std::memory_order_relaxed) * 1e-9 << '\t'
+          << prefetch_stalled_.load(std::memory_order_relaxed) * 1e-9 << '\n';
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& row : rows_) {
+      out << "row";
+      for (const auto& field : row) {
+        out << '\t' << field;
+      }
+      out << '\n';
+    }
+  }
+
+ private:
+  QueryProfile() = default;
+
+  std::atomic<int64_t> nanoseconds_[kNumPhases] = {};
+  std::atomic<int64_t> rows_processed_[kNumPhases] = {};
+  std::atomic<int64_t> bytes_read_[kNumPhases] = {};
+  std::atomic<uint64_t> counters_[kNumPhases][kNumCounters] = {};
+  std::atomic<bool> counter_available_[kNumCounters] = {};
+  std::atomic<int64_t> prefetch_decoded_{0};
+  std::atomic<int64_t> prefetch_stalled_{0};
+  std::atomic<bool> prefetch_used_{false};
+  mutable std::mutex mutex_;
+  std::vector<std::vector<std::string>> rows_;
+};
+
+// Result fields as text; doubles keep all their digits.
+inline std::string ResultField(const std::string& text) { return text; }
+inline std::string ResultField(const char* text) { return text; }
+template <typename T,
+          typename = std::enable_if_t<std::is_integral<T>::value>>
+std::string ResultField(T value) {
+  return std::to_string(value);
+}
+inline std::string ResultField(double value) {
+  std::ostringstream out;
+  out.precision(17);
+  out << value;
+  return out.str();
+}
+
+// Charges the time (and with QUERY_COUNTERS=1 the counters of the calling
+// thread) until Stop() or destruction to a phase; Switch() moves on to the
+// next phase without a gap. A timer must stay on the thread that made it.
+class PhaseTimer {
+ public:
+  explicit PhaseTimer(Phase phase)
+      : phase_(phase), counters_(ThreadCounters::Get()) {
+    if (counters_) {
+      counters_start_ = counters_->Read();
+    }
+    start_ = std::chrono::steady_clock::now();
+  }
+  PhaseTimer(const PhaseTimer&) = delete;
+  PhaseTimer& operator=(const PhaseTimer&) = delete;
+  ~PhaseTimer() { Stop(); }
+
+  // Work done in the current phase, see QueryProfile.
+  void Count(int64_t rows, int64_t bytes) {
+    QueryProfile::Global().AddWork(phase_, rows, bytes);
+  }
+
+  void Switch(Phase phase) {
+    Charge();
+    phase_ = phase;
+    running_ = true;
+  }
+
+  void Stop() {
+    Charge();
+    running_ = false;
+  }
+
+ private:
+  // Charges the current phase, if any, and restarts the readings.
+  void Charge() {
+    auto now = std::chrono::steady_clock::now();
+    CounterValues counters_now;
+    if (counters_) {
+      counters_now = counters_->Read();
+    }
+    if (running_) {
+      QueryProfile::Global().AddTime(phase_, now - start_);
+      if (counters_) {
+        QueryProfile::Global().AddCounters(phase_, *counters_,
+                                           counters_start_, counters_now);
+      }
+    }
+    start_ = now;
+    counters_start_ = counters_now;
+  }
+
+  Phase phase_;
+  ThreadCounters* counters_;
+  CounterValues counters_start_;
+  std::chrono::steady_clock::time_point start_;
+  bool running_ = true;
+};
+
+// Writes the profile of this process, see QueryProfile::Write.
+inline void WriteProfile() { QueryProfile::Global().Write(); }
@@ -0,0 +1,81 @@
+#include "rvv_kernels.h"
+
+#include "rvv_ops.h"
+
+namespace rvv {
+
+using detail::RvvOps;
+
+namespace {
+
+// floor(x / d) for 0 <= x <= 146096 (one 400-year era of days) as
+// mulhu(x, m) >> shift, with m = ceil(2^(32 + shift) / d) for the largest
+// shift that keeps m in 32 bits. Exhaustively checked over that range.
+struct Divisor {
+  uint32_t m;
+  unsigned shift;
+};
+
+constexpr Divisor divisor_for(uint64_t d) {
+  unsigned shift = 0;
+  while (((uint64_t(1) << (33 + shift)) + d - 1) / d < (uint64_t(1) << 32)) {
+    shift++;
+  }
+  return {static_cast<uint32_t>(((uint64_t(1) << (32 + shift)) + d - 1) / d),
+          shift};
+}
+
+template <typename V>
+V divide(V x, Divisor d, size_t vl) {
+  return __riscv_vsrl(__riscv_vmulhu(x, d.m, vl), d.shift, vl);
+}
+
+constexpr Divisor kBy365 = divisor_for(365);
+constexpr Divisor kBy100 = divisor_for(100);
+constexpr Divisor kBy1460 = divisor_for(1460);
+constexpr Divisor kBy36524 = divisor_for(36524);
+constexpr Divisor kBy146096 = divisor_for(146096);
+
+}  // namespace
+
+// year_from_days (date_util.h) lane by lane. Only the era needs a real
+// signed division; everything below it is in [0, 146096] and divides by
+// multiply-high.
+template <int LMUL>
+void date32_to_year(const int32_t* days, int32_t* out, size_t n) {
+  using Ops = RvvOps<int32_t, LMUL>;
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    auto v_z = __riscv_vadd(Ops::load(days + i, vl), 719468, vl);
+    // Floor division: shift negative days down by one era minus one first
+    auto v_negative = __riscv_vmslt(v_z, 0, vl);
+    auto v_era = __riscv_vdiv(__riscv_vsub_mu(v_negative, v_z, v_z, 146096, vl),
+                              146097, vl);
+    auto v_doe = Ops::as_unsigned(__riscv_vnmsac(v_z, 146097, v_era, vl));
+    auto v_t = __riscv_vsub(v_doe, divide(v_doe, kBy1460, vl), vl);
+    v_t = __riscv_vadd(v_t, divide(v_doe, kBy36524, vl), vl);
+    v_t = __riscv_vsub(v_t, divide(v_doe, kBy146096, vl), vl);
+    auto v_yoe = divide(v_t, kBy365, vl);
+    // doy = doe - (365 * yoe + yoe / 4 - yoe / 100)
+    auto v_doy = __riscv_vnmsac(v_doe, 365u, v_yoe, vl);
+    v_doy = __riscv_vsub(v_doy, __riscv_vsrl(v_yoe, 2, vl), vl);
+    v_doy = __riscv_vadd(v_doy, divide(v_yoe, kBy100, vl), vl);
+    // yoe + 400 * era in wrapping unsigned arithmetic; January and February
+    // belong to the next calendar year
+    auto v_year = __riscv_vmacc(v_yoe, 400u, Ops::as_unsigned(v_era), vl);
+    auto v_jan_feb = __riscv_vmsgeu(v_doy, 306u, vl);
+    v_year = __riscv_vadd_mu(v_jan_feb, v_year, v_year, 1u, vl);
+    __riscv_vse32(reinterpret_cast<uint32_t*>(out + i), v_year, vl);
+  }
+}
+
+#define RVV_INSTANTIATE_DATE(LMUL)                                            \
+  template void date32_to_year<LMUL>(const int32_t*, int32_t*, size_t);
+
+RVV_INSTANTIATE_DATE(1)
+RVV_INSTANTIATE_DATE(2)
+RVV_INSTANTIATE_DATE(4)
+RVV_INSTANTIATE_DATE(8)
+
+}  // namespace rvv
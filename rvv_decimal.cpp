@@ -0,0 +1,220 @@
+#include "rvv_kernels.h"
+
+#include "rvv_ops.h"
+
+#include <type_traits>
+
+namespace rvv {
+
+using detail::RvvOps;
+
+namespace {
+
+// Byte distance between consecutive low (or high) halves.
+constexpr ptrdiff_t kDecimalStride = 16;
+
+constexpr double kPowersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,
+    1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+    1e20, 1e21, 1e22, 1e23, 1e24, 1e25, 1e26, 1e27, 1e28, 1e29,
+    1e30, 1e31, 1e32, 1e33, 1e34, 1e35, 1e36, 1e37, 1e38};
+
+// Slow path for values that really use the high 64 bits.
+inline double wide_decimal_to_double(const int64_t* words, double divisor) {
+  double raw = static_cast<double>(words[1]) * 18446744073709551616.0 +
+               static_cast<double>(static_cast<uint64_t>(words[0]));
+  return raw / divisor;
+}
+
+}  // namespace
+
+template <int LMUL>
+bool decode_decimal128_unscaled(const uint8_t* values, int64_t* out, size_t n) {
+  using Ops = RvvOps<int64_t, LMUL>;
+  const int64_t* words = reinterpret_cast<const int64_t*>(values);
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    auto v_lo = Ops::load_strided(words + 2 * i, kDecimalStride, vl);
+    auto v_hi = Ops::load_strided(words + 2 * i + 1, kDecimalStride, vl);
+    // The value fits in int64 iff the high half is the sign of the low half.
+    auto v_wide = __riscv_vmsne(v_hi, __riscv_vsra(v_lo, 63, vl), vl);
+    if (__riscv_vcpop(v_wide, vl) != 0) {
+      return false;
+    }
+    Ops::store(out + i, v_lo, vl);
+  }
+  return true;
+}
+
+template <int LMUL>
+bool decode_decimal128_unscaled(const uint8_t* values, int32_t* out, size_t n) {
+  using Ops = RvvOps<int64_t, LMUL>;
+  const int64_t* words = reinterpret_cast<const int64_t*>(values);
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    auto v_lo = Ops::load_strided(words + 2 * i, kDecimalStride, vl);
+    auto v_hi = Ops::load_strided(words + 2 * i + 1, kDecimalStride, vl);
+    auto v_narrow = __riscv_vncvt_x(v_lo, vl);
+    // Fits iff the high half is the sign of the low half and the low half
+    // survives the round trip through int32.
+    auto v_wide = __riscv_vmor(
+        __riscv_vmsne(v_hi, __riscv_vsra(v_lo, 63, vl), vl),
+        __riscv_vmsne(v_lo, __riscv_vsext_vf2(v_narrow, vl), vl), vl);
+    if (__riscv_vcpop(v_wide, vl) != 0) {
+      return false;
+    }
+    __riscv_vse32(out + i, v_narrow, vl);
+  }
+  return true;
+}
+
+template <typename T, int LMUL>
+void decode_decimal128(const uint8_t* values, int32_t scale, T* out, size_t n) {
+  using Ops = RvvOps<int64_t, LMUL>;
+  const int64_t* words = reinterpret_cast<const int64_t*>(values);
+  const double divisor = kPowersOfTen[scale];
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    auto v_lo = Ops::load_strided(words + 2 * i, kDecimalStride, vl);
+    auto v_hi = Ops::load_strided(words + 2 * i + 1, kDecimalStride, vl);
+    auto v_wide = __riscv_vmsne(v_hi, __riscv_vsra(v_lo, 63, vl), vl);
+
+    // Divide rather than multiply by 10^-scale so every value |x| < 2^53 is
+    // rounded exactly like Decimal128::ToDouble.
+    auto v_real = __riscv_vfdiv(__riscv_vfcvt_f(v_lo, vl), divisor, vl);
+    if constexpr (std::is_same_v<T, float>) {
+      __riscv_vse32(out + i, __riscv_vfncvt_f(v_real, vl), vl);
+    } else {
+      __riscv_vse64(out + i, v_real, vl);
+    }
+
+    if (__riscv_vcpop(v_wide, vl) != 0) {
+      for (size_t j = i; j < i + vl; j++) {
+        const int64_t* w = words + 2 * j;
+        if (w[1] != (w[0] >> 63)) {
+          out[j] = static_cast<T>(wide_decimal_to_double(w, divisor));
+        }
+      }
+    }
+  }
+}
+
+template <int LMUL>
+void and_decimal128_range(const uint8_t* values, int64_t lo, int64_t hi,
+                          uint8_t* out, size_t out_offset, size_t n) {
+  using Ops = RvvOps<int64_t, LMUL>;
+  const int64_t* words = reinterpret_cast<const int64_t*>(values);
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    auto v_selected = detail::load_mask_bits<Ops>(out, out_offset + i, vl);
+    if (__riscv_vcpop(v_selected, vl) == 0) {
+      continue;
+    }
+    // Masked loads: rows already filtered out are not fetched
+    auto v_lo = __riscv_vlse64(v_selected, words + 2 * i, kDecimalStride, vl);
+    auto v_hi =
+        __riscv_vlse64(v_selected, words + 2 * i + 1, kDecimalStride, vl);
+    auto v_keep = __riscv_vmand(__riscv_vmsge(v_lo, lo, vl),
+                                __riscv_vmsle(v_lo, hi, vl), vl);
+    v_keep = __riscv_vmand(
+        v_keep, __riscv_vmseq(v_hi, __riscv_vsra(v_lo, 63, vl), vl), vl);
+    detail::store_mask_bits<Ops>(out, out_offset + i,
+                                 __riscv_vmand(v_selected, v_keep, vl), vl);
+  }
+}
+
+// The gathers index the low and the high halves by byte offset 16 * row.
+template <int LMUL>
+bool gather_decimal128_unscaled(const uint8_t* values, const int32_t* rows,
+                                size_t n, int32_t* out) {
+  using Narrow = RvvOps<int32_t, LMUL>;
+  const int64_t* lo_words = reinterpret_cast<const int64_t*>(values);
+  const int64_t* hi_words = lo_words + 1;
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Narrow::setvl(n - i);
+    auto v_offsets =
+        __riscv_vsll(Narrow::as_unsigned(Narrow::load(rows + i, vl)), 4, vl);
+    auto v_lo = __riscv_vluxei32(lo_words, v_offsets, vl);
+    auto v_hi = __riscv_vluxei32(hi_words, v_offsets, vl);
+    auto v_narrow = __riscv_vncvt_x(v_lo, vl);
+    auto v_wide = __riscv_vmor(
+        __riscv_vmsne(v_hi, __riscv_vsra(v_lo, 63, vl), vl),
+        __riscv_vmsne(v_lo, __riscv_vsext_vf2(v_narrow, vl), vl), vl);
+    if (__riscv_vcpop(v_wide, vl) != 0) {
+      return false;
+    }
+    Narrow::store(out + i, v_narrow, vl);
+  }
+  return true;
+}
+
+template <typename T, int LMUL>
+void gather_decimal128(const uint8_t* values, int32_t scale,
+                       const int32_t* rows, size_t n, T* out) {
+  using Narrow = RvvOps<int32_t, LMUL>;
+  const int64_t* lo_words = reinterpret_cast<const int64_t*>(values);
+  const int64_t* hi_words = lo_words + 1;
+  const double divisor = kPowersOfTen[scale];
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Narrow::setvl(n - i);
+    auto v_offsets =
+        __riscv_vsll(Narrow::as_unsigned(Narrow::load(rows + i, vl)), 4, vl);
+    auto v_lo = __riscv_vluxei32(lo_words, v_offsets, vl);
+    auto v_hi = __riscv_vluxei32(hi_words, v_offsets, vl);
+    auto v_wide = __riscv_vmsne(v_hi, __riscv_vsra(v_lo, 63, vl), vl);
+
+    auto v_real = __riscv_vfdiv(__riscv_vfcvt_f(v_lo, vl), divisor, vl);
+    if constexpr (std::is_same_v<T, float>) {
+      __riscv_vse32(out + i, __riscv_vfncvt_f(v_real, vl), vl);
+    } else {
+      __riscv_vse64(out + i, v_real, vl);
+    }
+
+    if (__riscv_vcpop(v_wide, vl) != 0) {
+      for (size_t j = i; j < i + vl; j++) {
+        const int64_t* w = lo_words + 2 * static_cast<size_t>(rows[j]);
+        if (w[1] != (w[0] >> 63)) {
+          out[j] = static_cast<T>(wide_decimal_to_double(w, divisor));
+        }
+      }
+    }
+  }
+}
+
+#define RVV_INSTANTIATE_DECIMAL(LMUL)                                         \
+  template bool decode_decimal128_unscaled<LMUL>(const uint8_t*, int64_t*,    \
+                                                 size_t);                     \
+  template bool decode_decimal128_unscaled<LMUL>(const uint8_t*, int32_t*,    \
+                                                 size_t);                     \
+  template void decode_decimal128<float, LMUL>(const uint8_t*, int32_t,       \
+                                               float*, size_t);               \
+  template void decode_decimal128<double, LMUL>(const uint8_t*, int32_t,      \
+                                                double*, size_t);             \
+  template void and_decimal128_range<LMUL>(const uint8_t*, int64_t, int64_t,  \
+                                           uint8_t*, size_t, size_t);
+
+#define RVV_INSTANTIATE_DECIMAL_GATHER(LMUL)                                  \
+  template bool gather_decimal128_unscaled<LMUL>(                             \
+      const uint8_t*, const int32_t*, size_t, int32_t*);                      \
+  template void gather_decimal128<float, LMUL>(const uint8_t*, int32_t,       \
+                                               const int32_t*, size_t,        \
+                                               float*);                       \
+  template void gather_decimal128<double, LMUL>(const uint8_t*, int32_t,      \
+                                                const int32_t*, size_t,       \
+                                                double*);
+
+RVV_INSTANTIATE_DECIMAL(1)
+RVV_INSTANTIATE_DECIMAL(2)
+RVV_INSTANTIATE_DECIMAL(4)
+RVV_INSTANTIATE_DECIMAL(8)
+RVV_INSTANTIATE_DECIMAL_GATHER(1)
+RVV_INSTANTIATE_DECIMAL_GATHER(2)
+RVV_INSTANTIATE_DECIMAL_GATHER(4)
+
+}  // namespace rvv
@@ -0,0 +1,133 @@
+#include "rvv_dispatch.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace rvv {
+
+namespace {
+
+const char* const kClassNames[kNumKernelClasses] = {
+    "decode", "compare", "arith", "reduce", "fused"};
+
+// Build defaults for VLEN=128; q1_aggregate_* defaults to LMUL=1.
+constexpr int kBuildLmul[kNumKernelClasses] = {
+    kDefaultLmul, kDefaultLmul, kDefaultLmul, kDefaultLmul, 1};
+
+bool valid_lmul(int lmul) {
+  return lmul == 1 || lmul == 2 || lmul == 4 || lmul == 8;
+}
+
+// Reads a calibration file; fills lmul only if it was measured at this
+// vlenb and names a valid LMUL for every class.
+bool read_calibration(const std::string& path,
+                      int (&lmul)[kNumKernelClasses]) {
+  std::ifstream in(path);
+  if (!in) {
+    return false;
+  }
+  int found[kNumKernelClasses] = {};
+  bool vlenb_matches = false;
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream fields(line);
+    std::string key;
+    long value;
+    if (!(fields >> key >> value) || key[0] == '#') {
+      continue;
+    }
+    if (key == "vlenb") {
+      vlenb_matches = static_cast<size_t>(value) == vlenb();
+      continue;
+    }
+    for (int c = 0; c < kNumKernelClasses; c++) {
+      if (key == kClassNames[c] && valid_lmul(static_cast<int>(value))) {
+        found[c] = static_cast<int>(value);
+      }
+    }
+  }
+  if (!vlenb_matches) {
+    return false;
+  }
+  for (int c = 0; c < kNumKernelClasses; c++) {
+    if (found[c] == 0) {
+      return false;
+    }
+  }
+  std::memcpy(lmul, found, sizeof(found));
+  return true;
+}
+
+struct Selection {
+  int lmul[kNumKernelClasses];
+
+  Selection() {
+    if (const char* forced = std::getenv("RVV_LMUL")) {
+      int value = std::atoi(forced);
+      if (valid_lmul(value)) {
+        for (int& l : lmul) {
+          l = value;
+        }
+        return;
+      }
+    }
+    if (read_calibration(calibration_path(), lmul)) {
+      return;
+    }
+    // Keep the elements per register group of VLEN=128
+    size_t ratio = vlenb() > 16 ? vlenb() / 16 : 1;
+    for (int c = 0; c < kNumKernelClasses; c++) {
+      size_t scaled = static_cast<size_t>(kBuildLmul[c]) / ratio;
+      lmul[c] = scaled > 0 ? static_cast<int>(scaled) : 1;
+    }
+  }
+};
+
+}  // namespace
+
+const char* kernel_class_name(KernelClass kernel_class) {
+  return kClassNames[static_cast<int>(kernel_class)];
+}
+
+size_t vlenb() {
+  static const size_t bytes = vector_group_bytes() / kDefaultLmul;
+  return bytes;
+}
+
+int selected_lmul(KernelClass kernel_class) {
+  static const Selection selection;
+  return selection.lmul[static_cast<int>(kernel_class)];
+}
+
+std::string calibration_path() {
+  if (const char* path = std::getenv("RVV_CALIBRATION")) {
+    return path;
+  }
+  const char* home = std::getenv("HOME");
+  return std::string(home ? home : ".") + "/.cache/rvv_calibration";
+}
+
+bool write_calibration(const std::string& path,
+                       const int (&lmul)[kNumKernelClasses],
+                       std::string* error) {
+  std::ofstream out(path);
+  if (!out) {
+    *error = "cannot write " + path;
+    return false;
+  }
+  out << "# rvv_microbench calibration\n";
+  out << "vlenb " << vlenb() << '\n';
+  for (int c = 0; c < kNumKernelClasses; c++) {
+    out << kClassNames[c] << ' ' << lmul[c] << '\n';
+  }
+  out.close();
+  if (!out) {
+    *error = "cannot write " + path;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace rvv
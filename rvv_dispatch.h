@@ -0,0 +1,91 @@
+// Runtime LMUL selection for the RVV kernels.
+//
+// Every kernel is instantiated for several LMULs (see rvv_kernels.h); which
+// one pays off depends on the board: VLEN differs between our boards, and
+// wide register groups make fused kernels spill. The kernels fall into a
+// few classes, and each class gets one LMUL, chosen once per process:
+//
+//   1. RVV_LMUL=<1|2|4|8> in the environment forces it for every class.
+//   2. Otherwise the calibration file written by rvv_microbench
+//      --calibrate is used, if it was measured at this vlenb. Its path is
+//      $RVV_CALIBRATION, by default ~/.cache/rvv_calibration.
+//   3. Otherwise the build defaults apply, scaled to vlenb: a VLEN beyond
+//      128 bits lowers LMUL so that a register group holds as many elements
+//      as the RVV_LMUL build option gives at VLEN=128.
+//
+// Call sites go through with_lmul, which hands the chosen LMUL to a generic
+// lambda as a compile-time constant:
+//
+//   rvv::with_lmul(rvv::KernelClass::kDecode, [&](auto lmul) {
+//     rvv::decode_decimal128<float, decltype(lmul)::value>(values, 2, out, n);
+//   });
+//
+// Kernels instantiated only up to LMUL=4 pass that cap as the first template
+// argument: with_lmul<4>(...).
+#pragma once
+
+#include "rvv_kernels.h"
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace rvv {
+
+enum class KernelClass {
+  kDecode,   // Decimal128 decode and gather
+  kCompare,  // predicates into bitmaps
+  kArith,    // element-wise arithmetic
+  kReduce,   // sums and dot products, float and exact
+  kFused,    // the one-pass Q1 kernel, the most register-hungry
+};
+
+constexpr int kNumKernelClasses = 5;
+
+const char* kernel_class_name(KernelClass kernel_class);
+
+// VLEN / 8 of the running hart (the native vector width of the portable
+// backend).
+size_t vlenb();
+
+// The LMUL chosen for kernel_class, see above.
+int selected_lmul(KernelClass kernel_class);
+
+// Where the calibration is read from and written to.
+std::string calibration_path();
+
+// Stores one LMUL per class (indexed by KernelClass) for the current vlenb.
+// Returns false and sets error if the file cannot be written.
+bool write_calibration(const std::string& path,
+                       const int (&lmul)[kNumKernelClasses],
+                       std::string* error);
+
+// f(std::integral_constant<int, lmul>) with lmul capped at MaxLmul, so no
+// instantiation beyond the cap is referenced.
+template <int MaxLmul = 8, typename F>
+decltype(auto) dispatch_lmul(int lmul, F&& f) {
+  static_assert(MaxLmul == 1 || MaxLmul == 2 || MaxLmul == 4 || MaxLmul == 8,
+                "LMUL caps are powers of two up to 8");
+  constexpr int k2 = MaxLmul < 2 ? MaxLmul : 2;
+  constexpr int k4 = MaxLmul < 4 ? MaxLmul : 4;
+  switch (lmul) {
+    case 1:
+      return f(std::integral_constant<int, 1>());
+    case 2:
+      return f(std::integral_constant<int, k2>());
+    case 4:
+      return f(std::integral_constant<int, k4>());
+    default:
+      return f(std::integral_constant<int, MaxLmul>());
+  }
+}
+
+// dispatch_lmul with the LMUL selected for kernel_class.
+template <int MaxLmul = 8, typename F>
+decltype(auto) with_lmul(KernelClass kernel_class, F&& f) {
+  return dispatch_lmul<MaxLmul>(selected_lmul(kernel_class),
+                                std::forward<F>(f));
+}
+
+}  // namespace rvv
@@ -0,0 +1,171 @@
+#include "rvv_kernels.h"
+
+#include "rvv_ops.h"
+
+#include <vector>
+
+namespace rvv {
+
+using detail::RvvOps;
+
+namespace {
+
+// int64 lanes holding the low words of per-lane 128-bit sums, plus the
+// matching high words. Every update is tail-undisturbed so a short final
+// strip leaves the remaining lanes intact.
+template <int WIDE_LMUL>
+struct Int128Lanes {
+  using Ops = RvvOps<int64_t, WIDE_LMUL>;
+  typename Ops::vec_t lo;
+  typename Ops::vec_t hi;
+  size_t vlmax;
+
+  Int128Lanes()
+      : lo(Ops::splat(0, Ops::setvlmax())),
+        hi(Ops::splat(0, Ops::setvlmax())),
+        vlmax(Ops::setvlmax()) {}
+
+  // Adds the signed 64-bit values p lane by lane.
+  void add(typename Ops::vec_t p, size_t vl) {
+    lo = __riscv_vadd_tu(lo, lo, p, vl);
+    auto carry = __riscv_vmsltu(Ops::as_unsigned(lo), Ops::as_unsigned(p), vl);
+    hi = __riscv_vadd_tu(hi, hi, __riscv_vsra(p, 63, vl), vl);
+    hi = __riscv_vadd_tumu(carry, hi, hi, int64_t(1), vl);
+  }
+
+  // Adds the signed 128-bit values (p_hi:p_lo) lane by lane.
+  void add(typename Ops::vec_t p_lo, typename Ops::vec_t p_hi, size_t vl) {
+    lo = __riscv_vadd_tu(lo, lo, p_lo, vl);
+    auto carry =
+        __riscv_vmsltu(Ops::as_unsigned(lo), Ops::as_unsigned(p_lo), vl);
+    hi = __riscv_vadd_tu(hi, hi, p_hi, vl);
+    hi = __riscv_vadd_tumu(carry, hi, hi, int64_t(1), vl);
+  }
+
+  Int128 total() const {
+    std::vector<int64_t> lo_lanes(vlmax), hi_lanes(vlmax);
+    Ops::store(lo_lanes.data(), lo, vlmax);
+    Ops::store(hi_lanes.data(), hi, vlmax);
+    Int128 result = 0;
+    for (size_t k = 0; k < vlmax; k++) {
+      result += static_cast<Int128>(hi_lanes[k]) * (static_cast<Int128>(1) << 64) +
+                static_cast<Int128>(static_cast<uint64_t>(lo_lanes[k]));
+    }
+    return result;
+  }
+};
+
+// Sums an int64 accumulator register in 128-bit arithmetic.
+template <typename Ops>
+Int128 total_lanes(typename Ops::vec_t acc) {
+  size_t vlmax = Ops::setvlmax();
+  std::vector<int64_t> lanes(vlmax);
+  Ops::store(lanes.data(), acc, vlmax);
+  Int128 result = 0;
+  for (int64_t lane : lanes) {
+    result += lane;
+  }
+  return result;
+}
+
+}  // namespace
+
+// A single int64 lane only overflows after 2^32 int32 inputs, far more than
+// any batch, so plain sums can stay in 64-bit lanes.
+template <int LMUL>
+Int128 sum_exact(const int32_t* data, size_t n) {
+  using Narrow = RvvOps<int32_t, LMUL>;
+  using Wide = RvvOps<int64_t, 2 * LMUL>;
+  auto v_sum = Wide::splat(0, Wide::setvlmax());
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Narrow::setvl(n - i);
+    auto v_data = Narrow::load(data + i, vl);
+    v_sum = __riscv_vwadd_wv_tu(v_sum, v_sum, v_data, vl);
+  }
+  return total_lanes<Wide>(v_sum);
+}
+
+template <int LMUL>
+Int128 sum_exact_masked(const int32_t* data, const uint8_t* bitmap, size_t n) {
+  using Narrow = RvvOps<int32_t, LMUL>;
+  using Wide = RvvOps<int64_t, 2 * LMUL>;
+  auto v_sum = Wide::splat(0, Wide::setvlmax());
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Narrow::setvl(n - i);
+    auto v_mask = detail::load_mask_bits<Narrow>(bitmap, i, vl);
+    auto v_data = Narrow::load(data + i, vl);
+    v_sum = __riscv_vwadd_wv_tumu(v_mask, v_sum, v_sum, v_data, vl);
+  }
+  return total_lanes<Wide>(v_sum);
+}
+
+template <int LMUL>
+Int128 dot_exact(const int32_t* a, const int32_t* b, size_t n) {
+  using Narrow = RvvOps<int32_t, LMUL>;
+  Int128Lanes<2 * LMUL> acc;
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Narrow::setvl(n - i);
+    auto v_a = Narrow::load(a + i, vl);
+    auto v_b = Narrow::load(b + i, vl);
+    acc.add(__riscv_vwmul(v_a, v_b, vl), vl);
+  }
+  return acc.total();
+}
+
+template <int LMUL>
+Int128 sum_mul_one_minus_exact(const int32_t* a, const int32_t* b, int32_t one,
+                               size_t n) {
+  using Narrow = RvvOps<int32_t, LMUL>;
+  Int128Lanes<2 * LMUL> acc;
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Narrow::setvl(n - i);
+    auto v_a = Narrow::load(a + i, vl);
+    auto v_one_minus_b = __riscv_vrsub(Narrow::load(b + i, vl), one, vl);
+    acc.add(__riscv_vwmul(v_a, v_one_minus_b, vl), vl);
+  }
+  return acc.total();
+}
+
+template <int LMUL>
+Int128 sum_mul_one_minus_one_plus_exact(const int32_t* a, const int32_t* b,
+                                        int32_t one_b, const int32_t* c,
+                                        int32_t one_c, size_t n) {
+  using Narrow = RvvOps<int32_t, LMUL>;
+  Int128Lanes<2 * LMUL> acc;
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Narrow::setvl(n - i);
+    auto v_a = Narrow::load(a + i, vl);
+    auto v_one_minus_b = __riscv_vrsub(Narrow::load(b + i, vl), one_b, vl);
+    auto v_one_plus_c = __riscv_vadd(Narrow::load(c + i, vl), one_c, vl);
+    // a * (one_b - b) is exact in int64; the second factor needs the full
+    // 128-bit product, taken as vmul (low) + vmulh (high).
+    auto v_disc = __riscv_vwmul(v_a, v_one_minus_b, vl);
+    auto v_factor = __riscv_vsext_vf2(v_one_plus_c, vl);
+    acc.add(__riscv_vmul(v_disc, v_factor, vl),
+            __riscv_vmulh(v_disc, v_factor, vl), vl);
+  }
+  return acc.total();
+}
+
+#define RVV_INSTANTIATE_EXACT(LMUL)                                           \
+  template Int128 sum_exact<LMUL>(const int32_t*, size_t);                    \
+  template Int128 sum_exact_masked<LMUL>(const int32_t*, const uint8_t*,      \
+                                         size_t);                             \
+  template Int128 dot_exact<LMUL>(const int32_t*, const int32_t*, size_t);    \
+  template Int128 sum_mul_one_minus_exact<LMUL>(const int32_t*,               \
+                                                const int32_t*, int32_t,      \
+                                                size_t);                      \
+  template Int128 sum_mul_one_minus_one_plus_exact<LMUL>(                     \
+      const int32_t*, const int32_t*, int32_t, const int32_t*, int32_t,       \
+      size_t);
+
+RVV_INSTANTIATE_EXACT(1)
+RVV_INSTANTIATE_EXACT(2)
+RVV_INSTANTIATE_EXACT(4)
+
+}  // namespace rvv
@@ -0,0 +1,220 @@
+#include "rvv_kernels.h"
+
+#include "rvv_ops.h"
+
+namespace rvv {
+
+using detail::RvvOps;
+
+namespace {
+
+// Byte distance between consecutive low (or high) halves.
+constexpr ptrdiff_t kDecimalStride = 16;
+
+constexpr Int128 kTwoTo32 = static_cast<Int128>(1) << 32;
+constexpr Int128 kTwoTo64 = static_cast<Int128>(1) << 64;
+
+// Low and high words of vl Decimal128 values starting at row i.
+template <typename Wide>
+struct DecimalWords {
+  typename Wide::vec_t lo;
+  typename Wide::vec_t hi;
+};
+
+template <typename Wide>
+DecimalWords<Wide> load_decimal(const uint8_t* values, size_t i, size_t vl) {
+  const int64_t* words = reinterpret_cast<const int64_t*>(values) + 2 * i;
+  return {Wide::load_strided(words, kDecimalStride, vl),
+          Wide::load_strided(words + 1, kDecimalStride, vl)};
+}
+
+// Lanes whose value needs more than 64 bits.
+template <typename Wide>
+typename Wide::mask_t outside_int64(const DecimalWords<Wide>& d, size_t vl) {
+  return __riscv_vmsne(d.hi, __riscv_vsra(d.lo, 63, vl), vl);
+}
+
+// Lanes whose value does not fit in int32: the high word must be 0 or -1
+// and equal to the low word shifted right by 31.
+template <typename Wide>
+typename Wide::mask_t outside_int32(const DecimalWords<Wide>& d, size_t vl) {
+  auto v_bad = __riscv_vmsne(__riscv_vsra(d.lo, 31, vl), d.hi, vl);
+  return __riscv_vmor(v_bad, __riscv_vmsne(__riscv_vsra(d.hi, 1, vl), d.hi, vl),
+                      vl);
+}
+
+// Rows of the strip at i that pass the shipdate predicate and the selection.
+template <typename Narrow>
+typename Narrow::mask_t qualifying(const Q1Input& in, size_t i, size_t vl) {
+  auto v_mask = __riscv_vmsle(Narrow::load(in.shipdate + i, vl), in.cutoff, vl);
+  if (in.selection) {
+    v_mask = __riscv_vmand(
+        v_mask, detail::load_mask_bits<Narrow>(in.selection, i, vl), vl);
+  }
+  return v_mask;
+}
+
+template <typename Wide>
+int64_t masked_sum(typename Wide::mask_t m, typename Wide::vec_t v,
+                   size_t vl) {
+  return Wide::first(__riscv_vredsum(m, v, Wide::splat_m1(0), vl));
+}
+
+template <typename Wide>
+double masked_fsum(typename Wide::mask_t m, typename Wide::vec_t v,
+                   size_t vl) {
+  return Wide::first(__riscv_vfredusum(m, v, Wide::splat_m1(0.0), vl));
+}
+
+int64_t pow10_int64(int32_t scale) {
+  int64_t result = 1;
+  for (int32_t k = 0; k < scale; k++) {
+    result *= 10;
+  }
+  return result;
+}
+
+constexpr double kPowersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,
+    1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+    1e20, 1e21, 1e22, 1e23, 1e24, 1e25, 1e26, 1e27, 1e28, 1e29,
+    1e30, 1e31, 1e32, 1e33, 1e34, 1e35, 1e36, 1e37, 1e38};
+
+}  // namespace
+
+// Each reduction adds at most vl int64 values, so the products are split
+// into 32-bit limbs first and recombined in 128-bit arithmetic: with int32
+// inputs disc_price stays below 2^62 and charge below 2^93.
+template <int LMUL>
+bool q1_aggregate_exact(const Q1Input& in, size_t n, Q1Sums* groups,
+                        size_t num_groups) {
+  using Narrow = RvvOps<int32_t, LMUL>;
+  using Wide = RvvOps<int64_t, 2 * LMUL>;
+  const int64_t disc_one = pow10_int64(in.discount_scale);
+  const int64_t tax_one = pow10_int64(in.tax_scale);
+  const int64_t low_limb = 0xFFFFFFFF;
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Narrow::setvl(n - i);
+    auto v_mask = qualifying<Narrow>(in, i, vl);
+    if (__riscv_vcpop(v_mask, vl) == 0) {
+      continue;
+    }
+    auto qty = load_decimal<Wide>(in.quantity, i, vl);
+    auto price = load_decimal<Wide>(in.price, i, vl);
+    auto disc = load_decimal<Wide>(in.discount, i, vl);
+    auto tax = load_decimal<Wide>(in.tax, i, vl);
+    auto v_bad = __riscv_vmor(
+        __riscv_vmor(outside_int32(qty, vl), outside_int32(price, vl), vl),
+        __riscv_vmor(outside_int32(disc, vl), outside_int32(tax, vl), vl), vl);
+    if (__riscv_vcpop(__riscv_vmand(v_bad, v_mask, vl), vl) != 0) {
+      return false;
+    }
+
+    auto v_disc_price =
+        __riscv_vmul(price.lo, __riscv_vrsub(disc.lo, disc_one, vl), vl);
+    auto v_one_plus_tax = __riscv_vadd(tax.lo, tax_one, vl);
+    auto v_charge_lo = __riscv_vmul(v_disc_price, v_one_plus_tax, vl);
+    auto v_charge_hi = __riscv_vmulh(v_disc_price, v_one_plus_tax, vl);
+
+    auto v_dp_low = __riscv_vand(v_disc_price, low_limb, vl);
+    auto v_dp_high = __riscv_vsra(v_disc_price, 32, vl);
+    auto v_ch_low = __riscv_vand(v_charge_lo, low_limb, vl);
+    auto v_ch_mid = __riscv_vand(__riscv_vsra(v_charge_lo, 32, vl), low_limb, vl);
+
+    auto v_group = Narrow::load(in.group_ids + i, vl);
+    for (size_t g = 0; g < num_groups; g++) {
+      auto m = __riscv_vmand(
+          v_mask, __riscv_vmseq(v_group, static_cast<int32_t>(g), vl), vl);
+      size_t count = __riscv_vcpop(m, vl);
+      if (count == 0) {
+        continue;
+      }
+      Q1Sums& sums = groups[g];
+      sums.count += count;
+      sums.qty += masked_sum<Wide>(m, qty.lo, vl);
+      sums.price += masked_sum<Wide>(m, price.lo, vl);
+      sums.disc += masked_sum<Wide>(m, disc.lo, vl);
+      sums.disc_price +=
+          static_cast<Int128>(masked_sum<Wide>(m, v_dp_high, vl)) * kTwoTo32 +
+          masked_sum<Wide>(m, v_dp_low, vl);
+      sums.charge +=
+          static_cast<Int128>(masked_sum<Wide>(m, v_charge_hi, vl)) * kTwoTo64 +
+          static_cast<Int128>(masked_sum<Wide>(m, v_ch_mid, vl)) * kTwoTo32 +
+          masked_sum<Wide>(m, v_ch_low, vl);
+    }
+  }
+  return true;
+}
+
+template <int LMUL>
+bool q1_aggregate_float(const Q1Input& in, size_t n, Q1SumsFloat* groups,
+                        size_t num_groups) {
+  using Narrow = RvvOps<int32_t, LMUL>;
+  using Wide = RvvOps<int64_t, 2 * LMUL>;
+  using Real = RvvOps<double, 2 * LMUL>;
+  const double qty_div = kPowersOfTen[in.quantity_scale];
+  const double price_div = kPowersOfTen[in.price_scale];
+  const double disc_div = kPowersOfTen[in.discount_scale];
+  const double tax_div = kPowersOfTen[in.tax_scale];
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Narrow::setvl(n - i);
+    auto v_mask = qualifying<Narrow>(in, i, vl);
+    if (__riscv_vcpop(v_mask, vl) == 0) {
+      continue;
+    }
+    auto qty = load_decimal<Wide>(in.quantity, i, vl);
+    auto price = load_decimal<Wide>(in.price, i, vl);
+    auto disc = load_decimal<Wide>(in.discount, i, vl);
+    auto tax = load_decimal<Wide>(in.tax, i, vl);
+    auto v_bad = __riscv_vmor(
+        __riscv_vmor(outside_int64(qty, vl), outside_int64(price, vl), vl),
+        __riscv_vmor(outside_int64(disc, vl), outside_int64(tax, vl), vl), vl);
+    if (__riscv_vcpop(__riscv_vmand(v_bad, v_mask, vl), vl) != 0) {
+      return false;
+    }
+
+    typename Real::vec_t v_qty =
+        __riscv_vfdiv(__riscv_vfcvt_f(qty.lo, vl), qty_div, vl);
+    typename Real::vec_t v_price =
+        __riscv_vfdiv(__riscv_vfcvt_f(price.lo, vl), price_div, vl);
+    typename Real::vec_t v_disc =
+        __riscv_vfdiv(__riscv_vfcvt_f(disc.lo, vl), disc_div, vl);
+    typename Real::vec_t v_tax =
+        __riscv_vfdiv(__riscv_vfcvt_f(tax.lo, vl), tax_div, vl);
+    // price - price * disc, then disc_price + disc_price * tax
+    auto v_disc_price = __riscv_vfnmsac(v_price, v_price, v_disc, vl);
+    auto v_charge = __riscv_vfmacc(v_disc_price, v_disc_price, v_tax, vl);
+
+    auto v_group = Narrow::load(in.group_ids + i, vl);
+    for (size_t g = 0; g < num_groups; g++) {
+      auto m = __riscv_vmand(
+          v_mask, __riscv_vmseq(v_group, static_cast<int32_t>(g), vl), vl);
+      size_t count = __riscv_vcpop(m, vl);
+      if (count == 0) {
+        continue;
+      }
+      Q1SumsFloat& sums = groups[g];
+      sums.count += count;
+      sums.qty += masked_fsum<Real>(m, v_qty, vl);
+      sums.price += masked_fsum<Real>(m, v_price, vl);
+      sums.disc += masked_fsum<Real>(m, v_disc, vl);
+      sums.disc_price += masked_fsum<Real>(m, v_disc_price, vl);
+      sums.charge += masked_fsum<Real>(m, v_charge, vl);
+    }
+  }
+  return true;
+}
+
+#define RVV_INSTANTIATE_FUSED(LMUL)                                           \
+  template bool q1_aggregate_exact<LMUL>(const Q1Input&, size_t, Q1Sums*,     \
+                                         size_t);                             \
+  template bool q1_aggregate_float<LMUL>(const Q1Input&, size_t,              \
+                                         Q1SumsFloat*, size_t);
+
+RVV_INSTANTIATE_FUSED(1)
+RVV_INSTANTIATE_FUSED(2)
+RVV_INSTANTIATE_FUSED(4)
+
+}  // namespace rvv
@@ -0,0 +1,212 @@
+#include "rvv_kernels.h"
+
+#include "rvv_ops.h"
+
+namespace rvv {
+
+using detail::RvvOps;
+
+namespace {
+
+// First byte of the vl strings whose offsets start at offsets (0 for empty
+// strings). Sets *too_long if one of them has more than one byte.
+template <int LMUL>
+typename detail::ByteGather<LMUL>::vec_t single_bytes(const int32_t* offsets,
+                                                      const uint8_t* data,
+                                                      size_t vl,
+                                                      bool* too_long) {
+  using Ops = RvvOps<int32_t, LMUL>;
+  auto v_begin = Ops::load(offsets, vl);
+  auto v_length = __riscv_vsub(Ops::load(offsets + 1, vl), v_begin, vl);
+  if (__riscv_vcpop(__riscv_vmsgt(v_length, 1, vl), vl) != 0) {
+    *too_long = true;
+  }
+  // Empty strings may point one past the end of data; never load for them
+  auto v_nonempty = __riscv_vmsne(v_length, 0, vl);
+  return detail::ByteGather<LMUL>::gather(v_nonempty, data,
+                                          Ops::as_unsigned(v_begin), vl);
+}
+
+}  // namespace
+
+template <int LMUL>
+bool char_pair_codes(const int32_t* a_offsets, const uint8_t* a_data,
+                     const int32_t* b_offsets, const uint8_t* b_data,
+                     int32_t* out, size_t n) {
+  using Ops = RvvOps<int32_t, LMUL>;
+  bool too_long = false;
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    auto v_a = single_bytes<LMUL>(a_offsets + i, a_data, vl, &too_long);
+    auto v_b = single_bytes<LMUL>(b_offsets + i, b_data, vl, &too_long);
+    auto v_code = __riscv_vor(__riscv_vsll(v_a, 8, vl), v_b, vl);
+    __riscv_vse32(reinterpret_cast<uint32_t*>(out + i), v_code, vl);
+  }
+  return !too_long;
+}
+
+template <int LMUL>
+size_t gather_int32(const int32_t* table, const int32_t* index, int32_t* out,
+                    size_t n) {
+  using Ops = RvvOps<int32_t, LMUL>;
+  size_t negative = 0;
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    auto v_offset =
+        __riscv_vsll(Ops::as_unsigned(Ops::load(index + i, vl)), 2, vl);
+    auto v_value = __riscv_vluxei32(table, v_offset, vl);
+    negative += __riscv_vcpop(__riscv_vmslt(v_value, 0, vl), vl);
+    Ops::store(out + i, v_value, vl);
+  }
+  return negative;
+}
+
+// Key offsets are taken in int64 lanes and narrowed to the uint32 byte
+// offsets of the int32 table, which is why size must stay below 2^30.
+template <int LMUL>
+size_t gather_dense_int32(const int32_t* table, int64_t base, size_t size,
+                          const int64_t* keys, int32_t* out, size_t n) {
+  using Narrow = RvvOps<int32_t, LMUL>;
+  using Wide = RvvOps<int64_t, 2 * LMUL>;
+  size_t misses = 0;
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Narrow::setvl(n - i);
+    // Keys below base wrap around to huge unsigned offsets
+    auto v_index =
+        Wide::as_unsigned(__riscv_vsub(Wide::load(keys + i, vl), base, vl));
+    auto v_in_range =
+        __riscv_vmsltu(v_index, static_cast<uint64_t>(size), vl);
+    auto v_offset = __riscv_vsll(__riscv_vncvt_x(v_index, vl), 2, vl);
+    auto v_value = __riscv_vluxei32_mu(v_in_range, Narrow::splat(-1, vl),
+                                       table, v_offset, vl);
+    misses += __riscv_vcpop(__riscv_vmslt(v_value, 0, vl), vl);
+    Narrow::store(out + i, v_value, vl);
+  }
+  return misses;
+}
+
+template <int LMUL>
+void linear_group_ids(const int32_t* a, int32_t scale, const int32_t* b,
+                      int32_t offset, int32_t* out, size_t n) {
+  using Ops = RvvOps<int32_t, LMUL>;
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    // a * scale + b in one op, then the offset
+    auto v_id = __riscv_vmadd(Ops::load(a + i, vl), scale, Ops::load(b + i, vl),
+                              vl);
+    Ops::store(out + i, __riscv_vadd(v_id, offset, vl), vl);
+  }
+}
+
+template <int LMUL>
+size_t group_sum_lanes() {
+  return RvvOps<int32_t, LMUL>::setvlmax();
+}
+
+template <int LMUL>
+void group_sum(const int32_t* group_ids, const float* values, size_t n,
+               double* lane_sums, int64_t* lane_counts) {
+  using Narrow = RvvOps<int32_t, LMUL>;
+  using Real = RvvOps<float, LMUL>;
+  const uint32_t lanes = static_cast<uint32_t>(Narrow::setvlmax());
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Narrow::setvl(n - i);
+    auto v_slot = __riscv_vmacc(Narrow::lane_index(vl), lanes,
+                                Narrow::as_unsigned(Narrow::load(group_ids + i, vl)),
+                                vl);
+    auto v_offset = __riscv_vsll(v_slot, 3, vl);
+    auto v_values = __riscv_vfwcvt_f(Real::load(values + i, vl), vl);
+    auto v_sums = __riscv_vluxei32(lane_sums, v_offset, vl);
+    __riscv_vsuxei32(lane_sums, v_offset, __riscv_vfadd(v_sums, v_values, vl),
+                     vl);
+    if (lane_counts) {
+      auto v_counts = __riscv_vluxei32(lane_counts, v_offset, vl);
+      __riscv_vsuxei32(lane_counts, v_offset, __riscv_vadd(v_counts, 1, vl),
+                       vl);
+    }
+  }
+}
+
+template <int LMUL>
+void probe_bitmap(const uint64_t* words, int64_t base, size_t size,
+                  const int64_t* keys, uint8_t* out, size_t out_offset,
+                  size_t n) {
+  using Ops = RvvOps<int64_t, LMUL>;
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    auto v_index =
+        Ops::as_unsigned(__riscv_vsub(Ops::load(keys + i, vl), base, vl));
+    auto v_in_range = __riscv_vmsltu(v_index, static_cast<uint64_t>(size), vl);
+    // Byte offset of the 64-bit word holding the bit, then the bit itself
+    auto v_offset = __riscv_vsll(__riscv_vsrl(v_index, 6, vl), 3, vl);
+    auto v_word = __riscv_vluxei64_mu(
+        v_in_range, Ops::as_unsigned(Ops::splat(0, vl)), words, v_offset, vl);
+    auto v_bit = __riscv_vand(
+        __riscv_vsrl(v_word, __riscv_vand(v_index, 63, vl), vl), 1, vl);
+    auto v_hit = __riscv_vmand(v_in_range, __riscv_vmsne(v_bit, 0, vl), vl);
+    detail::store_mask_bits<Ops>(out, out_offset + i, v_hit, vl);
+  }
+}
+
+template <int LMUL>
+void probe_bloom(const uint64_t* blocks, int log_blocks, const int64_t* keys,
+                 uint8_t* out, size_t out_offset, size_t n) {
+  using Ops = RvvOps<int64_t, LMUL>;
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    // Same arithmetic as bloom_hash / bloom_block / bloom_pattern
+    auto v_hash = __riscv_vmul(Ops::as_unsigned(Ops::load(keys + i, vl)),
+                               kBloomMultiplier, vl);
+    auto v_offset =
+        __riscv_vsll(__riscv_vsrl(v_hash, 64 - log_blocks, vl), 3, vl);
+    auto v_block = __riscv_vluxei64(blocks, v_offset, vl);
+    auto v_one = Ops::as_unsigned(Ops::splat(1, vl));
+    auto v_pattern = Ops::as_unsigned(Ops::splat(0, vl));
+    for (unsigned shift : kBloomBitShifts) {
+      auto v_bit = __riscv_vand(__riscv_vsrl(v_hash, shift, vl), 63, vl);
+      v_pattern = __riscv_vor(v_pattern, __riscv_vsll(v_one, v_bit, vl), vl);
+    }
+    auto v_hit =
+        __riscv_vmseq(__riscv_vand(v_block, v_pattern, vl), v_pattern, vl);
+    detail::store_mask_bits<Ops>(out, out_offset + i, v_hit, vl);
+  }
+}
+
+#define RVV_INSTANTIATE_DENSE(LMUL)                                           \
+  template size_t gather_dense_int32<LMUL>(const int32_t*, int64_t, size_t,   \
+                                           const int64_t*, int32_t*, size_t); \
+  template size_t group_sum_lanes<LMUL>();                                    \
+  template void group_sum<LMUL>(const int32_t*, const float*, size_t,         \
+                                double*, int64_t*);
+
+RVV_INSTANTIATE_DENSE(1)
+RVV_INSTANTIATE_DENSE(2)
+RVV_INSTANTIATE_DENSE(4)
+
+#define RVV_INSTANTIATE_GATHER(LMUL)                                          \
+  template bool char_pair_codes<LMUL>(const int32_t*, const uint8_t*,         \
+                                      const int32_t*, const uint8_t*,         \
+                                      int32_t*, size_t);                      \
+  template size_t gather_int32<LMUL>(const int32_t*, const int32_t*,          \
+                                     int32_t*, size_t);                       \
+  template void linear_group_ids<LMUL>(const int32_t*, int32_t,               \
+                                       const int32_t*, int32_t, int32_t*,     \
+                                       size_t);                               \
+  template void probe_bitmap<LMUL>(const uint64_t*, int64_t, size_t,          \
+                                   const int64_t*, uint8_t*, size_t, size_t); \
+  template void probe_bloom<LMUL>(const uint64_t*, int, const int64_t*,       \
+                                  uint8_t*, size_t, size_t);
+
+RVV_INSTANTIATE_GATHER(1)
+RVV_INSTANTIATE_GATHER(2)
+RVV_INSTANTIATE_GATHER(4)
+RVV_INSTANTIATE_GATHER(8)
+
+}  // namespace rvv
@@ -0,0 +1,335 @@
+#include "rvv_kernels.h"
+
+#include "rvv_ops.h"
+
+#include <algorithm>
+#include <type_traits>
+
+namespace rvv {
+
+using detail::RvvOps;
+
+template <typename T, int LMUL>
+void mul_one_minus(const T* a, const T* b, T* out, size_t n) {
+  using Ops = RvvOps<T, LMUL>;
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    auto v_a = Ops::load(a + i, vl);
+    auto v_b = Ops::load(b + i, vl);
+    // a - a * b in one fused op
+    Ops::store(out + i, __riscv_vfnmsac(v_a, v_a, v_b, vl), vl);
+  }
+}
+
+template <typename T, int LMUL>
+void mul_one_plus(const T* a, const T* b, T* out, size_t n) {
+  using Ops = RvvOps<T, LMUL>;
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    auto v_a = Ops::load(a + i, vl);
+    auto v_b = Ops::load(b + i, vl);
+    // a + a * b in one fused op
+    Ops::store(out + i, __riscv_vfmacc(v_a, v_a, v_b, vl), vl);
+  }
+}
+
+template <typename T, int LMUL>
+void mul(const T* a, const T* b, T* out, size_t n) {
+  using Ops = RvvOps<T, LMUL>;
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    auto v_a = Ops::load(a + i, vl);
+    auto v_b = Ops::load(b + i, vl);
+    Ops::store(out + i, __riscv_vfmul(v_a, v_b, vl), vl);
+  }
+}
+
+template <typename T, int LMUL>
+void sub(const T* a, const T* b, T* out, size_t n) {
+  using Ops = RvvOps<T, LMUL>;
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    auto v_a = Ops::load(a + i, vl);
+    auto v_b = Ops::load(b + i, vl);
+    Ops::store(out + i, __riscv_vfsub(v_a, v_b, vl), vl);
+  }
+}
+
+template <typename T, int LMUL>
+void mul_one_minus_sub_mul(const T* a, const T* b, const T* c, const T* d,
+                           T* out, size_t n) {
+  using Ops = RvvOps<T, LMUL>;
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    auto v_a = Ops::load(a + i, vl);
+    // a - a * b, then minus c * d, both fused
+    auto v_out = __riscv_vfnmsac(v_a, v_a, Ops::load(b + i, vl), vl);
+    v_out = __riscv_vfnmsac(v_out, Ops::load(c + i, vl), Ops::load(d + i, vl),
+                            vl);
+    Ops::store(out + i, v_out, vl);
+  }
+}
+
+// The accumulators below use the tail-undisturbed (_tu) forms so that a short
+// final strip cannot clobber lanes that the vlmax-wide reduction still reads.
+template <typename T, int LMUL>
+T sum(const T* data, size_t n) {
+  using Ops = RvvOps<T, LMUL>;
+  size_t vlmax = Ops::setvlmax();
+  auto v_sum = Ops::splat(T(0), vlmax);
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    auto v_data = Ops::load(data + i, vl);
+    v_sum = __riscv_vfadd_tu(v_sum, v_sum, v_data, vl);
+  }
+  return Ops::first(__riscv_vfredusum(v_sum, Ops::splat_m1(T(0)), vlmax));
+}
+
+template <typename T, int LMUL>
+T sum_masked(const T* data, const uint8_t* bitmap, size_t n) {
+  using Ops = RvvOps<T, LMUL>;
+  size_t vlmax = Ops::setvlmax();
+  auto v_sum = Ops::splat(T(0), vlmax);
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    auto v_mask = detail::load_mask_bits<Ops>(bitmap, i, vl);
+    auto v_data = Ops::load(data + i, vl);
+    v_sum = __riscv_vfadd_tumu(v_mask, v_sum, v_sum, v_data, vl);
+  }
+  return Ops::first(__riscv_vfredusum(v_sum, Ops::splat_m1(T(0)), vlmax));
+}
+
+template <typename T, int LMUL>
+T dot(const T* a, const T* b, size_t n) {
+  using Ops = RvvOps<T, LMUL>;
+  size_t vlmax = Ops::setvlmax();
+  auto v_sum = Ops::splat(T(0), vlmax);
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    auto v_a = Ops::load(a + i, vl);
+    auto v_b = Ops::load(b + i, vl);
+    v_sum = __riscv_vfmacc_tu(v_sum, v_a, v_b, vl);
+  }
+  return Ops::first(__riscv_vfredusum(v_sum, Ops::splat_m1(T(0)), vlmax));
+}
+
+namespace {
+
+// (a OP b) for integer and floating-point vectors; b may be a vector or a
+// scalar, the overloaded intrinsics pick the .vv/.vx/.vf form.
+template <CmpOp Op, typename V, typename B>
+inline auto compare_int(V a, B b, size_t vl) {
+  if constexpr (Op == CmpOp::kLt) return __riscv_vmslt(a, b, vl);
+  else if constexpr (Op == CmpOp::kLe) return __riscv_vmsle(a, b, vl);
+  else if constexpr (Op == CmpOp::kGt) return __riscv_vmsgt(a, b, vl);
+  else if constexpr (Op == CmpOp::kGe) return __riscv_vmsge(a, b, vl);
+  else if constexpr (Op == CmpOp::kEq) return __riscv_vmseq(a, b, vl);
+  else return __riscv_vmsne(a, b, vl);
+}
+
+template <CmpOp Op, typename V, typename B>
+inline auto compare_float(V a, B b, size_t vl) {
+  if constexpr (Op == CmpOp::kLt) return __riscv_vmflt(a, b, vl);
+  else if constexpr (Op == CmpOp::kLe) return __riscv_vmfle(a, b, vl);
+  else if constexpr (Op == CmpOp::kGt) return __riscv_vmfgt(a, b, vl);
+  else if constexpr (Op == CmpOp::kGe) return __riscv_vmfge(a, b, vl);
+  else if constexpr (Op == CmpOp::kEq) return __riscv_vmfeq(a, b, vl);
+  else return __riscv_vmfne(a, b, vl);
+}
+
+template <typename T, CmpOp Op, typename V, typename B>
+inline auto compare(V a, B b, size_t vl) {
+  if constexpr (std::is_floating_point_v<T>) return compare_float<Op>(a, b, vl);
+  else return compare_int<Op>(a, b, vl);
+}
+
+}  // namespace
+
+template <typename T, CmpOp Op, int LMUL>
+void compare_bitmap(const T* a, const T* b, uint8_t* out, size_t out_offset,
+                    size_t n) {
+  using Ops = RvvOps<T, LMUL>;
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    auto v_a = Ops::load(a + i, vl);
+    auto v_b = Ops::load(b + i, vl);
+    detail::store_mask_bits<Ops>(out, out_offset + i,
+                                 compare<T, Op>(v_a, v_b, vl), vl);
+  }
+}
+
+template <typename T, CmpOp Op, int LMUL>
+void compare_scalar_bitmap(const T* a, T value, uint8_t* out,
+                           size_t out_offset, size_t n) {
+  using Ops = RvvOps<T, LMUL>;
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    auto v_a = Ops::load(a + i, vl);
+    detail::store_mask_bits<Ops>(out, out_offset + i,
+                                 compare<T, Op>(v_a, value, vl), vl);
+  }
+}
+
+namespace {
+
+template <typename Ops, typename V>
+inline typename Ops::mask_t eval_term(const Int32Term& term, V v_lhs,
+                                      size_t i, size_t vl) {
+  if (term.rhs != nullptr) {
+    auto v_rhs = Ops::load(term.rhs + i, vl);
+    switch (term.op) {
+      case CmpOp::kLt: return compare_int<CmpOp::kLt>(v_lhs, v_rhs, vl);
+      case CmpOp::kLe: return compare_int<CmpOp::kLe>(v_lhs, v_rhs, vl);
+      case CmpOp::kGt: return compare_int<CmpOp::kGt>(v_lhs, v_rhs, vl);
+      case CmpOp::kGe: return compare_int<CmpOp::kGe>(v_lhs, v_rhs, vl);
+      case CmpOp::kEq: return compare_int<CmpOp::kEq>(v_lhs, v_rhs, vl);
+      default: return compare_int<CmpOp::kNe>(v_lhs, v_rhs, vl);
+    }
+  }
+  switch (term.op) {
+    case CmpOp::kLt: return compare_int<CmpOp::kLt>(v_lhs, term.value, vl);
+    case CmpOp::kLe: return compare_int<CmpOp::kLe>(v_lhs, term.value, vl);
+    case CmpOp::kGt: return compare_int<CmpOp::kGt>(v_lhs, term.value, vl);
+    case CmpOp::kGe: return compare_int<CmpOp::kGe>(v_lhs, term.value, vl);
+    case CmpOp::kEq: return compare_int<CmpOp::kEq>(v_lhs, term.value, vl);
+    default: return compare_int<CmpOp::kNe>(v_lhs, term.value, vl);
+  }
+}
+
+}  // namespace
+
+template <int LMUL>
+void conjunction_bitmap(const Int32Term* terms, size_t num_terms, uint8_t* out,
+                        size_t out_offset, size_t n) {
+  using Ops = RvvOps<int32_t, LMUL>;
+  if (num_terms == 0) {
+    // An empty conjunction is TRUE for every row.
+    size_t vl;
+    for (size_t i = 0; i < n; i += vl) {
+      vl = Ops::setvl(n - i);
+      auto v_zero = Ops::splat(0, vl);
+      detail::store_mask_bits<Ops>(out, out_offset + i,
+                                   __riscv_vmseq(v_zero, int32_t(0), vl), vl);
+    }
+    return;
+  }
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    auto v_lhs = Ops::load(terms[0].lhs + i, vl);
+    auto v_mask = eval_term<Ops>(terms[0], v_lhs, i, vl);
+    for (size_t t = 1; t < num_terms; t++) {
+      v_lhs = Ops::load(terms[t].lhs + i, vl);
+      v_mask = __riscv_vmand(v_mask, eval_term<Ops>(terms[t], v_lhs, i, vl), vl);
+    }
+    detail::store_mask_bits<Ops>(out, out_offset + i, v_mask, vl);
+  }
+}
+
+template <int LMUL>
+void and_bitmap(uint8_t* out, size_t out_offset, const uint8_t* other,
+                size_t other_offset, size_t n) {
+  using Ops = RvvOps<int32_t, LMUL>;
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    auto v_out = detail::load_mask_bits<Ops>(out, out_offset + i, vl);
+    auto v_other = detail::load_mask_bits<Ops>(other, other_offset + i, vl);
+    detail::store_mask_bits<Ops>(out, out_offset + i,
+                                 __riscv_vmand(v_out, v_other, vl), vl);
+  }
+}
+
+template <int LMUL>
+size_t bitmap_to_selection(const uint8_t* bitmap, size_t n, int32_t* rows) {
+  using Ops = RvvOps<int32_t, LMUL>;
+  size_t count = 0;
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    vl = Ops::setvl(n - i);
+    auto v_set = detail::load_mask_bits<Ops>(bitmap, i, vl);
+    size_t selected = __riscv_vcpop(v_set, vl);
+    if (selected == 0) {
+      continue;
+    }
+    auto v_rows =
+        __riscv_vadd(Ops::lane_index(vl), static_cast<uint32_t>(i), vl);
+    __riscv_vse32(reinterpret_cast<uint32_t*>(rows + count),
+                  __riscv_vcompress(v_rows, v_set, vl), selected);
+    count += selected;
+  }
+  return count;
+}
+
+size_t count_bits(const uint8_t* bitmap, size_t n) {
+  size_t count = 0;
+  size_t vlmax = __riscv_vsetvlmax_e8m8();
+  size_t vl;
+  for (size_t i = 0; i < n; i += vl) {
+    // Clamp to vlmax so that every strip but the last covers exactly VLEN
+    // bits and the next load stays byte-aligned.
+    vl = __riscv_vsetvl_e8m8(std::min(n - i, vlmax));
+    vbool1_t v_bits = __riscv_vlm_v_b1(bitmap + i / 8, vl);
+    count += __riscv_vcpop_m_b1(v_bits, vl);
+  }
+  return count;
+}
+
+size_t vector_group_bytes() {
+  return RvvOps<uint8_t, kDefaultLmul>::setvlmax();
+}
+
+#define RVV_INSTANTIATE_FLOAT(T, LMUL)                                        \
+  template void mul_one_minus<T, LMUL>(const T*, const T*, T*, size_t);       \
+  template void mul_one_plus<T, LMUL>(const T*, const T*, T*, size_t);        \
+  template void mul<T, LMUL>(const T*, const T*, T*, size_t);                 \
+  template void sub<T, LMUL>(const T*, const T*, T*, size_t);                 \
+  template void mul_one_minus_sub_mul<T, LMUL>(const T*, const T*, const T*,  \
+                                               const T*, T*, size_t);         \
+  template T sum<T, LMUL>(const T*, size_t);                                  \
+  template T sum_masked<T, LMUL>(const T*, const uint8_t*, size_t);           \
+  template T dot<T, LMUL>(const T*, const T*, size_t);
+
+#define RVV_INSTANTIATE_COMPARE_OP(T, OP, LMUL)                               \
+  template void compare_bitmap<T, CmpOp::OP, LMUL>(const T*, const T*,        \
+                                                   uint8_t*, size_t, size_t); \
+  template void compare_scalar_bitmap<T, CmpOp::OP, LMUL>(                    \
+      const T*, T, uint8_t*, size_t, size_t);
+
+#define RVV_INSTANTIATE_COMPARE(T, LMUL)                                      \
+  RVV_INSTANTIATE_COMPARE_OP(T, kLt, LMUL)                                    \
+  RVV_INSTANTIATE_COMPARE_OP(T, kLe, LMUL)                                    \
+  RVV_INSTANTIATE_COMPARE_OP(T, kGt, LMUL)                                    \
+  RVV_INSTANTIATE_COMPARE_OP(T, kGe, LMUL)                                    \
+  RVV_INSTANTIATE_COMPARE_OP(T, kEq, LMUL)                                    \
+  RVV_INSTANTIATE_COMPARE_OP(T, kNe, LMUL)
+
+#define RVV_INSTANTIATE_LMUL(LMUL)                                            \
+  RVV_INSTANTIATE_FLOAT(float, LMUL)                                          \
+  RVV_INSTANTIATE_FLOAT(double, LMUL)                                         \
+  RVV_INSTANTIATE_COMPARE(int32_t, LMUL)                                      \
+  RVV_INSTANTIATE_COMPARE(int64_t, LMUL)                                      \
+  RVV_INSTANTIATE_COMPARE(float, LMUL)                                        \
+  RVV_INSTANTIATE_COMPARE(double, LMUL)                                       \
+  template void conjunction_bitmap<LMUL>(const Int32Term*, size_t, uint8_t*,  \
+                                         size_t, size_t);                     \
+  template void and_bitmap<LMUL>(uint8_t*, size_t, const uint8_t*, size_t,    \
+                                 size_t);                                     \
+  template size_t bitmap_to_selection<LMUL>(const uint8_t*, size_t, int32_t*);
+
+RVV_INSTANTIATE_LMUL(1)
+RVV_INSTANTIATE_LMUL(2)
+RVV_INSTANTIATE_LMUL(4)
+RVV_INSTANTIATE_LMUL(8)
+
+}  // namespace rvv
@@ -0,0 +1,346 @@
+// Shared RVV kernel library used by every rvv_query* binary.
+//
+// All kernels are strip-mined loops templated on element type and LMUL. The
+// default LMUL comes from the RVV_LMUL CMake option, so retuning for a board
+// is a one-line change; call sites can still pin a variant explicitly, e.g.
+// rvv::sum<float, 4>(data, n). Every (type, LMUL) combination is
+// instantiated once in rvv_kernels.cpp; rvv_dispatch.h picks one per kernel
+// class at runtime.
+//
+// The RVV sources (rvv_*.cpp) are one backend of this API; the CMake option
+// KERNEL_BACKEND=portable substitutes portable_kernels.cpp on hosts without
+// the V extension.
+//
+// Bitmaps are Arrow-compatible: bit i lives in byte i / 8 at position i % 8.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#ifndef RVV_DEFAULT_LMUL
+#define RVV_DEFAULT_LMUL 8
+#endif
+
+namespace rvv {
+
+constexpr int kDefaultLmul = RVV_DEFAULT_LMUL;
+
+enum class CmpOp { kLt, kLe, kGt, kGe, kEq, kNe };
+
+// out[i] = a[i] * (1 - b[i]), e.g. l_extendedprice * (1 - l_discount)
+template <typename T, int LMUL = kDefaultLmul>
+void mul_one_minus(const T* a, const T* b, T* out, size_t n);
+
+// out[i] = a[i] * (1 + b[i]), e.g. disc_price * (1 + l_tax)
+template <typename T, int LMUL = kDefaultLmul>
+void mul_one_plus(const T* a, const T* b, T* out, size_t n);
+
+// out[i] = a[i] * b[i]
+template <typename T, int LMUL = kDefaultLmul>
+void mul(const T* a, const T* b, T* out, size_t n);
+
+// out[i] = a[i] - b[i]
+template <typename T, int LMUL = kDefaultLmul>
+void sub(const T* a, const T* b, T* out, size_t n);
+
+// out[i] = a[i] * (1 - b[i]) - c[i] * d[i] with no intermediate array,
+// e.g. l_extendedprice * (1 - l_discount) - ps_supplycost * l_quantity
+template <typename T, int LMUL = kDefaultLmul>
+void mul_one_minus_sub_mul(const T* a, const T* b, const T* c, const T* d,
+                           T* out, size_t n);
+
+// SUM(data[i])
+template <typename T, int LMUL = kDefaultLmul>
+T sum(const T* data, size_t n);
+
+// SUM(data[i]) over rows whose bit is set in bitmap
+template <typename T, int LMUL = kDefaultLmul>
+T sum_masked(const T* data, const uint8_t* bitmap, size_t n);
+
+// SUM(a[i] * b[i]), e.g. SUM(l_extendedprice * l_discount)
+template <typename T, int LMUL = kDefaultLmul>
+T dot(const T* a, const T* b, size_t n);
+
+// The predicate kernels below write bit (out_offset + i) of out for row i and
+// leave every other bit untouched, so consecutive chunks can be written into
+// one bitmap at arbitrary (not necessarily byte-aligned) row offsets.
+
+// Sets bit out_offset + i of out to (a[i] OP b[i]).
+template <typename T, CmpOp Op, int LMUL = kDefaultLmul>
+void compare_bitmap(const T* a, const T* b, uint8_t* out, size_t out_offset,
+                    size_t n);
+
+// Sets bit out_offset + i of out to (a[i] OP value).
+template <typename T, CmpOp Op, int LMUL = kDefaultLmul>
+void compare_scalar_bitmap(const T* a, T value, uint8_t* out,
+                           size_t out_offset, size_t n);
+
+// One term of a conjunctive predicate over int32 / date32 columns:
+// lhs[i] OP rhs[i] when rhs is non-null, otherwise lhs[i] OP value.
+struct Int32Term {
+  CmpOp op;
+  const int32_t* lhs;
+  const int32_t* rhs;
+  int32_t value;
+};
+
+// Sets bit out_offset + i of out to the AND of all terms for row i. All
+// terms are evaluated in registers per strip; only the final mask is stored.
+template <int LMUL = kDefaultLmul>
+void conjunction_bitmap(const Int32Term* terms, size_t num_terms, uint8_t* out,
+                        size_t out_offset, size_t n);
+
+// Clears bit out_offset + i of out wherever bit other_offset + i of other is
+// clear. Used to drop null rows from a selection bitmap: pass an Arrow
+// validity bitmap with other_offset = Array::offset().
+template <int LMUL = kDefaultLmul>
+void and_bitmap(uint8_t* out, size_t out_offset, const uint8_t* other,
+                size_t other_offset, size_t n);
+
+// Selection vector of a bitmap: writes the rows i < n whose bit is set to
+// rows, in increasing order, and returns their count (vid + vcompress).
+// rows must have room for n entries.
+template <int LMUL = kDefaultLmul>
+size_t bitmap_to_selection(const uint8_t* bitmap, size_t n, int32_t* rows);
+
+// Decimal128 decode. values points at n little-endian 16-byte Decimal128
+// values (e.g. Decimal128Array::raw_values(), which already honours the
+// array offset). The low and high halves are fetched with strided loads;
+// lanes whose high half is just the sign extension of the low half take the
+// vector path, anything wider falls back to a scalar conversion.
+
+// Unscaled int64 values. Returns false if some value needs more than 64
+// bits, in which case the contents of out are unspecified.
+template <int LMUL = kDefaultLmul>
+bool decode_decimal128_unscaled(const uint8_t* values, int64_t* out, size_t n);
+
+// Unscaled values narrowed to int32 for the exact aggregation kernels.
+// Returns false if some value does not fit in int32.
+template <int LMUL = kDefaultLmul>
+bool decode_decimal128_unscaled(const uint8_t* values, int32_t* out, size_t n);
+
+// value / 10^scale as float or double.
+template <typename T, int LMUL = kDefaultLmul>
+void decode_decimal128(const uint8_t* values, int32_t scale, T* out, size_t n);
+
+// Clears bit out_offset + i of out unless lo <= values[i] <= hi (unscaled;
+// values wider than 64 bits are out of range). Only rows whose bit is still
+// set are loaded, and strips without one are skipped, so a chain of these
+// filters gets cheaper as the selection thins out.
+template <int LMUL = kDefaultLmul>
+void and_decimal128_range(const uint8_t* values, int64_t lo, int64_t hi,
+                          uint8_t* out, size_t out_offset, size_t n);
+
+// Exact fixed-point aggregation over unscaled int32 decimal values.
+//
+// Inputs are widened into int64 lanes (vwadd / vwmul); products are kept as
+// 128-bit lane pairs (low word plus carry into a high word, vmulh for the
+// 64x64 charge product), so results never depend on summation order and
+// cannot overflow. LMUL here is the grouping of the int32 operands; the
+// int64 accumulators use twice that, hence the cap at 4.
+using Int128 = __int128;
+
+constexpr int kExactLmul = kDefaultLmul > 4 ? 4 : kDefaultLmul;
+
+// SUM(data[i])
+template <int LMUL = kExactLmul>
+Int128 sum_exact(const int32_t* data, size_t n);
+
+// SUM(data[i]) over rows whose bit is set in bitmap
+template <int LMUL = kExactLmul>
+Int128 sum_exact_masked(const int32_t* data, const uint8_t* bitmap, size_t n);
+
+// SUM(a[i] * b[i]); the result has scale(a) + scale(b)
+template <int LMUL = kExactLmul>
+Int128 dot_exact(const int32_t* a, const int32_t* b, size_t n);
+
+// SUM(a[i] * (one - b[i])) where one = 10^scale(b),
+// e.g. SUM(l_extendedprice * (1 - l_discount))
+template <int LMUL = kExactLmul>
+Int128 sum_mul_one_minus_exact(const int32_t* a, const int32_t* b, int32_t one,
+                               size_t n);
+
+// SUM(a[i] * (one_b - b[i]) * (one_c + c[i])),
+// e.g. SUM(l_extendedprice * (1 - l_discount) * (1 + l_tax))
+template <int LMUL = kExactLmul>
+Int128 sum_mul_one_minus_one_plus_exact(const int32_t* a, const int32_t* b,
+                                        int32_t one_b, const int32_t* c,
+                                        int32_t one_c, size_t n);
+
+// Date kernels (rvv_date.cpp), over date32 (days since 1970-01-01).
+
+// out[i] = calendar year of days[i], i.e. EXTRACT(YEAR FROM date), with the
+// integer civil-from-days arithmetic of year_from_days (date_util.h).
+template <int LMUL = kDefaultLmul>
+void date32_to_year(const int32_t* days, int32_t* out, size_t n);
+
+// Indexed-load kernels (rvv_gather.cpp).
+
+// out[i] = (first byte of a[i]) << 8 | (first byte of b[i]) for two string
+// columns given as Arrow offsets (raw_value_offsets(), n + 1 entries) and
+// data buffers; empty strings count as byte 0. Packs single-character keys
+// such as (l_returnflag, l_linestatus) into a code below 2^16. Returns false
+// if some string has more than one byte.
+template <int LMUL = kDefaultLmul>
+bool char_pair_codes(const int32_t* a_offsets, const uint8_t* a_data,
+                     const int32_t* b_offsets, const uint8_t* b_data,
+                     int32_t* out, size_t n);
+
+// out[i] = table[index[i]] (vluxei32); indices are not bounds-checked.
+// Returns the number of negative results, e.g. misses in a table that uses
+// -1 for empty slots.
+template <int LMUL = kDefaultLmul>
+size_t gather_int32(const int32_t* table, const int32_t* index, int32_t* out,
+                    size_t n);
+
+// Direct-address probe: out[i] = table[keys[i] - base] when that is inside
+// [0, size), -1 otherwise. Empty table entries hold -1 as well, so the
+// returned count of negative results is the number of misses. size must be
+// below 2^30.
+template <int LMUL = kExactLmul>
+size_t gather_dense_int32(const int32_t* table, int64_t base, size_t size,
+                          const int64_t* keys, int32_t* out, size_t n);
+
+// Late-materialized Decimal128 decode: out[j] is values[rows[j]], decoded as
+// by decode_decimal128_unscaled / decode_decimal128, for a selection vector
+// rows (see bitmap_to_selection). Only the selected values are read, with
+// indexed loads. LMUL is the grouping of the int32 rows; rows must be below
+// 2^28.
+template <int LMUL = kExactLmul>
+bool gather_decimal128_unscaled(const uint8_t* values, const int32_t* rows,
+                                size_t n, int32_t* out);
+
+template <typename T, int LMUL = kExactLmul>
+void gather_decimal128(const uint8_t* values, int32_t scale,
+                       const int32_t* rows, size_t n, T* out);
+
+// Dense group ids: out[i] = a[i] * scale + b[i] + offset, e.g.
+// nation * 8 + (year - 1992).
+template <int LMUL = kDefaultLmul>
+void linear_group_ids(const int32_t* a, int32_t scale, const int32_t* b,
+                      int32_t offset, int32_t* out, size_t n);
+
+// Conflict-free scatter-add for SUM / COUNT by dense group id. Every lane
+// owns a private copy of the accumulators, at slot
+// group * group_sum_lanes() + lane, so no two lanes of a strip touch the
+// same address; the vluxei / vsuxei pair needs no conflict detection.
+// Summing a group's slots over all lanes gives its total. The float values
+// are widened to double. lane_counts may be null; group ids are not
+// bounds-checked, and num_groups * group_sum_lanes() must stay below 2^29.
+template <int LMUL = kExactLmul>
+size_t group_sum_lanes();
+
+template <int LMUL = kExactLmul>
+void group_sum(const int32_t* group_ids, const float* values, size_t n,
+               double* lane_sums, int64_t* lane_counts);
+
+// Semi-join probes. Both set bit out_offset + i of out to whether keys[i]
+// may be in the build side and leave other bits untouched.
+
+// Dense bitmap over [base, base + size): bit k of words[k / 64] is set for
+// key base + 64 * (k / 64) + k % 64. Exact.
+template <int LMUL = kDefaultLmul>
+void probe_bitmap(const uint64_t* words, int64_t base, size_t size,
+                  const int64_t* keys, uint8_t* out, size_t out_offset,
+                  size_t n);
+
+// Blocked Bloom filter of 2^log_blocks 64-bit blocks (1 <= log_blocks <=
+// 40): a key sets the three bits of bloom_pattern() in block bloom_block().
+// May report false positives, never false negatives.
+constexpr uint64_t kBloomMultiplier = 0x9E3779B97F4A7C15ULL;
+constexpr unsigned kBloomBitShifts[] = {20, 26, 32};
+
+inline uint64_t bloom_hash(int64_t key) {
+  return static_cast<uint64_t>(key) * kBloomMultiplier;
+}
+inline uint64_t bloom_block(uint64_t hash, int log_blocks) {
+  return hash >> (64 - log_blocks);
+}
+inline uint64_t bloom_pattern(uint64_t hash) {
+  uint64_t pattern = 0;
+  for (unsigned shift : kBloomBitShifts) {
+    pattern |= uint64_t(1) << ((hash >> shift) & 63);
+  }
+  return pattern;
+}
+
+template <int LMUL = kDefaultLmul>
+void probe_bloom(const uint64_t* blocks, int log_blocks, const int64_t* keys,
+                 uint8_t* out, size_t out_offset, size_t n);
+
+// String kernels (rvv_string.cpp), over string columns given as Arrow
+// offsets (raw_value_offsets(), n + 1 entries) and data buffers.
+
+// Sets bit out_offset + i of out to whether string i contains needle, i.e.
+// LIKE '%needle%', and leaves other bits untouched. One pass over the data
+// buffer compares every position against the first and the last byte of
+// needle at once; only positions where both match are verified.
+template <int LMUL = kDefaultLmul>
+void contains_bitmap(const int32_t* offsets, const uint8_t* data, size_t n,
+                     const char* needle, size_t needle_length, uint8_t* out,
+                     size_t out_offset);
+
+// Fused TPC-H Q1 aggregation (rvv_fused.cpp).
+//
+// One strip-mined pass over the raw columns: the shipdate predicate becomes
+// a mask, the Decimal128 inputs are read with strided loads, disc_price and
+// charge are computed in registers and every aggregate is added into its
+// group with masked reductions. Nothing per row is written to memory.
+struct Q1Input {
+  const int32_t* shipdate;   // date32; rows with shipdate <= cutoff qualify
+  int32_t cutoff;
+  const uint8_t* selection;  // if non-null, rows whose bit is clear never do
+  const int32_t* group_ids;  // group of each row, in [0, num_groups)
+  const uint8_t* quantity;   // Decimal128 values, as for decode_decimal128
+  const uint8_t* price;
+  const uint8_t* discount;
+  const uint8_t* tax;
+  int32_t quantity_scale;
+  int32_t price_scale;
+  int32_t discount_scale;
+  int32_t tax_scale;
+};
+
+// Per-group unscaled sums; disc_price has scale price + discount and charge
+// price + discount + tax.
+struct Q1Sums {
+  int64_t count = 0;
+  Int128 qty = 0;
+  Int128 price = 0;
+  Int128 disc = 0;
+  Int128 disc_price = 0;
+  Int128 charge = 0;
+};
+
+struct Q1SumsFloat {
+  int64_t count = 0;
+  double qty = 0;
+  double price = 0;
+  double disc = 0;
+  double disc_price = 0;
+  double charge = 0;
+};
+
+// The default LMUL is 1: the kernel keeps a dozen int64 vectors live, at
+// twice the LMUL of the int32 shipdate and group id operands.
+
+// Adds the qualifying rows of in into groups[0 .. num_groups). Returns false
+// if a qualifying decimal does not fit in int32 (groups are then partially
+// updated).
+template <int LMUL = 1>
+bool q1_aggregate_exact(const Q1Input& in, size_t n, Q1Sums* groups,
+                        size_t num_groups);
+
+// The same in double arithmetic. Returns false if a qualifying decimal does
+// not fit in int64.
+template <int LMUL = 1>
+bool q1_aggregate_float(const Q1Input& in, size_t n, Q1SumsFloat* groups,
+                        size_t num_groups);
+
+// Number of set bits among the first n bits of bitmap.
+size_t count_bits(const uint8_t* bitmap, size_t n);
+
+// Bytes in one register group at the default LMUL (VLEN / 8 * LMUL).
+size_t vector_group_bytes();
+
+}  // namespace rvv
@@ -0,0 +1,365 @@
+// Micro-benchmarks of the RVV kernels across LMUL and working-set size, and
+// the calibration behind rvv_dispatch.h.
+//
+//   rvv_microbench [--repeat=N] [--class=NAME] [--calibrate[=PATH]]
+//
+// Every kernel runs at LMUL 1, 2, 4 and 8 (capped where the kernel is) on
+// working sets from L1-resident (16 KiB) to DRAM-resident (64 MiB). Each
+// point reports the best of --repeat measurements (default 5) as
+// nanoseconds per row and as the bytes per second the kernel streamed.
+//
+// --calibrate picks, per kernel class, the LMUL with the lowest geometric
+// mean time per row over the kernels and sizes of that class, and stores it
+// for this vlenb in PATH (default: rvv::calibration_path()), where every
+// rvv_query* binary picks it up at startup. With --class only that class is
+// measured; the others keep their current selection.
+#include "rvv_dispatch.h"
+#include "rvv_kernels.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+using rvv::KernelClass;
+
+constexpr int kLmuls[] = {1, 2, 4, 8};
+constexpr size_t kWorkingSets[] = {size_t(16) << 10, size_t(256) << 10,
+                                   size_t(4) << 20, size_t(64) << 20};
+// Rows per measurement, so L1-sized points still run long enough to time
+constexpr size_t kMinRowsPerMeasurement = size_t(1) << 22;
+
+// Results of reductions go here so they are not optimized away
+volatile double g_sink;
+
+struct Kernel {
+  const char* name;
+  KernelClass kernel_class;
+  size_t row_bytes;  // bytes read and written per row
+  // Allocates and fills the inputs of rows rows; returns the kernel over
+  // them, run at the given LMUL.
+  std::function<std::function<void(int lmul)>(size_t rows)> prepare;
+};
+
+// Decimal128 values with scale 2 in [0, 100)
+std::shared_ptr<std::vector<int64_t>> MakeDecimals(size_t rows) {
+  auto values = std::make_shared<std::vector<int64_t>>(2 * rows);
+  for (size_t i = 0; i < rows; i++) {
+    (*values)[2 * i] = static_cast<int64_t>((i * 7919) % 10000);
+    (*values)[2 * i + 1] = 0;
+  }
+  return values;
+}
+
+const uint8_t* Bytes(const std::vector<int64_t>& values) {
+  return reinterpret_cast<const uint8_t*>(values.data());
+}
+
+std::shared_ptr<std::vector<float>> MakeFloats(size_t rows, float scale) {
+  auto values = std::make_shared<std::vector<float>>(rows);
+  for (size_t i = 0; i < rows; i++) {
+    (*values)[i] = scale * static_cast<float>((i * 7919) % 1000) / 1000.0f;
+  }
+  return values;
+}
+
+// date32 values spread over seven years, as in TPC-H
+std::shared_ptr<std::vector<int32_t>> MakeDates(size_t rows) {
+  auto values = std::make_shared<std::vector<int32_t>>(rows);
+  for (size_t i = 0; i < rows; i++) {
+    (*values)[i] = 8035 + static_cast<int32_t>((i * 7919) % 2557);
+  }
+  return values;
+}
+
+std::vector<Kernel> Kernels() {
+  std::vector<Kernel> kernels;
+  kernels.push_back(
+      {"decode_decimal128", KernelClass::kDecode, 16 + sizeof(float),
+       [](size_t rows) {
+         auto values = MakeDecimals(rows);
+         auto out = std::make_shared<std::vector<float>>(rows);
+         return [=](int lmul) {
+           rvv::dispatch_lmul(lmul, [&](auto l) {
+             rvv::decode_decimal128<float, decltype(l)::value>(
+                 Bytes(*values), 2, out->data(), rows);
+           });
+         };
+       }});
+  kernels.push_back(
+      {"gather_decimal128", KernelClass::kDecode,
+       sizeof(int32_t) + 16 + sizeof(float), [](size_t rows) {
+         auto values = MakeDecimals(rows);
+         // Every row, in a scattered order
+         auto selection = std::make_shared<std::vector<int32_t>>(rows);
+         for (size_t i = 0; i < rows; i++) {
+           (*selection)[i] = static_cast<int32_t>((i * 7919) % rows);
+         }
+         auto out = std::make_shared<std::vector<float>>(rows);
+         return [=](int lmul) {
+           rvv::dispatch_lmul<4>(lmul, [&](auto l) {
+             rvv::gather_decimal128<float, decltype(l)::value>(
+                 Bytes(*values), 2, selection->data(), rows, out->data());
+           });
+         };
+       }});
+  kernels.push_back(
+      {"conjunction_bitmap", KernelClass::kCompare, sizeof(int32_t),
+       [](size_t rows) {
+         auto dates = MakeDates(rows);
+         auto out = std::make_shared<std::vector<uint8_t>>((rows + 7) / 8);
+         return [=](int lmul) {
+           const rvv::Int32Term terms[] = {
+               {rvv::CmpOp::kGe, dates->data(), nullptr, 8766},
+               {rvv::CmpOp::kLt, dates->data(), nullptr, 9131}};
+           rvv::dispatch_lmul(lmul, [&](auto l) {
+             rvv::conjunction_bitmap<decltype(l)::value>(terms, 2, out->data(),
+                                                         0, rows);
+           });
+         };
+       }});
+  kernels.push_back(
+      {"compare_bitmap", KernelClass::kCompare, 2 * sizeof(int32_t),
+       [](size_t rows) {
+         auto a = MakeDates(rows);
+         auto b = MakeDates(rows);
+         std::reverse(b->begin(), b->end());
+         auto out = std::make_shared<std::vector<uint8_t>>((rows + 7) / 8);
+         return [=](int lmul) {
+           rvv::dispatch_lmul(lmul, [&](auto l) {
+             rvv::compare_bitmap<int32_t, rvv::CmpOp::kLt, decltype(l)::value>(
+                 a->data(), b->data(), out->data(), 0, rows);
+           });
+         };
+       }});
+  kernels.push_back(
+      {"mul_one_minus", KernelClass::kArith, 3 * sizeof(float),
+       [](size_t rows) {
+         auto a = MakeFloats(rows, 100000.0f);
+         auto b = MakeFloats(rows, 0.1f);
+         auto out = std::make_shared<std::vector<float>>(rows);
+         return [=](int lmul) {
+           rvv::dispatch_lmul(lmul, [&](auto l) {
+             rvv::mul_one_minus<float, decltype(l)::value>(
+                 a->data(), b->data(), out->data(), rows);
+           });
+         };
+       }});
+  kernels.push_back(
+      {"mul_one_minus_sub_mul", KernelClass::kArith, 5 * sizeof(float),
+       [](size_t rows) {
+         auto a = MakeFloats(rows, 100000.0f);
+         auto b = MakeFloats(rows, 0.1f);
+         auto c = MakeFloats(rows, 1000.0f);
+         auto d = MakeFloats(rows, 50.0f);
+         auto out = std::make_shared<std::vector<float>>(rows);
+         return [=](int lmul) {
+           rvv::dispatch_lmul(lmul, [&](auto l) {
+             rvv::mul_one_minus_sub_mul<float, decltype(l)::value>(
+                 a->data(), b->data(), c->data(), d->data(), out->data(),
+                 rows);
+           });
+         };
+       }});
+  kernels.push_back(
+      {"dot", KernelClass::kReduce, 2 * sizeof(float), [](size_t rows) {
+         auto a = MakeFloats(rows, 100000.0f);
+         auto b = MakeFloats(rows, 0.1f);
+         return [=](int lmul) {
+           rvv::dispatch_lmul(lmul, [&](auto l) {
+             g_sink = rvv::dot<float, decltype(l)::value>(a->data(), b->data(),
+                                                          rows);
+           });
+         };
+       }});
+  kernels.push_back(
+      {"dot_exact", KernelClass::kReduce, 2 * sizeof(int32_t),
+       [](size_t rows) {
+         auto a = MakeDates(rows);
+         auto b = MakeDates(rows);
+         return [=](int lmul) {
+           rvv::dispatch_lmul<4>(lmul, [&](auto l) {
+             g_sink = static_cast<double>(
+                 rvv::dot_exact<decltype(l)::value>(a->data(), b->data(), rows));
+           });
+         };
+       }});
+  kernels.push_back(
+      {"q1_aggregate_float", KernelClass::kFused,
+       2 * sizeof(int32_t) + 4 * 16, [](size_t rows) {
+         auto dates = MakeDates(rows);
+         auto groups = std::make_shared<std::vector<int32_t>>(rows);
+         for (size_t i = 0; i < rows; i++) {
+           (*groups)[i] = static_cast<int32_t>((i * 7919) % 4);
+         }
+         auto quantity = MakeDecimals(rows);
+         auto price = MakeDecimals(rows);
+         auto discount = MakeDecimals(rows);
+         auto tax = MakeDecimals(rows);
+         return [=](int lmul) {
+           rvv::Q1Input in;
+           in.shipdate = dates->data();
+           in.cutoff = 10471;
+           in.selection = nullptr;
+           in.group_ids = groups->data();
+           in.quantity = Bytes(*quantity);
+           in.price = Bytes(*price);
+           in.discount = Bytes(*discount);
+           in.tax = Bytes(*tax);
+           in.quantity_scale = in.price_scale = 2;
+           in.discount_scale = in.tax_scale = 2;
+           rvv::Q1SumsFloat sums[4];
+           rvv::dispatch_lmul<4>(lmul, [&](auto l) {
+             rvv::q1_aggregate_float<decltype(l)::value>(in, rows, sums, 4);
+           });
+           g_sink = sums[0].charge;
+         };
+       }});
+  return kernels;
+}
+
+struct BenchOptions {
+  int repeat = 5;
+  bool calibrate = false;
+  std::string calibration_path;
+  bool all_classes = true;
+  KernelClass kernel_class = KernelClass::kDecode;
+};
+
+const char* Usage() {
+  return "Usage: rvv_microbench [--repeat=N] "
+         "[--class=decode|compare|arith|reduce|fused] [--calibrate[=PATH]]";
+}
+
+std::string ParseOptions(int argc, char** argv, BenchOptions* options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg.rfind("--repeat=", 0) == 0) {
+      options->repeat = std::atoi(arg.c_str() + 9);
+      if (options->repeat < 1) {
+        return "--repeat must be at least 1";
+      }
+    } else if (arg.rfind("--class=", 0) == 0) {
+      std::string name = arg.substr(8);
+      bool found = false;
+      for (int c = 0; c < rvv::kNumKernelClasses; c++) {
+        if (name == rvv::kernel_class_name(static_cast<KernelClass>(c))) {
+          options->kernel_class = static_cast<KernelClass>(c);
+          found = true;
+        }
+      }
+      if (!found) {
+        return "Unknown kernel class: " + name;
+      }
+      options->all_classes = false;
+    } else if (arg == "--calibrate") {
+      options->calibrate = true;
+    } else if (arg.rfind("--calibrate=", 0) == 0) {
+      options->calibrate = true;
+      options->calibration_path = arg.substr(12);
+    } else {
+      return "Unknown option: " + arg;
+    }
+  }
+  if (options->calibration_path.empty()) {
+    options->calibration_path = rvv::calibration_path();
+  }
+  return "";
+}
+
+// Best time per row of repeat measurements, in nanoseconds
+double Measure(const std::function<void(int)>& run, int lmul, size_t rows,
+               int repeat) {
+  size_t iterations = std::max<size_t>(1, kMinRowsPerMeasurement / rows);
+  run(lmul);  // warmup: faults the pages in and warms the caches
+  double best = INFINITY;
+  for (int r = 0; r < repeat; r++) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+      run(lmul);
+    }
+    std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count() / (iterations * rows));
+  }
+  return best;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  BenchOptions options;
+  std::string error = ParseOptions(argc, argv, &options);
+  if (!error.empty()) {
+    std::cerr << "Error: " << error << '\n' << Usage() << std::endl;
+    return 1;
+  }
+
+  std::cout << "vlenb " << rvv::vlenb() << ", best of " << options.repeat
+            << " runs\n\n";
+  std::printf("%-22s %-8s %4s %10s %10s %9s\n", "kernel", "class", "lmul",
+              "working_set", "ns/row", "GB/s");
+
+  // Sum of log(ns / row) and the number of points per (class, LMUL index)
+  double log_sum[rvv::kNumKernelClasses][4] = {};
+  int points[rvv::kNumKernelClasses] = {};
+  for (const Kernel& kernel : Kernels()) {
+    if (!options.all_classes && kernel.kernel_class != options.kernel_class) {
+      continue;
+    }
+    int c = static_cast<int>(kernel.kernel_class);
+    for (size_t working_set : kWorkingSets) {
+      size_t rows = std::max<size_t>(working_set / kernel.row_bytes, 64);
+      std::function<void(int)> run = kernel.prepare(rows);
+      for (int l = 0; l < 4; l++) {
+        double ns_per_row = Measure(run, kLmuls[l], rows, options.repeat);
+        log_sum[c][l] += std::log(ns_per_row);
+        std::printf("%-22s %-8s %4d %9zuK %10.3f %9.2f\n", kernel.name,
+                    rvv::kernel_class_name(kernel.kernel_class), kLmuls[l],
+                    working_set >> 10, ns_per_row,
+                    kernel.row_bytes / ns_per_row);
+      }
+      points[c]++;
+    }
+  }
+
+  // Lowest geometric mean per class; ties go to the smaller LMUL
+  int lmul[rvv::kNumKernelClasses];
+  std::cout << "\nclass     selected  fastest\n";
+  for (int c = 0; c < rvv::kNumKernelClasses; c++) {
+    auto kernel_class = static_cast<KernelClass>(c);
+    lmul[c] = rvv::selected_lmul(kernel_class);
+    if (points[c] == 0) {
+      continue;
+    }
+    int best = 0;
+    for (int l = 1; l < 4; l++) {
+      if (log_sum[c][l] < log_sum[c][best]) {
+        best = l;
+      }
+    }
+    std::printf("%-9s %8d %8d\n", rvv::kernel_class_name(kernel_class),
+                lmul[c], kLmuls[best]);
+    lmul[c] = kLmuls[best];
+  }
+
+  if (options.calibrate) {
+    if (!rvv::write_calibration(options.calibration_path, lmul, &error)) {
+      std::cerr << "Error: " << error << std::endl;
+      return 1;
+    }
+    std::cout << "\nCalibration written to " << options.calibration_path
+              << std::endl;
+  }
+  return 0;
+}
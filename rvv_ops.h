@@ -0,0 +1,203 @@
+// Internal RVV helpers shared by the kernel library translation units.
+// Query code includes rvv_kernels.h instead; this header is the only place
+// that maps (element type, LMUL) onto concrete intrinsic names.
+#pragma once
+
+#include <riscv_vector.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rvv {
+namespace detail {
+
+// Per (element type, LMUL) vector types and the few intrinsics that cannot
+// be resolved through the overloaded API (they take no vector operand).
+template <typename T, int LMUL>
+struct RvvOps;
+
+#define RVV_COMMON_OPS(T, TYPE, LETTER, SEW, LMUL, MLEN)                      \
+  using elem_t = T;                                                           \
+  using vec_t = v##TYPE##SEW##m##LMUL##_t;                                    \
+  using m1_t = v##TYPE##SEW##m1_t;                                            \
+  using mask_t = vbool##MLEN##_t;                                             \
+  static size_t setvl(size_t n) { return __riscv_vsetvl_e##SEW##m##LMUL(n); } \
+  static size_t setvlmax() { return __riscv_vsetvlmax_e##SEW##m##LMUL(); }    \
+  static vec_t load(const T* p, size_t vl) {                                  \
+    return __riscv_vle##SEW##_v_##LETTER##SEW##m##LMUL(p, vl);                \
+  }                                                                           \
+  static void store(T* p, vec_t v, size_t vl) {                               \
+    __riscv_vse##SEW##_v_##LETTER##SEW##m##LMUL(p, v, vl);                    \
+  }                                                                           \
+  static vec_t load_strided(const T* p, ptrdiff_t stride, size_t vl) {        \
+    return __riscv_vlse##SEW##_v_##LETTER##SEW##m##LMUL(p, stride, vl);       \
+  }                                                                           \
+  static mask_t load_mask(const uint8_t* p, size_t vl) {                      \
+    return __riscv_vlm_v_b##MLEN(p, vl);                                      \
+  }                                                                           \
+  static void store_mask(uint8_t* p, mask_t m, size_t vl) {                   \
+    __riscv_vsm_v_b##MLEN(p, m, vl);                                          \
+  }
+
+#define RVV_FLOAT_OPS(T, SEW, LMUL, MLEN)                                     \
+  template <>                                                                 \
+  struct RvvOps<T, LMUL> {                                                    \
+    RVV_COMMON_OPS(T, float, f, SEW, LMUL, MLEN)                              \
+    static vec_t splat(T x, size_t vl) {                                      \
+      return __riscv_vfmv_v_f_f##SEW##m##LMUL(x, vl);                         \
+    }                                                                         \
+    static m1_t splat_m1(T x) { return __riscv_vfmv_v_f_f##SEW##m1(x, 1); }   \
+    static T first(m1_t v) { return __riscv_vfmv_f_s_f##SEW##m1_f##SEW(v); }  \
+  };
+
+#define RVV_INT_OPS(T, TYPE, LETTER, SEW, LMUL, MLEN)                         \
+  template <>                                                                 \
+  struct RvvOps<T, LMUL> {                                                    \
+    RVV_COMMON_OPS(T, TYPE, LETTER, SEW, LMUL, MLEN)                          \
+    using uvec_t = vuint##SEW##m##LMUL##_t;                                   \
+    static uvec_t as_unsigned(vec_t v) {                                      \
+      return __riscv_vreinterpret_v_##LETTER##SEW##m##LMUL##_u##SEW##m##LMUL(v); \
+    }                                                                         \
+    static uvec_t lane_index(size_t vl) {                                     \
+      return __riscv_vid_v_u##SEW##m##LMUL(vl);                               \
+    }                                                                         \
+    static vec_t splat(T x, size_t vl) {                                      \
+      return __riscv_vmv_v_x_##LETTER##SEW##m##LMUL(x, vl);                   \
+    }                                                                         \
+    static m1_t splat_m1(T x) {                                               \
+      return __riscv_vmv_v_x_##LETTER##SEW##m1(x, 1);                         \
+    }                                                                         \
+    static T first(m1_t v) {                                                  \
+      return __riscv_vmv_x_s_##LETTER##SEW##m1_##LETTER##SEW(v);              \
+    }                                                                         \
+  };
+
+// Bytes, e.g. the data buffer of a string column; loads and masks only.
+#define RVV_BYTE_OPS(LMUL, MLEN)                                              \
+  template <>                                                                 \
+  struct RvvOps<uint8_t, LMUL> {                                              \
+    RVV_COMMON_OPS(uint8_t, uint, u, 8, LMUL, MLEN)                           \
+  };
+
+RVV_FLOAT_OPS(float, 32, 1, 32)
+RVV_FLOAT_OPS(float, 32, 2, 16)
+RVV_FLOAT_OPS(float, 32, 4, 8)
+RVV_FLOAT_OPS(float, 32, 8, 4)
+RVV_FLOAT_OPS(double, 64, 1, 64)
+RVV_FLOAT_OPS(double, 64, 2, 32)
+RVV_FLOAT_OPS(double, 64, 4, 16)
+RVV_FLOAT_OPS(double, 64, 8, 8)
+RVV_INT_OPS(int32_t, int, i, 32, 1, 32)
+RVV_INT_OPS(int32_t, int, i, 32, 2, 16)
+RVV_INT_OPS(int32_t, int, i, 32, 4, 8)
+RVV_INT_OPS(int32_t, int, i, 32, 8, 4)
+RVV_INT_OPS(int64_t, int, i, 64, 1, 64)
+RVV_INT_OPS(int64_t, int, i, 64, 2, 32)
+RVV_INT_OPS(int64_t, int, i, 64, 4, 16)
+RVV_INT_OPS(int64_t, int, i, 64, 8, 8)
+RVV_BYTE_OPS(1, 8)
+RVV_BYTE_OPS(2, 4)
+RVV_BYTE_OPS(4, 2)
+RVV_BYTE_OPS(8, 1)
+
+#undef RVV_BYTE_OPS
+#undef RVV_INT_OPS
+#undef RVV_FLOAT_OPS
+#undef RVV_COMMON_OPS
+
+// Byte gathers through 32-bit byte offsets, e.g. the first character of
+// each string of an Arrow string column. The uint8 vector has a quarter of
+// the LMUL of the offsets; results are zero-extended back to uint32 and
+// lanes outside m read as 0.
+template <int LMUL>
+struct ByteGather;
+
+#define RVV_BYTE_GATHER(LMUL, BYTE_LMUL, MLEN)                                \
+  template <>                                                                 \
+  struct ByteGather<LMUL> {                                                   \
+    using vec_t = vuint32m##LMUL##_t;                                         \
+    static vec_t gather(vbool##MLEN##_t m, const uint8_t* base,               \
+                        vec_t offsets, size_t vl) {                           \
+      auto v_bytes = __riscv_vluxei32_v_u8##BYTE_LMUL##_mu(                   \
+          m, __riscv_vmv_v_x_u8##BYTE_LMUL(0, vl), base, offsets, vl);        \
+      return __riscv_vzext_vf4(v_bytes, vl);                                  \
+    }                                                                         \
+  };
+
+RVV_BYTE_GATHER(1, mf4, 32)
+RVV_BYTE_GATHER(2, mf2, 16)
+RVV_BYTE_GATHER(4, m1, 8)
+RVV_BYTE_GATHER(8, m2, 4)
+
+#undef RVV_BYTE_GATHER
+
+// A mask register never holds more than VLEN bits; VLEN <= 65536.
+constexpr size_t kMaxMaskBytes = 65536 / 8;
+
+// Copies nbits from src (starting at bit 0) into dst starting at bit dst_pos.
+// Bits of dst outside [dst_pos, dst_pos + nbits) are left untouched.
+inline void copy_bits_to(const uint8_t* src, uint8_t* dst, size_t dst_pos,
+                         size_t nbits) {
+  uint8_t* out = dst + dst_pos / 8;
+  unsigned shift = dst_pos & 7;
+  size_t nbytes = (nbits + 7) / 8;
+  for (size_t j = 0; j < nbytes; j++) {
+    size_t cnt = nbits - j * 8 < 8 ? nbits - j * 8 : 8;
+    unsigned keep = (1u << cnt) - 1;
+    unsigned value = src[j] & keep;
+    unsigned lo_mask = (keep << shift) & 0xFF;
+    out[j] = static_cast<uint8_t>((out[j] & ~lo_mask) | ((value << shift) & 0xFF));
+    if (shift != 0 && (keep >> (8 - shift)) != 0) {
+      unsigned hi_mask = keep >> (8 - shift);
+      out[j + 1] = static_cast<uint8_t>((out[j + 1] & ~hi_mask) |
+                                        (value >> (8 - shift)));
+    }
+  }
+}
+
+// Copies nbits from src starting at bit src_pos into dst starting at bit 0.
+inline void copy_bits_from(const uint8_t* src, size_t src_pos, uint8_t* dst,
+                           size_t nbits) {
+  const uint8_t* in = src + src_pos / 8;
+  unsigned shift = src_pos & 7;
+  size_t nbytes = (nbits + 7) / 8;
+  size_t src_bytes = (shift + nbits + 7) / 8;
+  for (size_t j = 0; j < nbytes; j++) {
+    unsigned value = in[j] >> shift;
+    if (shift != 0 && j + 1 < src_bytes) {
+      value |= static_cast<unsigned>(in[j + 1]) << (8 - shift);
+    }
+    dst[j] = static_cast<uint8_t>(value);
+  }
+}
+
+// Writes the first vl lanes of m to bits [bit_pos, bit_pos + vl) of bitmap.
+// The direct vsm path needs a byte-aligned position and a whole number of
+// bytes; anything else goes through a scratch buffer so that neighbouring
+// bits (and the agnostic mask tail) never leak into the output.
+template <typename Ops>
+inline void store_mask_bits(uint8_t* bitmap, size_t bit_pos,
+                            typename Ops::mask_t m, size_t vl) {
+  if ((bit_pos & 7) == 0 && (vl & 7) == 0) {
+    Ops::store_mask(bitmap + bit_pos / 8, m, vl);
+    return;
+  }
+  uint8_t tmp[kMaxMaskBytes];
+  Ops::store_mask(tmp, m, vl);
+  copy_bits_to(tmp, bitmap, bit_pos, vl);
+}
+
+// Loads bits [bit_pos, bit_pos + vl) of bitmap as a mask register.
+template <typename Ops>
+inline typename Ops::mask_t load_mask_bits(const uint8_t* bitmap,
+                                           size_t bit_pos, size_t vl) {
+  if ((bit_pos & 7) == 0) {
+    return Ops::load_mask(bitmap + bit_pos / 8, vl);
+  }
+  uint8_t tmp[kMaxMaskBytes];
+  copy_bits_from(bitmap, bit_pos, tmp, vl);
+  return Ops::load_mask(tmp, vl);
+}
+
+}  // namespace detail
+}  // namespace rvv
@@ -0,0 +1,142 @@
+#include "scan_queries.h"
+
+#include <arrow/result.h>
+#include <arrow/status.h>
+
+#include "date_util.h"
+#include "join_table.h"
+#include "operators.h"
+#include "parquet_scan.h"
+#include "query_options.h"
+#include "query_profile.h"
+#include "rvv_kernels.h"
+#include "shared_scan.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using arrow::Status;
+
+namespace {
+
+// Date filters on l_receiptdate
+constexpr int32_t kStartDate = date_literal("1994-01-01");
+constexpr int32_t kEndDate = date_literal("1995-01-01");
+
+// Target ship modes; lines keep the index of theirs as their group
+const std::vector<std::string> kTargetShipmodes = {"MAIL", "SHIP"};
+
+}  // namespace
+
+// The lineitem plan collects the qualifying MAIL / SHIP lines and publishes
+// their orderkeys as a runtime filter. The orders scan after it skips row
+// groups without any of those keys and builds o_orderkey -> whether
+// o_orderpriority is 1-URGENT or 2-HIGH only for the candidate orders; one
+// batched probe then gives every line its priority.
+std::unique_ptr<ScanQuery> MakeQuery12(
+    const std::string& orders_file, const QueryOptions& options,
+    std::shared_ptr<parquet::FileMetaData> orders_metadata) {
+    ScanOptions scan_options;
+    scan_options.columns = {"l_orderkey", "l_shipmode", "l_shipdate", "l_commitdate", "l_receiptdate"};
+    scan_options.prune = {{"l_receiptdate", kStartDate, kEndDate - 1}};
+    scan_options.dictionary_columns = {"l_shipmode"};
+    auto plan = std::make_unique<Pipeline>(scan_options, options);
+    Pipeline* query = plan.get();
+
+    // 1. l_receiptdate >= '1994-01-01' AND l_receiptdate < '1995-01-01',
+    // implied by row group statistics inside that range
+    query->Add<Int32RangeFilter>("l_receiptdate", kStartDate, kEndDate)
+        ->ImpliedByPrune();
+    // 2. l_commitdate < l_receiptdate
+    query->Add<ColumnCompareFilter<int32_t, rvv::CmpOp::kLt>>("l_commitdate", "l_receiptdate");
+    // 3. l_shipdate < l_commitdate
+    query->Add<ColumnCompareFilter<int32_t, rvv::CmpOp::kLt>>("l_shipdate", "l_commitdate");
+    // 4. l_shipmode IN ('MAIL', 'SHIP'), once per dictionary entry
+    int shipmode = query->AddSlot();
+    query->Add<DictionaryFilter>(
+        "l_shipmode",
+        [](std::string_view mode) {
+            auto target = std::find(kTargetShipmodes.begin(), kTargetShipmodes.end(), mode);
+            return target == kTargetShipmodes.end()
+                       ? -1
+                       : static_cast<int32_t>(target - kTargetShipmodes.begin());
+        },
+        shipmode);
+    auto* candidates = query->Add<RuntimeFilter>("l_orderkey", shipmode);
+
+    InputOptions input = options.input;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    query->OnFinish([=](const ScanStats& stats) {
+        const std::vector<int64_t>& candidate_keys = candidates->keys();
+        const std::vector<int32_t>& candidate_modes = candidates->payloads();
+        std::cout << "Collected " << candidate_keys.size() << " candidate lines of "
+                  << candidates->filter().size() << " orders" << std::endl;
+
+        // 2. Scan only the orders the candidates can join with
+        JoinBuild priorities("o_orderkey", "o_orderpriority", [](std::string_view priority) {
+            return priority == "1-URGENT" || priority == "2-HIGH" ? 1 : 0;
+        });
+        priorities.FilterKeys(&candidates->filter());
+        ARROW_RETURN_NOT_OK(RunSharedScan(orders_file, {&priorities}, input,
+                                          query->num_workers(), orders_metadata));
+        const Int32JoinTable& order_is_high = priorities.table();
+        std::cout << "Loaded " << order_is_high.size() << " order priorities into a "
+                  << (order_is_high.dense() ? "direct-address" : "hash") << " table; skipped "
+                  << priorities.stats().row_groups_skipped << " of "
+                  << priorities.stats().num_row_groups << " orders row groups" << std::endl;
+
+        // 3. Look up all candidate priorities in one batched probe
+        PhaseTimer timer(Phase::kProbe);
+        std::vector<int32_t> priority_hits(candidate_keys.size());
+        order_is_high.Probe(candidate_keys.data(), candidate_keys.size(), priority_hits.data());
+
+        timer.Switch(Phase::kAggregate);
+        std::vector<int64_t> high_line_counts(kTargetShipmodes.size(), 0);
+        std::vector<int64_t> low_line_counts(kTargetShipmodes.size(), 0);
+        for (size_t j = 0; j < candidate_keys.size(); j++) {
+            if (priority_hits[j] == Int32JoinTable::kMissing) continue;
+
+            std::vector<int64_t>& counts = priority_hits[j] == 1 ? high_line_counts : low_line_counts;
+            counts[candidate_modes[j]]++;
+        }
+        timer.Stop();
+
+        auto end_time = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> elapsed = end_time - start_time;
+
+        // Print results, in ship mode order
+        std::cout << "\nTPC-H Query 12 Results (RVV-accelerated):" << std::endl;
+        std::cout << "---------------------------------------" << std::endl;
+        std::cout << std::setw(15) << "L_SHIPMODE"
+                  << std::setw(20) << "HIGH_LINE_COUNT"
+                  << std::setw(20) << "LOW_LINE_COUNT" << std::endl;
+
+        int64_t rows_qualified = 0;
+        for (size_t m = 0; m < kTargetShipmodes.size(); m++) {
+            int64_t lines = high_line_counts[m] + low_line_counts[m];
+            if (lines == 0) continue;
+
+            std::cout << std::setw(15) << kTargetShipmodes[m]
+                      << std::setw(20) << high_line_counts[m]
+                      << std::setw(20) << low_line_counts[m] << std::endl;
+            QueryProfile::Global().AddRow({kTargetShipmodes[m],
+                                           ResultField(high_line_counts[m]),
+                                           ResultField(low_line_counts[m])});
+            rows_qualified += lines;
+        }
+
+        std::cout << "\nQuery executed in " << elapsed.count() << " seconds" << std::endl;
+        std::cout << "Processed " << stats.rows_read << " lineitem rows, " << rows_qualified << " qualified" << std::endl;
+        std::cout << "Skipped " << stats.row_groups_skipped << " of "
+                  << stats.num_row_groups << " lineitem row groups by statistics" << std::endl;
+        return Status::OK();
+    });
+    return plan;
+}
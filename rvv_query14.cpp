@@ -0,0 +1,39 @@
+#include <arrow/status.h>
+
+#include "parallel_scan.h"
+#include "query_options.h"
+#include "query_profile.h"
+#include "scan_queries.h"
+#include "shared_scan.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+using arrow::Status;
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " <part_parquet> <lineitem_parquet> "
+              << QueryOptionsUsage() << std::endl;
+    return 1;
+  }
+
+  std::string part_file = argv[1];
+  std::string lineitem_file = argv[2];
+  QueryOptions options;
+  Status st = ParseQueryOptions(argc, argv, 3, &options);
+  if (st.ok()) {
+    std::unique_ptr<ScanQuery> query = MakeQuery14(part_file, options);
+    st = RunSharedScan(lineitem_file, {query.get()}, options.input,
+                       ResolveThreadCount(options.num_threads));
+  }
+
+  if (!st.ok()) {
+    std::cerr << "Error: " << st.ToString() << std::endl;
+    return 1;
+  }
+
+  WriteProfile();
+  return 0;
+}
@@ -0,0 +1,115 @@
+#include "scan_queries.h"
+
+#include <arrow/result.h>
+#include <arrow/status.h>
+
+#include "date_util.h"
+#include "fixed_point.h"
+#include "operators.h"
+#include "parquet_scan.h"
+#include "query_options.h"
+#include "query_profile.h"
+#include "shared_scan.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+using arrow::Status;
+
+namespace {
+
+// l_shipdate >= DATE '1995-09-01' AND l_shipdate < DATE '1995-10-01'
+constexpr int32_t kStartDay = date_literal("1995-09-01");
+constexpr int32_t kEndDay = date_literal("1995-10-01");
+
+// 100 * promo / total with two decimals, NULL without any joined line. A
+// zero total over some lines is a division by zero in either mode.
+arrow::Result<std::string> PromoRevenue(
+    const Sum<SumExpr::kMulOneMinus>& revenue, AggMode mode) {
+  if (revenue.count(0) + revenue.count(1) == 0) {
+    return std::string("NULL");
+  }
+  bool zero_total = mode == AggMode::kExact
+                        ? revenue.exact(0) + revenue.exact(1) == 0
+                        : revenue.approx(0) + revenue.approx(1) == 0.0;
+  if (zero_total) {
+    return Status::Invalid("Division by zero: total revenue is 0");
+  }
+  if (mode == AggMode::kExact) {
+    Int128 promo = revenue.exact(1);
+    Int128 total = revenue.exact(0) + promo;
+    // Both sums have the same scale, so it cancels out
+    Int128 percent = (100 * promo * pow10_int128(2) + total / 2) / total;
+    return format_fixed(percent, 2, 2);
+  }
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(2)
+      << 100.0 * revenue.approx(1) / (revenue.approx(0) + revenue.approx(1));
+  return out.str();
+}
+
+}  // namespace
+
+std::unique_ptr<ScanQuery> MakeQuery14(const std::string& part_file,
+                                       const QueryOptions& options) {
+  ScanOptions scan_options;
+  scan_options.columns = {"l_partkey", "l_shipdate", "l_extendedprice",
+                          "l_discount"};
+  scan_options.prune = {{"l_shipdate", kStartDay, kEndDay - 1}};
+  auto plan = std::make_unique<Pipeline>(scan_options, options);
+  Pipeline* query = plan.get();
+
+  // part: p_partkey -> whether p_type LIKE 'PROMO%', once per dictionary
+  // entry
+  JoinBuild* promo_parts = query->AddBuild(
+      part_file, std::make_unique<JoinBuild>(
+                     "p_partkey", "p_type", [](std::string_view type) {
+                       return type.substr(0, 5) == "PROMO" ? 1 : 0;
+                     }));
+
+  query->Add<Int32RangeFilter>("l_shipdate", kStartDay, kEndDay)
+      ->ImpliedByPrune();
+  int promo = query->AddSlot();
+  query->Add<JoinProbe>(promo_parts, "l_partkey", promo);
+  int price = query->AddSlot();
+  int discount = query->AddSlot();
+  query->Add<ProjectDecimal>("l_extendedprice", price, options.agg_mode);
+  query->Add<ProjectDecimal>("l_discount", discount, options.agg_mode);
+  // l_extendedprice * (1 - l_discount), grouped by promo (0 / 1)
+  auto* revenue =
+      query->Add<Sum<SumExpr::kMulOneMinus>>(options.agg_mode, price, discount)
+          ->GroupBy(promo, 2);
+
+  AggMode mode = options.agg_mode;
+  auto start_time = std::chrono::high_resolution_clock::now();
+  query->OnFinish([query, revenue, mode, start_time](const ScanStats& stats) {
+    std::cout << "Scanned " << stats.rows_read << " rows with "
+              << query->num_workers() << " threads; skipped "
+              << stats.row_groups_skipped << " of "
+              << stats.num_row_groups << " row groups by statistics."
+              << std::endl;
+    std::cout << "Joined " << revenue->count(0) + revenue->count(1)
+              << " rows." << std::endl;
+
+    std::string promo_text;
+    ARROW_ASSIGN_OR_RAISE(promo_text, PromoRevenue(*revenue, mode));
+    std::cout << "\nTPC-H Query 14 Result (with RVV 1.0 optimization):\n";
+    std::cout << "----------------------------------------------\n";
+    std::cout << "PROMO_REVENUE\n";
+    std::cout << "-------------\n";
+    std::cout << promo_text << std::endl;
+    QueryProfile::Global().AddRow({promo_text});
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = end_time - start_time;
+    std::cout << "\nQuery executed in " << elapsed.count() << " seconds"
+              << std::endl;
+    return Status::OK();
+  });
+  return plan;
+}
@@ -0,0 +1,332 @@
+#include "scan_queries.h"
+
+#include <arrow/api.h>
+#include <arrow/result.h>
+#include <arrow/status.h>
+
+#include "date_util.h"
+#include "fixed_point.h"
+#include "operators.h"
+#include "parquet_scan.h"
+#include "query_options.h"
+#include "query_profile.h"
+#include "rvv_dispatch.h"
+#include "rvv_kernels.h"
+#include "shared_scan.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <iomanip> // For std::setw, std::fixed, std::setprecision
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// One output row of Q1, already formatted for printing
+struct Query1Row {
+  std::string returnflag;
+  std::string linestatus;
+  std::string sum_qty;
+  std::string sum_base_price;
+  std::string sum_disc_price;
+  std::string sum_charge;
+  std::string avg_qty;
+  std::string avg_price;
+  std::string avg_disc;
+  size_t count_order = 0;
+};
+
+using GroupKey = std::pair<std::string, std::string>;
+
+// Aggregates of one group. Only the sums of the selected AggMode are
+// updated; exact sums are unscaled decimal values.
+struct Query1Group {
+  rvv::Q1Sums exact;
+  rvv::Q1SumsFloat approx;
+};
+
+// Adds the partial aggregates of another worker
+void MergeGroup(const Query1Group &from, Query1Group *into) {
+  into->exact.count += from.exact.count;
+  into->exact.qty += from.exact.qty;
+  into->exact.price += from.exact.price;
+  into->exact.disc += from.exact.disc;
+  into->exact.disc_price += from.exact.disc_price;
+  into->exact.charge += from.exact.charge;
+  into->approx.count += from.approx.count;
+  into->approx.qty += from.approx.qty;
+  into->approx.price += from.approx.price;
+  into->approx.disc += from.approx.disc;
+  into->approx.disc_price += from.approx.disc_price;
+  into->approx.charge += from.approx.charge;
+}
+
+int64_t GroupCount(const Query1Group &group) {
+  return group.exact.count + group.approx.count;
+}
+
+// Column order of the decimal inputs below
+enum { kQuantity, kPrice, kDiscount, kTax, kNumDecimals };
+
+const char *const kDecimalColumns[kNumDecimals] = {
+    "l_quantity", "l_extendedprice", "l_discount", "l_tax"};
+
+std::string format_float(double value) {
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(2) << value;
+  return out.str();
+}
+
+int32_t decimal_scale(const arrow::Array &array) {
+  return static_cast<const arrow::DecimalType &>(*array.type()).scale();
+}
+
+Query1Row FormatFloat(const GroupKey &key, const rvv::Q1SumsFloat &group) {
+  Query1Row row;
+  row.returnflag = key.first;
+  row.linestatus = key.second;
+  row.sum_qty = format_float(group.qty);
+  row.sum_base_price = format_float(group.price);
+  row.sum_disc_price = format_float(group.disc_price);
+  row.sum_charge = format_float(group.charge);
+  row.avg_qty = format_float(group.qty / group.count);
+  row.avg_price = format_float(group.price / group.count);
+  row.avg_disc = format_float(group.disc / group.count);
+  row.count_order = group.count;
+  return row;
+}
+
+Query1Row FormatExact(const GroupKey &key, const rvv::Q1Sums &group,
+                      const int32_t (&scales)[kNumDecimals]) {
+  const int qty_scale = scales[kQuantity];
+  const int price_scale = scales[kPrice];
+  const int disc_scale = scales[kDiscount];
+  const int tax_scale = scales[kTax];
+
+  Query1Row row;
+  row.returnflag = key.first;
+  row.linestatus = key.second;
+  row.sum_qty = format_fixed(group.qty, qty_scale, 2);
+  row.sum_base_price = format_fixed(group.price, price_scale, 2);
+  row.sum_disc_price =
+      format_fixed(group.disc_price, price_scale + disc_scale, 2);
+  row.sum_charge =
+      format_fixed(group.charge, price_scale + disc_scale + tax_scale, 2);
+  row.avg_qty = format_fixed(group.qty, qty_scale, 2, group.count);
+  row.avg_price = format_fixed(group.price, price_scale, 2, group.count);
+  row.avg_disc = format_fixed(group.disc, disc_scale, 2, group.count);
+  row.count_order = group.count;
+  return row;
+}
+
+// Inverse of rvv::char_pair_codes
+GroupKey DecodeGroupKey(int32_t code) {
+  auto text = [](int32_t byte) {
+    return byte == 0 ? std::string() : std::string(1, static_cast<char>(byte));
+  };
+  return {text(code >> 8), text(code & 0xFF)};
+}
+
+// l_shipdate <= '1998-09-02'
+constexpr int32_t kCutoffDate = date_literal("1998-09-02");
+
+// (l_returnflag, l_linestatus) has four combinations in TPC-H data
+constexpr int kMaxGroups = 64;
+
+// The fused Q1 kernel as the plan's aggregate. One strip-mined pass over the
+// raw columns applies the shipdate predicate and the chunk's selection
+// (its null rows) as a mask and adds every SUM and COUNT into the group of
+// the row, with the per-row ids of a PairGroupBy that ran before it. Nothing
+// per row is written to memory, so it must come before any projection.
+class Query1Aggregate : public Operator {
+ public:
+  Query1Aggregate(const PairGroupBy *groups, AggMode mode)
+      : groups_(groups), mode_(mode) {}
+
+  arrow::Status Start(const ParquetScanner &, int num_workers) override {
+    // Thread-local aggregates, merged once the scan is done
+    workers_ = std::vector<Worker>(num_workers);
+    for (auto &worker : workers_) {
+      if (mode_ == AggMode::kExact) {
+        worker.exact.resize(groups_->max_groups());
+      } else {
+        worker.approx.resize(groups_->max_groups());
+      }
+    }
+    return arrow::Status::OK();
+  }
+
+  arrow::Status Push(Chunk &chunk) override {
+    if (chunk.selected()) {
+      return arrow::Status::Invalid(
+          "The fused Q1 aggregate must come before any projection");
+    }
+    Worker &worker = workers_[chunk.worker()];
+    const arrow::Array *shipdate;
+    ARROW_ASSIGN_OR_RAISE(shipdate, chunk.column("l_shipdate"));
+    rvv::Q1Input in;
+    ARROW_ASSIGN_OR_RAISE(in.shipdate, FixedWidthValues<int32_t>(*shipdate));
+    const uint8_t *decimals[kNumDecimals];
+    for (int c = 0; c < kNumDecimals; c++) {
+      const arrow::Array *column;
+      ARROW_ASSIGN_OR_RAISE(column, chunk.column(kDecimalColumns[c]));
+      if (column->type_id() != arrow::Type::DECIMAL128) {
+        return arrow::Status::TypeError("Expected decimal128 column, got ",
+                                        column->type()->ToString());
+      }
+      decimals[c] =
+          static_cast<const arrow::Decimal128Array &>(*column).raw_values();
+      worker.scales[c] = decimal_scale(*column);
+    }
+    worker.summed = true;
+    // Row groups entirely before the cutoff need no predicate at all
+    in.cutoff = chunk.all_match() ? INT32_MAX : kCutoffDate;
+    in.selection = chunk.selection();
+    in.group_ids = chunk.values<int32_t>(groups_->slot());
+    in.quantity = decimals[kQuantity];
+    in.price = decimals[kPrice];
+    in.discount = decimals[kDiscount];
+    in.tax = decimals[kTax];
+    in.quantity_scale = worker.scales[kQuantity];
+    in.price_scale = worker.scales[kPrice];
+    in.discount_scale = worker.scales[kDiscount];
+    in.tax_scale = worker.scales[kTax];
+
+    size_t num_rows = chunk.num_rows();
+    PhaseTimer timer(Phase::kAggregate);
+    // shipdate, group id and the four decimals of every row
+    timer.Count(num_rows,
+                num_rows * (2 * sizeof(int32_t) +
+                            kNumDecimals * arrow::Decimal128Type::kByteWidth));
+    return rvv::with_lmul<4>(rvv::KernelClass::kFused, [&](auto lmul) {
+      constexpr int L = decltype(lmul)::value;
+      if (mode_ == AggMode::kExact) {
+        if (!rvv::q1_aggregate_exact<L>(in, num_rows, worker.exact.data(),
+                                        worker.exact.size())) {
+          return arrow::Status::Invalid(
+              "Decimal value out of int32 range for exact aggregation; "
+              "rerun with --agg=float");
+        }
+      } else if (!rvv::q1_aggregate_float<L>(in, num_rows,
+                                             worker.approx.data(),
+                                             worker.approx.size())) {
+        return arrow::Status::Invalid("Decimal value out of int64 range");
+      }
+      return arrow::Status::OK();
+    });
+  }
+
+  arrow::Status Finish() override {
+    PhaseTimer timer(Phase::kAggregate);
+    totals_.assign(groups_->num_groups(), Query1Group());
+    for (size_t w = 0; w < workers_.size(); w++) {
+      const Worker &worker = workers_[w];
+      for (int g = 0; g < groups_->max_groups(); g++) {
+        int group = groups_->group(static_cast<int>(w), g);
+        if (group < 0) {
+          continue;
+        }
+        Query1Group partial;
+        if (!worker.exact.empty()) {
+          partial.exact = worker.exact[g];
+        }
+        if (!worker.approx.empty()) {
+          partial.approx = worker.approx[g];
+        }
+        MergeGroup(partial, &totals_[group]);
+      }
+      if (worker.summed) {
+        std::copy(std::begin(worker.scales), std::end(worker.scales), scales_);
+      }
+    }
+    return arrow::Status::OK();
+  }
+
+  // After Finish(), by the group ids of the PairGroupBy
+  const Query1Group &group(int g) const { return totals_[g]; }
+  const int32_t (&scales() const)[kNumDecimals] { return scales_; }
+
+ private:
+  struct Worker {
+    // One entry per id of the PairGroupBy, in the vector of the mode
+    std::vector<rvv::Q1Sums> exact;
+    std::vector<rvv::Q1SumsFloat> approx;
+    int32_t scales[kNumDecimals] = {};
+    bool summed = false;
+  };
+
+  const PairGroupBy *groups_;
+  AggMode mode_;
+  std::vector<Worker> workers_;
+  std::vector<Query1Group> totals_;
+  int32_t scales_[kNumDecimals] = {};
+};
+
+}  // namespace
+
+// Group ids come from a PairGroupBy over every row; the fused aggregate
+// filters, decodes and sums in its single pass, so no row is compacted or
+// decoded into a slot.
+std::unique_ptr<ScanQuery> MakeQuery1(const QueryOptions &options) {
+  ScanOptions scan_options;
+  scan_options.columns = {"l_shipdate", "l_returnflag", "l_linestatus"};
+  scan_options.columns.insert(scan_options.columns.end(),
+                              std::begin(kDecimalColumns),
+                              std::end(kDecimalColumns));
+  scan_options.prune = {{"l_shipdate", INT32_MIN, kCutoffDate}};
+  auto plan = std::make_unique<Pipeline>(scan_options, options);
+  Pipeline *query = plan.get();
+
+  auto *groups = query->Add<PairGroupBy>("l_returnflag", "l_linestatus",
+                                         query->AddSlot(), kMaxGroups);
+  auto *aggregate = query->Add<Query1Aggregate>(groups, options.agg_mode);
+
+  // The timer covers the scan: decoding is part of the query now
+  AggMode mode = options.agg_mode;
+  auto start_time = std::chrono::high_resolution_clock::now();
+  query->OnFinish([groups, aggregate, mode, start_time](const ScanStats &) {
+    // Groups are numbered by key, i.e. ORDER BY l_returnflag, l_linestatus
+    std::vector<Query1Row> rows;
+    for (int g = 0; g < groups->num_groups(); g++) {
+      const Query1Group &group = aggregate->group(g);
+      if (GroupCount(group) == 0) {
+        continue;
+      }
+      GroupKey key = DecodeGroupKey(groups->code(g));
+      rows.push_back(mode == AggMode::kExact
+                         ? FormatExact(key, group.exact, aggregate->scales())
+                         : FormatFloat(key, group.approx));
+    }
+
+    // Print header in SQL-like format
+    std::cout << "\nL_RETURNFLAG | L_LINESTATUS | SUM_QTY | SUM_BASE_PRICE | SUM_DISC_PRICE | SUM_CHARGE | AVG_QTY | AVG_PRICE | AVG_DISC | COUNT_ORDER\n";
+    std::cout << "------------|-------------|---------|---------------|---------------|-----------|---------|-----------|----------|------------\n";
+
+    for (const auto &row : rows) {
+      // Print in SQL-like format with proper alignment
+      std::cout << std::setw(12) << row.returnflag << " | " << std::setw(11)
+                << row.linestatus << " | " << std::setw(7) << row.sum_qty
+                << " | " << std::setw(13) << row.sum_base_price << " | "
+                << std::setw(13) << row.sum_disc_price << " | " << std::setw(9)
+                << row.sum_charge << " | " << std::setw(7) << row.avg_qty
+                << " | " << std::setw(9) << row.avg_price << " | "
+                << std::setw(8) << row.avg_disc << " | " << std::setw(10)
+                << row.count_order << "\n";
+      QueryProfile::Global().AddRow(
+          {row.returnflag, row.linestatus, row.sum_qty, row.sum_base_price,
+           row.sum_disc_price, row.sum_charge, row.avg_qty, row.avg_price,
+           row.avg_disc, ResultField(row.count_order)});
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = end_time - start_time;
+    std::cout << "\nQuery executed in " << elapsed.count() << " seconds" << std::endl;
+
+    return arrow::Status::OK();
+  });
+  return plan;
+}
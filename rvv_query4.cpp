@@ -1,186 +1,292 @@
 #include <arrow/api.h>
-#include <arrow/compute/api.h>
-#include <arrow/compute/api_scalar.h>
-#include <arrow/io/api.h>
 #include <arrow/result.h>
 #include <arrow/status.h>
 #include <arrow/table.h>
-#include <arrow/util/thread_pool.h>
-#include <parquet/arrow/reader.h>
-#include <parquet/arrow/writer.h>
 
-#include <riscv_vector.h>
+#include "chunked_dispatch.h"
+#include "date_util.h"
+#include "join_cache.h"
+#include "join_table.h"
+#include "semi_join_filter.h"
+#include "parquet_scan.h"
+#include "query_options.h"
+#include "query_profile.h"
+#include "rvv_dispatch.h"
+#include "rvv_kernels.h"
 
 #include <chrono>
 #include <iostream>
+#include <map>
 #include <memory>
-#include <unordered_set>
+#include <string>
+#include <string_view>
 #include <vector>
-#include <ctime>
 
 using arrow::Status;
 
-// commitdate < receiptdate
+// Sets bit (out_offset + i) of results to commitdate[i] < receiptdate[i]
 void check_late_delivery_rvv(const int32_t* commitdates, const int32_t* receiptdates,
-                            uint8_t* results, size_t length) {
-  size_t i = 0;
-  
-  size_t vl;
-  
-  for (; i < length; i += vl) {
-    vl = __riscv_vsetvl_e32m8(length - i);
+                            uint8_t* results, size_t out_offset, size_t length) {
+  rvv::with_lmul(rvv::KernelClass::kCompare, [&](auto lmul) {
+    rvv::compare_bitmap<int32_t, rvv::CmpOp::kLt, decltype(lmul)::value>(
+        commitdates, receiptdates, results, out_offset, length);
+  });
+}
+
+// o_orderdate >= '1993-07-01' and < '1993-10-01'
+constexpr int32_t kStartDay = date_literal("1993-07-01");
+constexpr int32_t kEndDay = date_literal("1993-10-01");
+
+const std::vector<std::string> kOrdersColumns = {"o_orderkey", "o_orderdate",
+                                                 "o_orderpriority"};
+
+// Build side: the orders of the quarter; kept across runs in the join cache
+struct Query4Orders {
+  SemiJoinFilter quarter_order_keys;
+  // orderkey -> slot
+  Int32JoinTable order_slots;
+  // slot -> index into priority_names
+  std::vector<int32_t> slot_priority;
+  std::vector<std::string> priority_names;
+
+  void Save(JoinCacheWriter& out) const {
+    quarter_order_keys.Save(out);
+    order_slots.Save(out);
+    out.Array(slot_priority);
+    out.Strings(priority_names);
+  }
+
+  bool Load(JoinCacheReader& in) {
+    return quarter_order_keys.Load(in) && order_slots.Load(in) &&
+           in.Array(&slot_priority) && in.Strings(&priority_names);
+  }
+};
+
+Status BuildQuery4Orders(const std::string& orders_file,
+                         const InputOptions& input, Query4Orders* orders) {
+  SemiJoinFilter& quarter_order_keys = orders->quarter_order_keys;
+  Int32JoinTable& order_slots = orders->order_slots;
+  std::vector<int32_t>& slot_priority = orders->slot_priority;
+  std::vector<std::string>& priority_names = orders->priority_names;
+  
+  ScanOptions orders_options;
+  orders_options.columns = kOrdersColumns;
+  orders_options.prune = {{"o_orderdate", kStartDay, kEndDay - 1}};
+  orders_options.dictionary_columns = {"o_orderpriority"};
+  orders_options.input = input;
+  std::unique_ptr<ParquetScanner> orders_scanner;
+  ARROW_ASSIGN_OR_RAISE(orders_scanner,
+                        ParquetScanner::Open(orders_file, orders_options));
+  
+  // Pass 1 (build): orders in the quarter. Their keys become a runtime
+  // filter for the lineitem scan; each one maps to a slot holding its
+  // priority and whether a late line was seen. Priorities are numbered in
+  // order of appearance; each batch maps its dictionary onto those codes.
+  quarter_order_keys = SemiJoinFilter::ForColumn(
+      *orders_scanner, "o_orderkey", orders_scanner->num_rows());
+  order_slots =
+      Int32JoinTable::ForColumn(*orders_scanner, "o_orderkey");
+  std::map<std::string, int32_t> priority_codes;
+  std::vector<uint8_t> in_range_mask;
+  std::vector<int32_t> batch_priorities;
+  
+  while (true) {
+    std::shared_ptr<arrow::RecordBatch> batch;
+    ARROW_ASSIGN_OR_RAISE(batch, orders_scanner->Next());
+    if (!batch) {
+      break;
+    }
+    
+    PhaseTimer timer(Phase::kFilter);
+    auto order_keys = std::static_pointer_cast<arrow::Int64Array>(
+        batch->GetColumnByName("o_orderkey"));
+    auto order_dates = std::static_pointer_cast<arrow::Date32Array>(
+        batch->GetColumnByName("o_orderdate"));
+    auto order_priorities = batch->GetColumnByName("o_orderpriority");
     
-    vint32m8_t v_commit = __riscv_vle32_v_i32m8(commitdates + i, vl);
-    vint32m8_t v_receipt = __riscv_vle32_v_i32m8(receiptdates + i, vl);
+    int64_t num_rows = batch->num_rows();
+    size_t num_bytes = (num_rows + 7) / 8;
+    
+    // Row groups whose o_orderdate statistics lie inside the quarter need no
+    // date predicate
+    if (orders_scanner->current_all_match()) {
+      in_range_mask.assign(num_bytes, 0xFF);
+    } else {
+      in_range_mask.assign(num_bytes, 0);
+      const rvv::Int32Term terms[] = {
+          {rvv::CmpOp::kGe, order_dates->raw_values(), nullptr, kStartDay},
+          {rvv::CmpOp::kLt, order_dates->raw_values(), nullptr, kEndDay},
+      };
+      rvv::with_lmul(rvv::KernelClass::kCompare, [&](auto lmul) {
+        rvv::conjunction_bitmap<decltype(lmul)::value>(
+            terms, 2, in_range_mask.data(), 0, num_rows);
+      });
+      timer.Count(num_rows, num_rows * sizeof(int32_t));
+    }
+    for (const auto& column : batch->columns()) {
+      DropNulls(*column, in_range_mask.data());
+    }
     
-    vbool4_t v_mask = __riscv_vmslt_vv_i32m8_b4(v_commit, v_receipt, vl);
+    timer.Switch(Phase::kDecode);
+    batch_priorities.resize(num_rows);
+    ARROW_RETURN_NOT_OK(DictionaryLookup(
+        *order_priorities,
+        [&](std::string_view priority) {
+          auto code = priority_codes.emplace(
+              std::string(priority), static_cast<int32_t>(priority_names.size()));
+          if (code.second) {
+            priority_names.emplace_back(priority);
+          }
+          return code.first->second;
+        },
+        batch_priorities.data()));
     
-    for (size_t j = 0; j < vl; j++) {
-      size_t idx = i + j;
-      size_t byte_index = idx / 8;
-      size_t bit_index = idx % 8;
-      
-      if (commitdates[i + j] < receiptdates[i + j]) {
-        results[byte_index] |= (1 << bit_index);
+    timer.Switch(Phase::kJoinBuild);
+    for (int64_t i = 0; i < num_rows; ++i) {
+      if ((in_range_mask[i / 8] & (1 << (i % 8))) == 0) {
+        continue;
       }
+      int64_t orderkey = order_keys->Value(i);
+      quarter_order_keys.Insert(orderkey);
+      order_slots.Insert(orderkey, static_cast<int32_t>(slot_priority.size()));
+      slot_priority.push_back(batch_priorities[i]);
     }
   }
-}
-
-Status RunQuery4(const std::string& orders_file, const std::string& lineitem_file) {
-  arrow::MemoryPool* pool = arrow::default_memory_pool();
-  
-  auto thread_pool = arrow::internal::GetCpuThreadPool();
-  
-  std::cout << "Reading input files..." << std::endl;
   
-  std::shared_ptr<arrow::io::ReadableFile> orders_input;
-  ARROW_ASSIGN_OR_RAISE(orders_input, arrow::io::ReadableFile::Open(orders_file, pool));
+  std::cout << "Filtered ORDERS table has " << slot_priority.size()
+            << " rows within date range; skipped "
+            << orders_scanner->row_groups_skipped() << " of "
+            << orders_scanner->num_row_groups()
+            << " row groups by statistics." << std::endl;
   
-  std::unique_ptr<parquet::arrow::FileReader> orders_reader;
-  ARROW_ASSIGN_OR_RAISE(orders_reader, parquet::arrow::OpenFile(orders_input, pool));
+  return Status::OK();
+}
+
+Status RunQuery4(const std::string& orders_file, const std::string& lineitem_file,
+                 const QueryOptions& options) {
+  auto start_time = std::chrono::high_resolution_clock::now();
   
-  std::vector<int> orders_indices;
-  const auto& schema = orders_reader->parquet_reader()->metadata()->schema();
-  for (const auto& col_name : {"o_orderkey", "o_orderdate", "o_orderpriority"}) {
-    int col_idx = schema->ColumnIndex(col_name);
-    if (col_idx >= 0) {
-      orders_indices.push_back(col_idx);
-    } else {
-      return Status::Invalid("Column not found: ", col_name);
+  std::cout << "Scanning input files..." << std::endl;
+  
+  // Pass 1 (build), unless the join cache holds it for this file
+  JoinCache join_cache(options.join_cache_dir);
+  JoinCacheKey cache_key("q4_orders");
+  ARROW_RETURN_NOT_OK(cache_key.AddFile(orders_file, kOrdersColumns));
+  cache_key.Add("o_orderdate " + std::to_string(kStartDay) + " " +
+                std::to_string(kEndDay));
+  Query4Orders orders;
+  if (join_cache.Load(cache_key,
+                      [&](JoinCacheReader& in) { return orders.Load(in); })) {
+    std::cout << "Quarter orders loaded from the join cache: "
+              << orders.slot_priority.size() << " rows" << std::endl;
+  } else {
+    orders = Query4Orders();
+    ARROW_RETURN_NOT_OK(BuildQuery4Orders(orders_file, options.input, &orders));
+    Status st = join_cache.Store(
+        cache_key, [&](JoinCacheWriter& out) { orders.Save(out); });
+    if (!st.ok()) {
+      std::cerr << "Warning: join cache not written: " << st.ToString()
+                << std::endl;
     }
   }
-  
-  std::shared_ptr<arrow::Table> orders_table;
-  ARROW_RETURN_NOT_OK(orders_reader->ReadTable(orders_indices, &orders_table));
-  
-  std::cout << "Loaded ORDERS table with " << orders_table->num_rows() << " rows." << std::endl;
-  
-  std::shared_ptr<arrow::io::ReadableFile> lineitem_input;
-  ARROW_ASSIGN_OR_RAISE(lineitem_input, arrow::io::ReadableFile::Open(lineitem_file, pool));
-  
-  std::unique_ptr<parquet::arrow::FileReader> lineitem_reader;
-  ARROW_ASSIGN_OR_RAISE(lineitem_reader, parquet::arrow::OpenFile(lineitem_input, pool));
-  
-  std::vector<int> lineitem_indices;
-  const auto& lineitem_schema = lineitem_reader->parquet_reader()->metadata()->schema();
-  for (const auto& col_name : {"l_orderkey", "l_commitdate", "l_receiptdate"}) {
-    int col_idx = lineitem_schema->ColumnIndex(col_name);
-    if (col_idx >= 0) {
-      lineitem_indices.push_back(col_idx);
-    } else {
-      return Status::Invalid("Column not found: ", col_name);
+  const SemiJoinFilter& quarter_order_keys = orders.quarter_order_keys;
+  const Int32JoinTable& order_slots = orders.order_slots;
+  const std::vector<int32_t>& slot_priority = orders.slot_priority;
+  const std::vector<std::string>& priority_names = orders.priority_names;
+  
+  // Pass 2 (probe): lineitem, restricted to row groups whose l_orderkey
+  // range can hold a quarter order and then to rows the filter passes
+  ScanOptions lineitem_options;
+  lineitem_options.columns = {"l_orderkey", "l_commitdate", "l_receiptdate"};
+  lineitem_options.key_filters = {quarter_order_keys.ScanFilter("l_orderkey")};
+  lineitem_options.input = options.input;
+  std::unique_ptr<ParquetScanner> lineitem_scanner;
+  ARROW_ASSIGN_OR_RAISE(lineitem_scanner,
+                        ParquetScanner::Open(lineitem_file, lineitem_options));
+  
+  std::vector<uint8_t> slot_has_late(slot_priority.size(), 0);
+  // Per-batch selection bitmaps: late lines, and also of a quarter order
+  std::vector<uint8_t> late_delivery_mask;
+  std::vector<uint8_t> key_mask;
+  std::vector<int64_t> candidate_keys;
+  std::vector<int32_t> candidate_slots;
+  
+  while (true) {
+    std::shared_ptr<arrow::RecordBatch> batch;
+    ARROW_ASSIGN_OR_RAISE(batch, lineitem_scanner->Next());
+    if (!batch) {
+      break;
     }
-  }
-  
-  std::shared_ptr<arrow::Table> lineitem_table;
-  ARROW_RETURN_NOT_OK(lineitem_reader->ReadTable(lineitem_indices, &lineitem_table));
-  auto start_time = std::chrono::high_resolution_clock::now();
-  
-  auto orderdate_col = orders_table->GetColumnByName("o_orderdate");
-  
-  std::shared_ptr<arrow::Scalar> start_date, end_date;
-  auto date_type = arrow::date32();
-  ARROW_ASSIGN_OR_RAISE(start_date, arrow::Scalar::Parse(date_type, "1993-07-01"));
-  ARROW_ASSIGN_OR_RAISE(end_date, arrow::Scalar::Parse(date_type, "1993-10-01"));
-  
-  arrow::compute::CompareOptions ge_options(arrow::compute::CompareOperator::GREATER_EQUAL);
-  arrow::Datum filter1_datum;
-  ARROW_ASSIGN_OR_RAISE(filter1_datum, 
-      arrow::compute::CallFunction("greater_equal", {orderdate_col, start_date}));
-  
-  arrow::compute::CompareOptions lt_options(arrow::compute::CompareOperator::LESS);
-  arrow::Datum filter2_datum;
-  ARROW_ASSIGN_OR_RAISE(filter2_datum, 
-      arrow::compute::CallFunction("less", {orderdate_col, end_date}));
-  
-  arrow::Datum combined_filter;
-  ARROW_ASSIGN_OR_RAISE(combined_filter, 
-      arrow::compute::And(filter1_datum, filter2_datum));
-  
-  arrow::compute::FilterOptions filter_options;
-  arrow::Datum filtered_orders_datum;
-  ARROW_ASSIGN_OR_RAISE(filtered_orders_datum, 
-      arrow::compute::Filter(orders_table, combined_filter, filter_options));
-  
-  auto filtered_orders = filtered_orders_datum.table();
-  
-  std::cout << "Filtered ORDERS table has " << filtered_orders->num_rows() 
-            << " rows within date range." << std::endl;
-  
-  auto commit_col = lineitem_table->GetColumnByName("l_commitdate");
-  auto receipt_col = lineitem_table->GetColumnByName("l_receiptdate");
-  
-  auto commit_array = std::static_pointer_cast<arrow::Date32Array>(commit_col->chunk(0));
-  auto receipt_array = std::static_pointer_cast<arrow::Date32Array>(receipt_col->chunk(0));
-  
-  size_t num_lineitem_rows = lineitem_table->num_rows();
-  size_t num_bytes = (num_lineitem_rows + 7) / 8;
-  
-  std::vector<uint8_t> late_delivery_mask(num_bytes, 0);
-  
-  check_late_delivery_rvv(
-      commit_array->raw_values(), 
-      receipt_array->raw_values(),
-      late_delivery_mask.data(), 
-      num_lineitem_rows);
-  
-  auto lineitem_keys = std::static_pointer_cast<arrow::Int64Array>(
-      lineitem_table->GetColumnByName("l_orderkey")->chunk(0));
-  
-  std::unordered_set<int64_t> late_order_keys;
-  
-  for (size_t i = 0; i < num_lineitem_rows; ++i) {
-    size_t byte_index = i / 8;
-    size_t bit_index = i % 8;
-    bool is_late = (late_delivery_mask[byte_index] & (1 << bit_index)) != 0;
     
-    if (is_late) {
-      late_order_keys.insert(lineitem_keys->Value(i));
+    PhaseTimer timer(Phase::kFilter);
+    auto commit_array = std::static_pointer_cast<arrow::Date32Array>(
+        batch->GetColumnByName("l_commitdate"));
+    auto receipt_array = std::static_pointer_cast<arrow::Date32Array>(
+        batch->GetColumnByName("l_receiptdate"));
+    auto lineitem_keys = std::static_pointer_cast<arrow::Int64Array>(
+        batch->GetColumnByName("l_orderkey"));
+    
+    size_t num_lineitem_rows = batch->num_rows();
+    size_t num_bytes = (num_lineitem_rows + 7) / 8;
+    late_delivery_mask.assign(num_bytes, 0);
+    
+    check_late_delivery_rvv(
+        commit_array->raw_values(), 
+        receipt_array->raw_values(),
+        late_delivery_mask.data(),
+        0,
+        num_lineitem_rows);
+    DropNulls(*commit_array, late_delivery_mask.data());
+    DropNulls(*receipt_array, late_delivery_mask.data());
+    DropNulls(*lineitem_keys, late_delivery_mask.data());
+    timer.Count(num_lineitem_rows, num_lineitem_rows * 2 * sizeof(int32_t));
+    
+    timer.Switch(Phase::kProbe);
+    timer.Count(num_lineitem_rows, num_lineitem_rows * sizeof(int64_t));
+    key_mask.assign(num_bytes, 0);
+    quarter_order_keys.Probe(lineitem_keys->raw_values(), num_lineitem_rows,
+                             key_mask.data());
+    rvv::and_bitmap(key_mask.data(), 0, late_delivery_mask.data(), 0,
+                    num_lineitem_rows);
+    
+    // Bloom filter false positives come back as kMissing here
+    candidate_keys.clear();
+    for (size_t i = 0; i < num_lineitem_rows; ++i) {
+      if ((key_mask[i / 8] & (1 << (i % 8))) != 0) {
+        candidate_keys.push_back(lineitem_keys->Value(i));
+      }
+    }
+    candidate_slots.resize(candidate_keys.size());
+    order_slots.Probe(candidate_keys.data(), candidate_keys.size(),
+                      candidate_slots.data());
+    for (int32_t slot : candidate_slots) {
+      if (slot != Int32JoinTable::kMissing) {
+        slot_has_late[slot] = 1;
+      }
     }
   }
   
-  std::cout << "Found " << late_order_keys.size() 
-            << " orders with late deliveries." << std::endl;
-  
-  auto order_keys = std::static_pointer_cast<arrow::Int64Array>(
-      filtered_orders->GetColumnByName("o_orderkey")->chunk(0));
-  auto order_priorities = std::static_pointer_cast<arrow::StringArray>(
-      filtered_orders->GetColumnByName("o_orderpriority")->chunk(0));
-  
-  std::map<std::string, int> priority_counts;
-  
-  size_t num_filtered_orders = filtered_orders->num_rows();
-  for (size_t i = 0; i < num_filtered_orders; ++i) {
-    int64_t order_key = order_keys->Value(i);
-    
-    if (late_order_keys.find(order_key) != late_order_keys.end()) {
-      std::string priority = order_priorities->GetString(i);
-      priority_counts[priority]++;
+  std::cout << "Scanned " << lineitem_scanner->rows_read()
+            << " LINEITEM rows; the "
+            << (quarter_order_keys.exact() ? "bitmap" : "Bloom filter")
+            << " of quarter orders skipped "
+            << lineitem_scanner->row_groups_skipped() << " of "
+            << lineitem_scanner->num_row_groups() << " row groups." << std::endl;
+  
+  // Counted by priority code; names only come in for the sorted output
+  PhaseTimer timer(Phase::kAggregate);
+  std::vector<int64_t> code_counts(priority_names.size(), 0);
+  for (size_t slot = 0; slot < slot_priority.size(); slot++) {
+    code_counts[slot_priority[slot]] += slot_has_late[slot];
+  }
+  std::map<std::string, int64_t> priority_counts;
+  for (size_t code = 0; code < code_counts.size(); code++) {
+    if (code_counts[code] != 0) {
+      priority_counts[priority_names[code]] = code_counts[code];
     }
   }
+  timer.Stop();
   
-
   auto end_time = std::chrono::high_resolution_clock::now();
   std::chrono::duration<double> elapsed = end_time - start_time;
   std::cout << "\nQuery executed in " << elapsed.count() << " seconds" << std::endl;
@@ -192,6 +298,7 @@ Status RunQuery4(const std::string& orders_file, const std::string& lineitem_fil
   
   for (const auto& entry : priority_counts) {
     std::cout << entry.first << " | " << entry.second << std::endl;
+    QueryProfile::Global().AddRow({entry.first, ResultField(entry.second)});
   }
   
   return Status::OK();
@@ -199,19 +306,24 @@ Status RunQuery4(const std::string& orders_file, const std::string& lineitem_fil
 
 int main(int argc, char** argv) {
   if (argc < 3) {
-    std::cerr << "Usage: " << argv[0] << " <orders_parquet> <lineitem_parquet>" << std::endl;
+    std::cerr << "Usage: " << argv[0] << " <orders_parquet> <lineitem_parquet> "
+              << QueryOptionsUsage() << std::endl;
     return 1;
   }
   
   std::string orders_file = argv[1];
   std::string lineitem_file = argv[2];
-  
-  Status st = RunQuery4(orders_file, lineitem_file);
+  QueryOptions options;
+  Status st = ParseQueryOptions(argc, argv, 3, &options);
+  if (st.ok()) {
+    st = RunQuery4(orders_file, lineitem_file, options);
+  }
   
   if (!st.ok()) {
     std::cerr << "Error: " << st.ToString() << std::endl;
     return 1;
   }
   
+  WriteProfile();
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "scan_queries.h"
+
+#include <arrow/result.h>
+#include <arrow/status.h>
+
+#include "date_util.h"
+#include "operators.h"
+#include "parquet_scan.h"
+#include "query_options.h"
+#include "query_profile.h"
+#include "shared_scan.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using arrow::Status;
+
+namespace {
+
+// 1. l_shipdate >= DATE '1994-01-01'
+// 2. l_shipdate < DATE '1995-01-01'
+constexpr int32_t kStartDay = date_literal("1994-01-01");
+constexpr int32_t kEndDay = date_literal("1995-01-01");
+
+}  // namespace
+
+// Late materialization: the predicates only clear bits of the selection, and
+// l_extendedprice and l_discount are decoded for the ~2% of rows that
+// survive them rather than for the whole batch.
+std::unique_ptr<ScanQuery> MakeQuery6(const QueryOptions& options) {
+  ScanOptions scan_options;
+  scan_options.columns = {"l_shipdate", "l_discount", "l_extendedprice",
+                          "l_quantity"};
+  scan_options.prune = {{"l_shipdate", kStartDay, kEndDay - 1}};
+  auto plan = std::make_unique<Pipeline>(scan_options, options);
+  Pipeline* query = plan.get();
+
+  // The shipdate range is implied when the row group's statistics lie
+  // inside it
+  query->Add<Int32RangeFilter>("l_shipdate", kStartDay, kEndDay)
+      ->ImpliedByPrune();
+  // 3. l_discount BETWEEN 0.05 AND 0.07
+  query->Add<DecimalRangeFilter>("l_discount", 0.05, 0.07);
+  // 4. l_quantity < 24
+  query->Add(DecimalRangeFilter::Below("l_quantity", 24.0));
+  int price = query->AddSlot();
+  int discount = query->AddSlot();
+  query->Add<ProjectDecimal>("l_extendedprice", price, options.agg_mode);
+  query->Add<ProjectDecimal>("l_discount", discount, options.agg_mode);
+  auto* revenue =
+      query->Add<Sum<SumExpr::kProduct>>(options.agg_mode, price, discount);
+
+  auto start_time = std::chrono::high_resolution_clock::now();
+  query->OnFinish([query, revenue, start_time](const ScanStats& stats) {
+    std::cout << "Scanned " << stats.rows_read << " rows with "
+              << query->num_workers() << " threads; skipped "
+              << stats.row_groups_skipped << " of "
+              << stats.num_row_groups << " row groups by statistics."
+              << std::endl;
+    std::cout << "Selected " << revenue->count() << " rows." << std::endl;
+
+    std::string revenue_text = revenue->Format();
+    std::cout << "\nTPC-H Query 6 Result (with RVV 1.0 optimization):\n";
+    std::cout << "---------------------------------------------\n";
+    std::cout << "REVENUE\n";
+    std::cout << "-------\n";
+    std::cout << revenue_text << std::endl;
+    QueryProfile::Global().AddRow({revenue_text});
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = end_time - start_time;
+    std::cout << "\nQuery executed in " << elapsed.count() << " seconds" << std::endl;
+    return Status::OK();
+  });
+  return plan;
+}
@@ -1,28 +1,30 @@
 #include <arrow/api.h>
-#include <arrow/io/api.h>
+#include <arrow/compute/api.h>
 #include <arrow/result.h>
 #include <arrow/status.h>
-#include <arrow/compute/api.h>
-#include <arrow/compute/expression.h>
-#include <arrow/dataset/api.h>
-#include <arrow/dataset/file_parquet.h>
-#include <arrow/dataset/scanner.h>
-#include <parquet/arrow/reader.h>
-#include <parquet/file_reader.h>
 
-#include <riscv_vector.h>
+#include "chunked_dispatch.h"
+#include "dense_group_by.h"
+#include "flat_hash_map.h"
+#include "join_cache.h"
+#include "join_table.h"
+#include "parquet_scan.h"
+#include "query_options.h"
+#include "query_profile.h"
+#include "rvv_dispatch.h"
+#include "rvv_kernels.h"
+#include "scratch_arena.h"
+#include "semi_join_filter.h"
 
 #include <iostream>
 #include <iomanip>
-#include <sstream>
 #include <vector>
 #include <map>
-#include <set>
 #include <chrono>
 #include <string>
 #include <memory>
 #include <algorithm>
-#include <ctime>
+#include <limits>
 
 using namespace arrow;
 using namespace arrow::compute;
@@ -55,317 +57,192 @@ struct NationYearKey {
     }
 };
 
-// Convert ISO date string to days since epoch
-int32_t date_string_to_days(const std::string& date_str) {
-    std::tm tm = {};
-    std::istringstream ss(date_str);
-    ss >> std::get_time(&tm, "%Y-%m-%d");
-    
-    std::time_t time = std::mktime(&tm);
-    // Convert to days since epoch (1970-01-01)
-    return static_cast<int32_t>(time / (60 * 60 * 24));
-}
-
-// Extract year from days since epoch
-int32_t days_to_year(int32_t days) {
-    std::time_t time = static_cast<std::time_t>(days) * 24 * 60 * 60;
-    std::tm* tm = std::gmtime(&time);
-    return tm->tm_year + 1900;
-}
-
-// Check if a string contains a substring (case sensitive)
-bool contains_substring(const std::string& str, const std::string& substr) {
-    return str.find(substr) != std::string::npos;
-}
-
-// Calculate extendedprice * (1 - discount) using RVV
-void compute_disc_price_rvv(const float* extendedprice, const float* discount,
-                            float* result, size_t n) {
-    size_t i = 0;
-    size_t vl;
-
-    for (; i < n; i += vl) {
-        vl = __riscv_vsetvl_e32m8(n - i);
-
-        vfloat32m8_t v_price = __riscv_vle32_v_f32m8(extendedprice + i, vl);
-        vfloat32m8_t v_discount = __riscv_vle32_v_f32m8(discount + i, vl);
-
-        // Calculate 1 - discount
-        vfloat32m8_t v_one = __riscv_vfmv_v_f_f32m8(1.0f, vl);
-        vfloat32m8_t v_one_minus_discount = __riscv_vfsub_vv_f32m8(v_one, v_discount, vl);
+const std::vector<std::string> kPartColumns = {"p_partkey", "p_name"};
+const std::vector<std::string> kNationColumns = {"n_nationkey", "n_name"};
+const std::vector<std::string> kSupplierColumns = {"s_suppkey", "s_nationkey"};
+const std::vector<std::string> kPartsuppColumns = {"ps_partkey", "ps_suppkey", "ps_supplycost"};
+const std::vector<std::string> kOrdersColumns = {"o_orderkey", "o_orderdate"};
 
-        // Calculate extendedprice * (1 - discount)
-        vfloat32m8_t v_disc_price = __riscv_vfmul_vv_f32m8(v_price, v_one_minus_discount, vl);
-
-        // Store results
-        __riscv_vse32_v_f32m8(result + i, v_disc_price, vl);
-    }
-}
-
-// Calculate supplycost * quantity using RVV
-void compute_supply_cost_rvv(const float* supplycost, const float* quantity,
-                            float* result, size_t n) {
-    size_t i = 0;
-    size_t vl;
-
-    for (; i < n; i += vl) {
-        vl = __riscv_vsetvl_e32m8(n - i);
-
-        vfloat32m8_t v_cost = __riscv_vle32_v_f32m8(supplycost + i, vl);
-        vfloat32m8_t v_quantity = __riscv_vle32_v_f32m8(quantity + i, vl);
-
-        // Calculate supplycost * quantity
-        vfloat32m8_t v_supply_cost = __riscv_vfmul_vv_f32m8(v_cost, v_quantity, vl);
-
-        // Store results
-        __riscv_vse32_v_f32m8(result + i, v_supply_cost, vl);
-    }
-}
-
-// Calculate profit amount = disc_price - supply_cost using RVV
-void compute_profit_rvv(const float* disc_price, const float* supply_cost,
-                        float* result, size_t n) {
-    size_t i = 0;
-    size_t vl;
-
-    for (; i < n; i += vl) {
-        vl = __riscv_vsetvl_e32m8(n - i);
-
-        vfloat32m8_t v_disc_price = __riscv_vle32_v_f32m8(disc_price + i, vl);
-        vfloat32m8_t v_supply_cost = __riscv_vle32_v_f32m8(supply_cost + i, vl);
-
-        // Calculate disc_price - supply_cost
-        vfloat32m8_t v_profit = __riscv_vfsub_vv_f32m8(v_disc_price, v_supply_cost, vl);
-
-        // Store results
-        __riscv_vse32_v_f32m8(result + i, v_profit, vl);
-    }
-}
-
-// Process a batch of records to compute profit using RVV
-void batch_process_profit(
-    const float* price_data, 
-    const float* discount_data,
-    const float* quantity_data,
-    const float* supplycost_data,
-    float* profit_data,
-    size_t batch_size) {
-
-    // Temporary arrays for intermediate results
-    float* disc_price_data = new float[batch_size];
-    float* supply_cost_data = new float[batch_size];
-    
-    // Calculate disc_price = extendedprice * (1 - discount)
-    compute_disc_price_rvv(price_data, discount_data, disc_price_data, batch_size);
-    
-    // Calculate supply_cost = supplycost * quantity
-    compute_supply_cost_rvv(supplycost_data, quantity_data, supply_cost_data, batch_size);
-    
-    // Calculate profit = disc_price - supply_cost
-    compute_profit_rvv(disc_price_data, supply_cost_data, profit_data, batch_size);
-    
-    // Clean up
-    delete[] disc_price_data;
-    delete[] supply_cost_data;
-}
-
-int main(int argc, char** argv) {
-    if (argc < 7) {
-        std::cerr << "Usage: " << argv[0] 
-                  << " <part.parquet> <supplier.parquet> <lineitem.parquet> "
-                  << "<partsupp.parquet> <orders.parquet> <nation.parquet>" << std::endl;
-        return 1;
+// Everything built before lineitem streams past; kept across runs in the
+// join cache
+struct Query9Build {
+    SemiJoinFilter green_parts;
+    std::vector<std::string> nation_names;
+    // suppkey -> index into nation_names
+    Int32JoinTable supplier_nation_map;
+    // (partkey, suppkey) -> supplycost of green parts
+    FlatHashMap<Int64Pair, double> partsupp_cost_map;
+    // orderkey -> year of o_orderdate
+    Int32JoinTable order_year_map;
+    // Smallest and largest year in order_year_map; empty when first > last
+    int32_t first_year = 0;
+    int32_t last_year = -1;
+    
+    void Save(JoinCacheWriter& out) const {
+        green_parts.Save(out);
+        out.Strings(nation_names);
+        supplier_nation_map.Save(out);
+        partsupp_cost_map.Save(out);
+        order_year_map.Save(out);
+        out.Value(first_year);
+        out.Value(last_year);
+    }
+    
+    bool Load(JoinCacheReader& in) {
+        return green_parts.Load(in) && in.Strings(&nation_names) &&
+               supplier_nation_map.Load(in) && partsupp_cost_map.Load(in) &&
+               order_year_map.Load(in) && in.Value(&first_year) && in.Value(&last_year);
     }
+};
 
-    std::string part_file = argv[1];
-    std::string supplier_file = argv[2];
-    std::string lineitem_file = argv[3];
-    std::string partsupp_file = argv[4];
-    std::string orders_file = argv[5];
-    std::string nation_file = argv[6];
-    
-    auto start_time = std::chrono::high_resolution_clock::now();
-    
-    // Initialize Arrow's memory pool
-    arrow::MemoryPool* pool = arrow::default_memory_pool();
+// Steps 1-5: the build side from part, nation, supplier, partsupp and orders
+Status BuildQuery9(const std::string& part_file,
+                   const std::string& supplier_file,
+                   const std::string& partsupp_file,
+                   const std::string& orders_file,
+                   const std::string& nation_file,
+                   const InputOptions& input,
+                   Query9Build* build) {
+    SemiJoinFilter& green_parts = build->green_parts;
+    std::vector<std::string>& nation_names = build->nation_names;
+    Int32JoinTable& supplier_nation_map = build->supplier_nation_map;
+    FlatHashMap<Int64Pair, double>& partsupp_cost_map = build->partsupp_cost_map;
+    Int32JoinTable& order_year_map = build->order_year_map;
+    
+    std::shared_ptr<RecordBatch> batch;
     
     // 1. Process part table - filter by p_name like '%green%'
-    auto maybe_part_file = arrow::io::ReadableFile::Open(part_file);
-    if (!maybe_part_file.ok()) {
-        std::cerr << "Could not open part file: " << maybe_part_file.status().ToString() << std::endl;
-        return 1;
-    }
-    std::shared_ptr<arrow::io::ReadableFile> part_infile = *maybe_part_file;
-    
-    auto part_reader_result = parquet::arrow::OpenFile(part_infile, pool);
-    if (!part_reader_result.ok()) {
-        std::cerr << "Could not open part parquet file: " << part_reader_result.status().ToString() << std::endl;
-        return 1;
-    }
-    std::unique_ptr<parquet::arrow::FileReader> part_reader = std::move(*part_reader_result);
-    
-    std::shared_ptr<arrow::Table> part_table;
-    auto status = part_reader->ReadTable(&part_table);
-    if (!status.ok()) {
-        std::cerr << "Could not read part table: " << status.ToString() << std::endl;
-        return 1;
-    }
-    
-    std::cout << "Part table loaded with " << part_table->num_rows() << " rows" << std::endl;
-    
-    // Extract required columns from part
-    auto p_partkey_col = part_table->GetColumnByName("p_partkey");
-    auto p_name_col = part_table->GetColumnByName("p_name");
+    ScanOptions part_options;
+    part_options.columns = kPartColumns;
+    part_options.input = input;
+    std::unique_ptr<ParquetScanner> part_scanner;
+    ARROW_ASSIGN_OR_RAISE(part_scanner, ParquetScanner::Open(part_file, part_options));
     
     // Filter parts where p_name like '%green%'
-    std::set<int64_t> green_parts;
-    
-    for (int chunk_idx = 0; chunk_idx < p_partkey_col->num_chunks(); chunk_idx++) {
-        auto p_partkey_array = std::static_pointer_cast<arrow::Int64Array>(p_partkey_col->chunk(chunk_idx));
-        auto p_name_array = std::static_pointer_cast<arrow::StringArray>(p_name_col->chunk(chunk_idx));
+    green_parts =
+        SemiJoinFilter::ForColumn(*part_scanner, "p_partkey", part_scanner->num_rows());
+    std::vector<uint8_t> name_mask;
+    
+    while (true) {
+        ARROW_ASSIGN_OR_RAISE(batch, part_scanner->Next());
+        if (!batch) {
+            break;
+        }
+        PhaseTimer timer(Phase::kFilter);
+        auto p_partkey_array = std::static_pointer_cast<arrow::Int64Array>(batch->GetColumnByName("p_partkey"));
+        auto p_name_array = std::static_pointer_cast<arrow::StringArray>(batch->GetColumnByName("p_name"));
         
-        int64_t num_rows = p_partkey_array->length();
+        int64_t num_rows = batch->num_rows();
+        // p_name LIKE '%green%' straight off the string buffers
+        name_mask.resize((num_rows + 7) / 8);
+        ContainsBitmap(*p_name_array, "green", name_mask.data());
+        DropNulls(*p_partkey_array, name_mask.data());
+        DropNulls(*p_name_array, name_mask.data());
+        timer.Switch(Phase::kJoinBuild);
         for (int64_t i = 0; i < num_rows; i++) {
-            if (p_partkey_array->IsNull(i) || p_name_array->IsNull(i)) {
-                continue;
-            }
-            
-            std::string name = p_name_array->GetString(i);
-            if (contains_substring(name, "green")) {
-                green_parts.insert(p_partkey_array->Value(i));
+            if ((name_mask[i / 8] & (1 << (i % 8))) != 0) {
+                green_parts.Insert(p_partkey_array->Value(i));
             }
         }
     }
     
+    std::cout << "Part table scanned, " << part_scanner->rows_read() << " rows" << std::endl;
     std::cout << "Found " << green_parts.size() << " parts with 'green' in the name" << std::endl;
     
     // 2. Process nation table to get nation names
-    auto maybe_nation_file = arrow::io::ReadableFile::Open(nation_file);
-    if (!maybe_nation_file.ok()) {
-        std::cerr << "Could not open nation file: " << maybe_nation_file.status().ToString() << std::endl;
-        return 1;
-    }
-    std::shared_ptr<arrow::io::ReadableFile> nation_infile = *maybe_nation_file;
-    
-    auto nation_reader_result = parquet::arrow::OpenFile(nation_infile, pool);
-    if (!nation_reader_result.ok()) {
-        std::cerr << "Could not open nation parquet file: " << nation_reader_result.status().ToString() << std::endl;
-        return 1;
-    }
-    std::unique_ptr<parquet::arrow::FileReader> nation_reader = std::move(*nation_reader_result);
-    
-    std::shared_ptr<arrow::Table> nation_table;
-    status = nation_reader->ReadTable(&nation_table);
-    if (!status.ok()) {
-        std::cerr << "Could not read nation table: " << status.ToString() << std::endl;
-        return 1;
-    }
-    
-    std::cout << "Nation table loaded with " << nation_table->num_rows() << " rows" << std::endl;
-    
-    // Build a map of nationkey to nation name
-    std::map<int64_t, std::string> nation_map;
-    
-    auto n_nationkey_col = nation_table->GetColumnByName("n_nationkey");
-    auto n_name_col = nation_table->GetColumnByName("n_name");
-    
-    for (int chunk_idx = 0; chunk_idx < n_nationkey_col->num_chunks(); chunk_idx++) {
-        auto n_nationkey_array = std::static_pointer_cast<arrow::Int64Array>(n_nationkey_col->chunk(chunk_idx));
-        auto n_name_array = std::static_pointer_cast<arrow::StringArray>(n_name_col->chunk(chunk_idx));
+    ScanOptions nation_options;
+    nation_options.columns = kNationColumns;
+    nation_options.input = input;
+    std::unique_ptr<ParquetScanner> nation_scanner;
+    ARROW_ASSIGN_OR_RAISE(nation_scanner, ParquetScanner::Open(nation_file, nation_options));
+    
+    // nationkey -> index into nation_names
+    Int32JoinTable nation_index =
+        Int32JoinTable::ForColumn(*nation_scanner, "n_nationkey");
+    
+    while (true) {
+        ARROW_ASSIGN_OR_RAISE(batch, nation_scanner->Next());
+        if (!batch) {
+            break;
+        }
+        PhaseTimer timer(Phase::kJoinBuild);
+        auto n_nationkey_array = std::static_pointer_cast<arrow::Int64Array>(batch->GetColumnByName("n_nationkey"));
+        auto n_name_array = std::static_pointer_cast<arrow::StringArray>(batch->GetColumnByName("n_name"));
         
-        int64_t num_rows = n_nationkey_array->length();
+        int64_t num_rows = batch->num_rows();
         for (int64_t i = 0; i < num_rows; i++) {
             if (n_nationkey_array->IsNull(i) || n_name_array->IsNull(i)) {
                 continue;
             }
             
             int64_t nationkey = n_nationkey_array->Value(i);
-            std::string name = n_name_array->GetString(i);
-            nation_map[nationkey] = name;
+            nation_index.Insert(nationkey, static_cast<int32_t>(nation_names.size()));
+            nation_names.push_back(n_name_array->GetString(i));
         }
     }
     
-    // 3. Process supplier table to get supplier nation relationships
-    auto maybe_supplier_file = arrow::io::ReadableFile::Open(supplier_file);
-    if (!maybe_supplier_file.ok()) {
-        std::cerr << "Could not open supplier file: " << maybe_supplier_file.status().ToString() << std::endl;
-        return 1;
-    }
-    std::shared_ptr<arrow::io::ReadableFile> supplier_infile = *maybe_supplier_file;
-    
-    auto supplier_reader_result = parquet::arrow::OpenFile(supplier_infile, pool);
-    if (!supplier_reader_result.ok()) {
-        std::cerr << "Could not open supplier parquet file: " << supplier_reader_result.status().ToString() << std::endl;
-        return 1;
-    }
-    std::unique_ptr<parquet::arrow::FileReader> supplier_reader = std::move(*supplier_reader_result);
-    
-    std::shared_ptr<arrow::Table> supplier_table;
-    status = supplier_reader->ReadTable(&supplier_table);
-    if (!status.ok()) {
-        std::cerr << "Could not read supplier table: " << status.ToString() << std::endl;
-        return 1;
-    }
-    
-    std::cout << "Supplier table loaded with " << supplier_table->num_rows() << " rows" << std::endl;
-    
-    // Map suppliers to nations
-    std::map<int64_t, int64_t> supplier_nation_map;
-    
-    auto s_suppkey_col = supplier_table->GetColumnByName("s_suppkey");
-    auto s_nationkey_col = supplier_table->GetColumnByName("s_nationkey");
+    std::cout << "Nation table scanned, " << nation_scanner->rows_read() << " rows" << std::endl;
     
-    for (int chunk_idx = 0; chunk_idx < s_suppkey_col->num_chunks(); chunk_idx++) {
-        auto s_suppkey_array = std::static_pointer_cast<arrow::Int64Array>(s_suppkey_col->chunk(chunk_idx));
-        auto s_nationkey_array = std::static_pointer_cast<arrow::Int64Array>(s_nationkey_col->chunk(chunk_idx));
+    // 3. Process supplier table to get supplier nation relationships
+    ScanOptions supplier_options;
+    supplier_options.columns = kSupplierColumns;
+    supplier_options.input = input;
+    std::unique_ptr<ParquetScanner> supplier_scanner;
+    ARROW_ASSIGN_OR_RAISE(supplier_scanner, ParquetScanner::Open(supplier_file, supplier_options));
+    
+    // Map suppliers to nations, as indices into nation_names
+    supplier_nation_map =
+        Int32JoinTable::ForColumn(*supplier_scanner, "s_suppkey");
+    
+    while (true) {
+        ARROW_ASSIGN_OR_RAISE(batch, supplier_scanner->Next());
+        if (!batch) {
+            break;
+        }
+        PhaseTimer timer(Phase::kJoinBuild);
+        auto s_suppkey_array = std::static_pointer_cast<arrow::Int64Array>(batch->GetColumnByName("s_suppkey"));
+        auto s_nationkey_array = std::static_pointer_cast<arrow::Int64Array>(batch->GetColumnByName("s_nationkey"));
         
-        int64_t num_rows = s_suppkey_array->length();
+        int64_t num_rows = batch->num_rows();
         for (int64_t i = 0; i < num_rows; i++) {
             if (s_suppkey_array->IsNull(i) || s_nationkey_array->IsNull(i)) {
                 continue;
             }
             
             int64_t suppkey = s_suppkey_array->Value(i);
-            int64_t nationkey = s_nationkey_array->Value(i);
-            supplier_nation_map[suppkey] = nationkey;
+            int32_t nation = nation_index.Find(s_nationkey_array->Value(i));
+            if (nation != Int32JoinTable::kMissing) {
+                supplier_nation_map.Insert(suppkey, nation);
+            }
         }
     }
     
-    // 4. Process partsupp table to get supply costs
-    auto maybe_partsupp_file = arrow::io::ReadableFile::Open(partsupp_file);
-    if (!maybe_partsupp_file.ok()) {
-        std::cerr << "Could not open partsupp file: " << maybe_partsupp_file.status().ToString() << std::endl;
-        return 1;
-    }
-    std::shared_ptr<arrow::io::ReadableFile> partsupp_infile = *maybe_partsupp_file;
-    
-    auto partsupp_reader_result = parquet::arrow::OpenFile(partsupp_infile, pool);
-    if (!partsupp_reader_result.ok()) {
-        std::cerr << "Could not open partsupp parquet file: " << partsupp_reader_result.status().ToString() << std::endl;
-        return 1;
-    }
-    std::unique_ptr<parquet::arrow::FileReader> partsupp_reader = std::move(*partsupp_reader_result);
-    
-    std::shared_ptr<arrow::Table> partsupp_table;
-    status = partsupp_reader->ReadTable(&partsupp_table);
-    if (!status.ok()) {
-        std::cerr << "Could not read partsupp table: " << status.ToString() << std::endl;
-        return 1;
-    }
+    std::cout << "Supplier table scanned, " << supplier_scanner->rows_read() << " rows" << std::endl;
     
-    std::cout << "Partsupp table loaded with " << partsupp_table->num_rows() << " rows" << std::endl;
+    // 4. Process partsupp table to get supply costs
+    ScanOptions partsupp_options;
+    partsupp_options.columns = kPartsuppColumns;
+    partsupp_options.input = input;
+    std::unique_ptr<ParquetScanner> partsupp_scanner;
+    ARROW_ASSIGN_OR_RAISE(partsupp_scanner, ParquetScanner::Open(partsupp_file, partsupp_options));
     
     // Create a composite key for partsupp (partkey, suppkey) -> supplycost
-    std::map<std::pair<int64_t, int64_t>, double> partsupp_cost_map;
+    // TPC-H has four suppliers per part
+    partsupp_cost_map = FlatHashMap<Int64Pair, double>(4 * green_parts.size());
     
-    auto ps_partkey_col = partsupp_table->GetColumnByName("ps_partkey");
-    auto ps_suppkey_col = partsupp_table->GetColumnByName("ps_suppkey");
-    auto ps_supplycost_col = partsupp_table->GetColumnByName("ps_supplycost");
+    // Decoded supplycost of the current batch, reused across batches
+    std::vector<double> supplycost_values;
+    std::vector<uint8_t> green_mask;
     
-    for (int chunk_idx = 0; chunk_idx < ps_partkey_col->num_chunks(); chunk_idx++) {
-        auto ps_partkey_array = std::static_pointer_cast<arrow::Int64Array>(ps_partkey_col->chunk(chunk_idx));
-        auto ps_suppkey_array = std::static_pointer_cast<arrow::Int64Array>(ps_suppkey_col->chunk(chunk_idx));
-        auto ps_supplycost_chunk = ps_supplycost_col->chunk(chunk_idx);
+    while (true) {
+        ARROW_ASSIGN_OR_RAISE(batch, partsupp_scanner->Next());
+        if (!batch) {
+            break;
+        }
+        PhaseTimer timer(Phase::kDecode);
+        auto ps_partkey_array = std::static_pointer_cast<arrow::Int64Array>(batch->GetColumnByName("ps_partkey"));
+        auto ps_suppkey_array = std::static_pointer_cast<arrow::Int64Array>(batch->GetColumnByName("ps_suppkey"));
+        auto ps_supplycost_chunk = batch->GetColumnByName("ps_supplycost");
         
         // Get scale for decimal columns
         int32_t supplycost_scale = 2;
@@ -376,8 +253,24 @@ int main(int argc, char** argv) {
         
         auto ps_supplycost_decimal_array = std::static_pointer_cast<arrow::Decimal128Array>(ps_supplycost_chunk);
         
-        int64_t num_rows = ps_partkey_array->length();
+        int64_t num_rows = batch->num_rows();
+        
+        // Decode the whole supplycost column of this batch in one vector pass
+        supplycost_values.resize(num_rows);
+        rvv::with_lmul(rvv::KernelClass::kDecode, [&](auto lmul) {
+            rvv::decode_decimal128<double, decltype(lmul)::value>(
+                ps_supplycost_decimal_array->raw_values(), supplycost_scale,
+                supplycost_values.data(), num_rows);
+        });
+        // Part-supplier combinations that may involve "green" parts
+        timer.Switch(Phase::kProbe);
+        green_mask.assign((num_rows + 7) / 8, 0);
+        green_parts.Probe(ps_partkey_array->raw_values(), num_rows, green_mask.data());
+        timer.Switch(Phase::kJoinBuild);
         for (int64_t i = 0; i < num_rows; i++) {
+            if ((green_mask[i / 8] & (1 << (i % 8))) == 0) {
+                continue;
+            }
             if (ps_partkey_array->IsNull(i) || ps_suppkey_array->IsNull(i) || ps_supplycost_decimal_array->IsNull(i)) {
                 continue;
             }
@@ -385,121 +278,137 @@ int main(int argc, char** argv) {
             int64_t partkey = ps_partkey_array->Value(i);
             int64_t suppkey = ps_suppkey_array->Value(i);
             
-            // Skip part-supplier combinations that don't involve "green" parts
-            if (green_parts.find(partkey) == green_parts.end()) {
+            if (!green_parts.exact() && !green_parts.Contains(partkey)) {
                 continue;
             }
             
-            arrow::Decimal128 supplycost_val(ps_supplycost_decimal_array->Value(i));
-            double supplycost = supplycost_val.ToDouble(supplycost_scale);
-            partsupp_cost_map[{partkey, suppkey}] = supplycost;
+            partsupp_cost_map[{partkey, suppkey}] = supplycost_values[i];
         }
     }
     
+    std::cout << "Partsupp table scanned, " << partsupp_scanner->rows_read() << " rows" << std::endl;
     std::cout << "Found " << partsupp_cost_map.size() << " part-supplier combinations for green parts" << std::endl;
     
     // 5. Process orders table to get order dates
-    auto maybe_orders_file = arrow::io::ReadableFile::Open(orders_file);
-    if (!maybe_orders_file.ok()) {
-        std::cerr << "Could not open orders file: " << maybe_orders_file.status().ToString() << std::endl;
-        return 1;
-    }
-    std::shared_ptr<arrow::io::ReadableFile> orders_infile = *maybe_orders_file;
-    
-    auto orders_reader_result = parquet::arrow::OpenFile(orders_infile, pool);
-    if (!orders_reader_result.ok()) {
-        std::cerr << "Could not open orders parquet file: " << orders_reader_result.status().ToString() << std::endl;
-        return 1;
-    }
-    std::unique_ptr<parquet::arrow::FileReader> orders_reader = std::move(*orders_reader_result);
-    
-    std::shared_ptr<arrow::Table> orders_table;
-    status = orders_reader->ReadTable(&orders_table);
-    if (!status.ok()) {
-        std::cerr << "Could not read orders table: " << status.ToString() << std::endl;
-        return 1;
-    }
-    
-    std::cout << "Orders table loaded with " << orders_table->num_rows() << " rows" << std::endl;
+    ScanOptions orders_options;
+    orders_options.columns = kOrdersColumns;
+    orders_options.input = input;
+    std::unique_ptr<ParquetScanner> orders_scanner;
+    ARROW_ASSIGN_OR_RAISE(orders_scanner, ParquetScanner::Open(orders_file, orders_options));
     
     // Map orderkey to order year
-    std::map<int64_t, int32_t> order_year_map;
+    order_year_map =
+        Int32JoinTable::ForColumn(*orders_scanner, "o_orderkey");
     
-    auto o_orderkey_col = orders_table->GetColumnByName("o_orderkey");
-    auto o_orderdate_col = orders_table->GetColumnByName("o_orderdate");
+    std::vector<int32_t> order_date_years;
+    int32_t first_year = std::numeric_limits<int32_t>::max();
+    int32_t last_year = std::numeric_limits<int32_t>::min();
     
-    for (int chunk_idx = 0; chunk_idx < o_orderkey_col->num_chunks(); chunk_idx++) {
-        auto o_orderkey_array = std::static_pointer_cast<arrow::Int64Array>(o_orderkey_col->chunk(chunk_idx));
-        auto o_orderdate_array = std::static_pointer_cast<arrow::Date32Array>(o_orderdate_col->chunk(chunk_idx));
+    while (true) {
+        ARROW_ASSIGN_OR_RAISE(batch, orders_scanner->Next());
+        if (!batch) {
+            break;
+        }
+        PhaseTimer timer(Phase::kDecode);
+        auto o_orderkey_array = std::static_pointer_cast<arrow::Int64Array>(batch->GetColumnByName("o_orderkey"));
+        auto o_orderdate_array = std::static_pointer_cast<arrow::Date32Array>(batch->GetColumnByName("o_orderdate"));
         
-        int64_t num_rows = o_orderkey_array->length();
+        int64_t num_rows = batch->num_rows();
+        // EXTRACT(YEAR FROM o_orderdate) for the whole batch in one vector pass
+        order_date_years.resize(num_rows);
+        rvv::date32_to_year(o_orderdate_array->raw_values(), order_date_years.data(), num_rows);
+        timer.Switch(Phase::kJoinBuild);
         for (int64_t i = 0; i < num_rows; i++) {
             if (o_orderkey_array->IsNull(i) || o_orderdate_array->IsNull(i)) {
                 continue;
             }
             
-            int64_t orderkey = o_orderkey_array->Value(i);
-            int32_t orderdate = o_orderdate_array->Value(i);
-            
-            // Extract year from orderdate
-            int32_t year = days_to_year(orderdate);
-            order_year_map[orderkey] = year;
+            int32_t year = order_date_years[i];
+            order_year_map.Insert(o_orderkey_array->Value(i), year);
+            first_year = std::min(first_year, year);
+            last_year = std::max(last_year, year);
         }
     }
     
-    // 6. Process lineitem table and compute profits using RVV
-    auto maybe_lineitem_file = arrow::io::ReadableFile::Open(lineitem_file);
-    if (!maybe_lineitem_file.ok()) {
-        std::cerr << "Could not open lineitem file: " << maybe_lineitem_file.status().ToString() << std::endl;
-        return 1;
+    if (first_year <= last_year) {
+        build->first_year = first_year;
+        build->last_year = last_year;
     }
-    std::shared_ptr<arrow::io::ReadableFile> lineitem_infile = *maybe_lineitem_file;
+    std::cout << "Orders table scanned, " << orders_scanner->rows_read() << " rows" << std::endl;
     
-    auto lineitem_reader_result = parquet::arrow::OpenFile(lineitem_infile, pool);
-    if (!lineitem_reader_result.ok()) {
-        std::cerr << "Could not open lineitem parquet file: " << lineitem_reader_result.status().ToString() << std::endl;
-        return 1;
-    }
-    std::unique_ptr<parquet::arrow::FileReader> lineitem_reader = std::move(*lineitem_reader_result);
+    return Status::OK();
+}
+
+Status RunQuery9(const std::string& part_file,
+                 const std::string& supplier_file,
+                 const std::string& lineitem_file,
+                 const std::string& partsupp_file,
+                 const std::string& orders_file,
+                 const std::string& nation_file,
+                 const QueryOptions& options) {
+    auto start_time = std::chrono::high_resolution_clock::now();
     
-    std::shared_ptr<arrow::Table> lineitem_table;
-    status = lineitem_reader->ReadTable(&lineitem_table);
-    if (!status.ok()) {
-        std::cerr << "Could not read lineitem table: " << status.ToString() << std::endl;
-        return 1;
+    // 1.-5. The build side, unless the join cache holds it for these files
+    JoinCache join_cache(options.join_cache_dir);
+    JoinCacheKey cache_key("q9_build");
+    ARROW_RETURN_NOT_OK(cache_key.AddFile(part_file, kPartColumns));
+    ARROW_RETURN_NOT_OK(cache_key.AddFile(nation_file, kNationColumns));
+    ARROW_RETURN_NOT_OK(cache_key.AddFile(supplier_file, kSupplierColumns));
+    ARROW_RETURN_NOT_OK(cache_key.AddFile(partsupp_file, kPartsuppColumns));
+    ARROW_RETURN_NOT_OK(cache_key.AddFile(orders_file, kOrdersColumns));
+    cache_key.Add("p_name like '%green%'");
+    Query9Build build;
+    if (join_cache.Load(cache_key, [&](JoinCacheReader& in) { return build.Load(in); })) {
+        std::cout << "Build side loaded from the join cache" << std::endl;
+    } else {
+        build = Query9Build();
+        ARROW_RETURN_NOT_OK(BuildQuery9(part_file, supplier_file, partsupp_file,
+                                        orders_file, nation_file, options.input, &build));
+        Status st = join_cache.Store(cache_key, [&](JoinCacheWriter& out) { build.Save(out); });
+        if (!st.ok()) {
+            std::cerr << "Warning: join cache not written: " << st.ToString() << std::endl;
+        }
     }
-    
-    std::cout << "Lineitem table loaded with " << lineitem_table->num_rows() << " rows" << std::endl;
-    
-    // Extract required columns from lineitem
-    auto l_orderkey_col = lineitem_table->GetColumnByName("l_orderkey");
-    auto l_partkey_col = lineitem_table->GetColumnByName("l_partkey");
-    auto l_suppkey_col = lineitem_table->GetColumnByName("l_suppkey");
-    auto l_quantity_col = lineitem_table->GetColumnByName("l_quantity");
-    auto l_extendedprice_col = lineitem_table->GetColumnByName("l_extendedprice");
-    auto l_discount_col = lineitem_table->GetColumnByName("l_discount");
-    
-    // Calculate profits grouped by nation and year
-    std::map<NationYearKey, double> profit_by_nation_year;
+    const SemiJoinFilter& green_parts = build.green_parts;
+    const std::vector<std::string>& nation_names = build.nation_names;
+    const Int32JoinTable& supplier_nation_map = build.supplier_nation_map;
+    const FlatHashMap<Int64Pair, double>& partsupp_cost_map = build.partsupp_cost_map;
+    const Int32JoinTable& order_year_map = build.order_year_map;
+    
+    std::shared_ptr<RecordBatch> batch;
+    
+    // 6. Stream lineitem and compute profits using RVV
+    ScanOptions lineitem_options;
+    lineitem_options.columns = {"l_orderkey", "l_partkey", "l_suppkey",
+                                "l_quantity", "l_extendedprice", "l_discount"};
+    lineitem_options.input = options.input;
+    std::unique_ptr<ParquetScanner> lineitem_scanner;
+    ARROW_ASSIGN_OR_RAISE(lineitem_scanner, ParquetScanner::Open(lineitem_file, lineitem_options));
+    
+    // Profit by dense group id nation * year_slots + (year - first_year),
+    // over the years the orders actually have; nation names are attached at
+    // the end
+    const int32_t first_year = build.first_year;
+    const int32_t year_slots = std::max(build.last_year - first_year + 1, 0);
+    DenseGroupSums profit_groups(nation_names.size() * year_slots);
     int64_t rows_processed = 0;
     int64_t rows_qualified = 0;
     
-    // Set batch size for RVV processing
-    const size_t BATCH_SIZE = 1024;
-    
-    // Batch processing structures
-    struct BatchInfo {
-        std::pair<int64_t, int32_t> nation_year_key; // nationkey, year
-        int64_t index;  // Index in the lineitem array
-    };
-    
-    for (int chunk_idx = 0; chunk_idx < l_orderkey_col->num_chunks(); chunk_idx++) {
-        auto l_orderkey_array = std::static_pointer_cast<arrow::Int64Array>(l_orderkey_col->chunk(chunk_idx));
-        auto l_partkey_array = std::static_pointer_cast<arrow::Int64Array>(l_partkey_col->chunk(chunk_idx));
-        auto l_suppkey_array = std::static_pointer_cast<arrow::Int64Array>(l_suppkey_col->chunk(chunk_idx));
-        auto l_quantity_chunk = l_quantity_col->chunk(chunk_idx);
-        auto l_extendedprice_chunk = l_extendedprice_col->chunk(chunk_idx);
-        auto l_discount_chunk = l_discount_col->chunk(chunk_idx);
+    // Every per-batch buffer comes from the scratch arena
+    ScratchArena& scratch = ScratchArena::ForThread();
+    
+    while (true) {
+        ARROW_ASSIGN_OR_RAISE(batch, lineitem_scanner->Next());
+        if (!batch) {
+            break;
+        }
+        PhaseTimer timer(Phase::kDecode);
+        auto l_orderkey_array = std::static_pointer_cast<arrow::Int64Array>(batch->GetColumnByName("l_orderkey"));
+        auto l_partkey_array = std::static_pointer_cast<arrow::Int64Array>(batch->GetColumnByName("l_partkey"));
+        auto l_suppkey_array = std::static_pointer_cast<arrow::Int64Array>(batch->GetColumnByName("l_suppkey"));
+        auto l_quantity_chunk = batch->GetColumnByName("l_quantity");
+        auto l_extendedprice_chunk = batch->GetColumnByName("l_extendedprice");
+        auto l_discount_chunk = batch->GetColumnByName("l_discount");
         
         // Get scale for decimal columns
         int32_t quantity_scale = 2;
@@ -524,150 +433,135 @@ int main(int argc, char** argv) {
         auto l_discount_decimal_array = std::static_pointer_cast<arrow::Decimal128Array>(l_discount_chunk);
         
         int64_t num_rows = l_orderkey_array->length();
+        rows_processed += num_rows;
+        scratch.Reset();
         
-        // First pass: identify qualifying rows and collect metadata
-        std::vector<BatchInfo> batch_items;
-        std::vector<float> price_data;
-        std::vector<float> discount_data;
-        std::vector<float> quantity_data;
-        std::vector<float> supplycost_data;
-        std::map<std::pair<int64_t, int32_t>, std::vector<size_t>> nation_year_indices;
-        
-        for (int64_t i = 0; i < num_rows; i++) {
-            rows_processed++;
-            
-            if (l_orderkey_array->IsNull(i) || l_partkey_array->IsNull(i) || 
-                l_suppkey_array->IsNull(i) || l_quantity_decimal_array->IsNull(i) || 
-                l_extendedprice_decimal_array->IsNull(i) || l_discount_decimal_array->IsNull(i)) {
-                continue;
+        // Rows whose part may be "green" and that have no nulls; everything
+        // else is dropped before any decode or other lookup
+        timer.Switch(Phase::kProbe);
+        timer.Count(num_rows, num_rows * sizeof(int64_t));
+        size_t mask_bytes = (num_rows + 7) / 8;
+        uint8_t* part_mask = scratch.Allocate<uint8_t>(mask_bytes);
+        std::fill(part_mask, part_mask + mask_bytes, 0);
+        green_parts.Probe(l_partkey_array->raw_values(), num_rows, part_mask);
+        const arrow::Array* columns[] = {l_orderkey_array.get(), l_partkey_array.get(),
+                                         l_suppkey_array.get(), l_quantity_decimal_array.get(),
+                                         l_extendedprice_decimal_array.get(),
+                                         l_discount_decimal_array.get()};
+        for (const arrow::Array* array : columns) {
+            if (array->null_count() > 0) {
+                rvv::and_bitmap(part_mask, 0, array->null_bitmap_data(), array->offset(), num_rows);
             }
+        }
+        int32_t* candidate_rows = scratch.Allocate<int32_t>(num_rows);
+        size_t num_candidates = rvv::with_lmul(rvv::KernelClass::kCompare, [&](auto lmul) {
+            return rvv::bitmap_to_selection<decltype(lmul)::value>(part_mask, num_rows,
+                                                                 candidate_rows);
+        });
+        
+        // Decode the decimal columns of the candidates only, with indexed
+        // loads over the selection vector
+        timer.Switch(Phase::kDecode);
+        timer.Count(num_candidates, num_candidates * 3 * arrow::Decimal128Type::kByteWidth);
+        float* chunk_quantity = scratch.Allocate<float>(num_candidates);
+        float* chunk_price = scratch.Allocate<float>(num_candidates);
+        float* chunk_discount = scratch.Allocate<float>(num_candidates);
+        rvv::with_lmul<4>(rvv::KernelClass::kDecode, [&](auto lmul) {
+            constexpr int L = decltype(lmul)::value;
+            rvv::gather_decimal128<float, L>(l_quantity_decimal_array->raw_values(), quantity_scale,
+                                             candidate_rows, num_candidates, chunk_quantity);
+            rvv::gather_decimal128<float, L>(l_extendedprice_decimal_array->raw_values(), price_scale,
+                                             candidate_rows, num_candidates, chunk_price);
+            rvv::gather_decimal128<float, L>(l_discount_decimal_array->raw_values(), discount_scale,
+                                             candidate_rows, num_candidates, chunk_discount);
+        });
+        
+        // Order years and supplier nations of the candidates, gathered in
+        // vector passes when the tables are direct-addressed
+        timer.Switch(Phase::kProbe);
+        timer.Count(num_candidates, num_candidates * 2 * sizeof(int64_t));
+        const int64_t* orderkeys = l_orderkey_array->raw_values();
+        const int64_t* partkeys = l_partkey_array->raw_values();
+        const int64_t* suppkeys = l_suppkey_array->raw_values();
+        int64_t* candidate_orderkeys = scratch.Allocate<int64_t>(num_candidates);
+        int64_t* candidate_suppkeys = scratch.Allocate<int64_t>(num_candidates);
+        for (size_t j = 0; j < num_candidates; j++) {
+            candidate_orderkeys[j] = orderkeys[candidate_rows[j]];
+            candidate_suppkeys[j] = suppkeys[candidate_rows[j]];
+        }
+        int32_t* order_years = scratch.Allocate<int32_t>(num_candidates);
+        int32_t* supplier_nations = scratch.Allocate<int32_t>(num_candidates);
+        order_year_map.Probe(candidate_orderkeys, num_candidates, order_years);
+        supplier_nation_map.Probe(candidate_suppkeys, num_candidates, supplier_nations);
+        
+        // Qualifying rows, compacted into the inputs of the profit kernel
+        float* price_data = scratch.Allocate<float>(num_candidates);
+        float* discount_data = scratch.Allocate<float>(num_candidates);
+        float* quantity_data = scratch.Allocate<float>(num_candidates);
+        float* supplycost_data = scratch.Allocate<float>(num_candidates);
+        int32_t* row_nations = scratch.Allocate<int32_t>(num_candidates);
+        int32_t* row_years = scratch.Allocate<int32_t>(num_candidates);
+        size_t num_qualified = 0;
+        
+        for (size_t j = 0; j < num_candidates; j++) {
+            int64_t partkey = partkeys[candidate_rows[j]];
             
-            int64_t partkey = l_partkey_array->Value(i);
-            
-            // Check if this is a "green" part
-            if (green_parts.find(partkey) == green_parts.end()) {
+            // Bloom filter hits still need the exact check
+            if (!green_parts.exact() && !green_parts.Contains(partkey)) {
                 continue;
             }
             
-            int64_t orderkey = l_orderkey_array->Value(i);
-            int64_t suppkey = l_suppkey_array->Value(i);
-            
-            // Skip if we don't have year data for this order
-            if (order_year_map.find(orderkey) == order_year_map.end()) {
+            // Skip rows without year, nation or supply cost data; every year
+            // in order_year_map has a group
+            int32_t year = order_years[j];
+            if (year == Int32JoinTable::kMissing) {
                 continue;
             }
-            
-            // Skip if we don't have nation data for this supplier
-            if (supplier_nation_map.find(suppkey) == supplier_nation_map.end()) {
+            int32_t nation = supplier_nations[j];
+            if (nation == Int32JoinTable::kMissing) {
                 continue;
             }
-            
-            // Skip if we don't have supply cost data
-            std::pair<int64_t, int64_t> ps_key = {partkey, suppkey};
-            if (partsupp_cost_map.find(ps_key) == partsupp_cost_map.end()) {
+            const double* cost_entry = partsupp_cost_map.Find({partkey, candidate_suppkeys[j]});
+            if (!cost_entry) {
                 continue;
             }
             
-            // Get necessary values
-            int64_t nationkey = supplier_nation_map[suppkey];
-            int32_t year = order_year_map[orderkey];
-            double supplycost = partsupp_cost_map[ps_key];
-            
-            // Convert decimal values to float
-            arrow::Decimal128 quantity_val(l_quantity_decimal_array->Value(i));
-            arrow::Decimal128 price_val(l_extendedprice_decimal_array->Value(i));
-            arrow::Decimal128 discount_val(l_discount_decimal_array->Value(i));
-            
-            float quantity = quantity_val.ToDouble(quantity_scale);
-            float extendedprice = price_val.ToDouble(price_scale);
-            float discount = discount_val.ToDouble(discount_scale);
-            
-            // Store values for batch processing
-            price_data.push_back(extendedprice);
-            discount_data.push_back(discount);
-            quantity_data.push_back(quantity);
-            supplycost_data.push_back(supplycost);
-            
-            // Keep track of which nation-year each row belongs to
-            std::pair<int64_t, int32_t> nation_year_key = {nationkey, year};
-            size_t batch_index = price_data.size() - 1;
-            nation_year_indices[nation_year_key].push_back(batch_index);
-            
-            rows_qualified++;
-            
-            // Process in batches for RVV efficiency
-            if (price_data.size() >= BATCH_SIZE) {
-                // Allocate array for profit calculation results
-                float* profit_results = new float[price_data.size()];
-                
-                // Process batch using RVV
-                batch_process_profit(
-                    price_data.data(),
-                    discount_data.data(),
-                    quantity_data.data(),
-                    supplycost_data.data(),
-                    profit_results,
-                    price_data.size()
-                );
-                
-                // Accumulate profits by nation and year
-                for (const auto& [key, indices] : nation_year_indices) {
-                    int64_t nationkey = key.first;
-                    int32_t year = key.second;
-                    std::string nation = nation_map[nationkey];
-                    
-                    double nation_year_profit = 0.0;
-                    for (size_t idx : indices) {
-                        nation_year_profit += profit_results[idx];
-                    }
-                    
-                    NationYearKey result_key = {nation, year};
-                    profit_by_nation_year[result_key] += nation_year_profit;
-                }
-                
-                // Clean up
-                delete[] profit_results;
-                price_data.clear();
-                discount_data.clear();
-                quantity_data.clear();
-                supplycost_data.clear();
-                nation_year_indices.clear();
-            }
+            price_data[num_qualified] = chunk_price[j];
+            discount_data[num_qualified] = chunk_discount[j];
+            quantity_data[num_qualified] = chunk_quantity[j];
+            supplycost_data[num_qualified] = static_cast<float>(*cost_entry);
+            row_nations[num_qualified] = nation;
+            row_years[num_qualified] = year;
+            num_qualified++;
         }
+        rows_qualified += num_qualified;
         
-        // Process any remaining rows
-        if (!price_data.empty()) {
-            // Allocate array for profit calculation results
-            float* profit_results = new float[price_data.size()];
-            
-            // Process batch using RVV
-            batch_process_profit(
-                price_data.data(),
-                discount_data.data(),
-                quantity_data.data(),
-                supplycost_data.data(),
-                profit_results,
-                price_data.size()
-            );
-            
-            // Accumulate profits by nation and year
-            for (const auto& [key, indices] : nation_year_indices) {
-                int64_t nationkey = key.first;
-                int32_t year = key.second;
-                std::string nation = nation_map[nationkey];
-                
-                double nation_year_profit = 0.0;
-                for (size_t idx : indices) {
-                    nation_year_profit += profit_results[idx];
-                }
-                
-                NationYearKey result_key = {nation, year};
-                profit_by_nation_year[result_key] += nation_year_profit;
-            }
-            
-            // Clean up
-            delete[] profit_results;
+        // profit = extendedprice * (1 - discount) - supplycost * quantity
+        timer.Switch(Phase::kAggregate);
+        timer.Count(num_qualified, num_qualified * (4 * sizeof(float) + 2 * sizeof(int32_t)));
+        float* profit_data = scratch.Allocate<float>(num_qualified);
+        rvv::with_lmul(rvv::KernelClass::kArith, [&](auto lmul) {
+            rvv::mul_one_minus_sub_mul<float, decltype(lmul)::value>(
+                price_data, discount_data, supplycost_data, quantity_data,
+                profit_data, num_qualified);
+        });
+        
+        // Group ids in a vector pass, then a scatter-add into the groups
+        int32_t* group_ids = scratch.Allocate<int32_t>(num_qualified);
+        rvv::linear_group_ids(row_nations, year_slots, row_years, -first_year,
+                              group_ids, num_qualified);
+        profit_groups.Add(group_ids, profit_data, num_qualified);
+    }
+    
+    PhaseTimer timer(Phase::kAggregate);
+    std::map<NationYearKey, double> profit_by_nation_year;
+    for (size_t group = 0; group < profit_groups.num_groups(); group++) {
+        if (profit_groups.count(group) == 0) {
+            continue;
         }
+        NationYearKey result_key = {nation_names[group / year_slots],
+                                    first_year + static_cast<int32_t>(group % year_slots)};
+        profit_by_nation_year[result_key] += profit_groups.sum(group);
     }
     
     // Convert map to vector for sorting
@@ -682,6 +576,7 @@ int main(int argc, char** argv) {
     
     // Sort results by nation, o_year DESC
     std::sort(results.begin(), results.end());
+    timer.Stop();
     
     auto end_time = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed = end_time - start_time;
@@ -697,10 +592,37 @@ int main(int argc, char** argv) {
         std::cout << std::setw(25) << result.nation
                   << std::setw(10) << result.o_year
                   << std::setw(20) << std::fixed << std::setprecision(2) << result.sum_profit << std::endl;
+        QueryProfile::Global().AddRow({result.nation, ResultField(result.o_year),
+                                       ResultField(result.sum_profit)});
     }
     
     std::cout << "\nQuery executed in " << elapsed.count() << " seconds" << std::endl;
     std::cout << "Processed " << rows_processed << " lineitem rows, " << rows_qualified << " qualified" << std::endl;
     
+    return Status::OK();
+}
+
+int main(int argc, char** argv) {
+    if (argc < 7) {
+        std::cerr << "Usage: " << argv[0] 
+                  << " <part.parquet> <supplier.parquet> <lineitem.parquet> "
+                  << "<partsupp.parquet> <orders.parquet> <nation.parquet> "
+                  << QueryOptionsUsage() << std::endl;
+        return 1;
+    }
+    
+    QueryOptions options;
+    Status st = ParseQueryOptions(argc, argv, 7, &options);
+    if (st.ok()) {
+        st = RunQuery9(argv[1], argv[2], argv[3], argv[4], argv[5], argv[6],
+                       options);
+    }
+    
+    if (!st.ok()) {
+        std::cerr << "Error: " << st.ToString() << std::endl;
+        return 1;
+    }
+    
+    WriteProfile();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,151 @@
+// Long-running driver for the single-pass queries, sharing lineitem scans.
+//
+//   rvv_query_server <orders_parquet> <lineitem_parquet> [part_parquet]
+//                    [options]
+//
+// Parses both Parquet footers once at startup, then reads requests from
+// stdin, one per line: query numbers separated by spaces, e.g. "1 6 12".
+// The queries of a request run over a single parallel pass of lineitem
+// (shared_scan.h), so each row group is read and decoded once for all of
+// them, and print their results in turn. "quit" or the end of input stops
+// the server. Queries 1, 6 and 12 can be served, and 14 as well when a part
+// file is given; the options are those of the rvv_query binaries. The files
+// must not change while the server runs.
+#include <arrow/result.h>
+#include <arrow/status.h>
+#include <parquet/metadata.h>
+
+#include "parallel_scan.h"
+#include "parquet_scan.h"
+#include "query_options.h"
+#include "query_profile.h"
+#include "scan_queries.h"
+#include "shared_scan.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+arrow::Result<std::shared_ptr<parquet::FileMetaData>> ReadFooter(
+    const std::string& file_path, const InputOptions& input) {
+  ScanOptions options;
+  options.input = input;
+  std::unique_ptr<ParquetScanner> scanner;
+  ARROW_ASSIGN_OR_RAISE(scanner, ParquetScanner::Open(file_path, options));
+  return scanner->metadata();
+}
+
+class QueryServer {
+ public:
+  QueryServer(std::string orders_file, std::string lineitem_file,
+              std::string part_file, const QueryOptions& options)
+      : orders_file_(std::move(orders_file)),
+        lineitem_file_(std::move(lineitem_file)),
+        part_file_(std::move(part_file)),
+        options_(options),
+        num_threads_(ResolveThreadCount(options.num_threads)) {}
+
+  arrow::Status Open() {
+    ARROW_ASSIGN_OR_RAISE(orders_metadata_,
+                          ReadFooter(orders_file_, options_.input));
+    ARROW_ASSIGN_OR_RAISE(lineitem_metadata_,
+                          ReadFooter(lineitem_file_, options_.input));
+    return arrow::Status::OK();
+  }
+
+  // Runs the queries of one request line.
+  arrow::Status Run(const std::string& request) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    std::vector<std::unique_ptr<ScanQuery>> queries;
+    std::istringstream numbers(request);
+    std::string number;
+    while (numbers >> number) {
+      if (number == "1") {
+        queries.push_back(MakeQuery1(options_));
+      } else if (number == "6") {
+        queries.push_back(MakeQuery6(options_));
+      } else if (number == "12") {
+        queries.push_back(
+            MakeQuery12(orders_file_, options_, orders_metadata_));
+      } else if (number == "14" && !part_file_.empty()) {
+        queries.push_back(MakeQuery14(part_file_, options_));
+      } else {
+        return arrow::Status::Invalid(
+            "Cannot serve query ", number, "; queries 1, 6 and 12 can be ",
+            "served, and 14 with a part file");
+      }
+    }
+    if (queries.empty()) {
+      return arrow::Status::OK();
+    }
+
+    std::vector<ScanQuery*> scan;
+    for (const auto& query : queries) {
+      scan.push_back(query.get());
+    }
+    ARROW_RETURN_NOT_OK(RunSharedScan(lineitem_file_, scan, options_.input,
+                                      num_threads_, lineitem_metadata_));
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = end_time - start_time;
+    std::cout << "\nRequest \"" << request << "\" (" << queries.size()
+              << " queries, one lineitem scan) executed in "
+              << elapsed.count() << " seconds" << std::endl;
+    return arrow::Status::OK();
+  }
+
+ private:
+  std::string orders_file_;
+  std::string lineitem_file_;
+  std::string part_file_;
+  QueryOptions options_;
+  int num_threads_;
+  std::shared_ptr<parquet::FileMetaData> orders_metadata_;
+  std::shared_ptr<parquet::FileMetaData> lineitem_metadata_;
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " <orders_parquet> <lineitem_parquet> "
+              << "[part_parquet] " << QueryOptionsUsage() << std::endl;
+    return 1;
+  }
+
+  // An optional third file before the options
+  std::string part_file;
+  int first_option = 3;
+  if (argc > 3 && std::string(argv[3]).rfind("--", 0) != 0) {
+    part_file = argv[3];
+    first_option = 4;
+  }
+  QueryOptions options;
+  arrow::Status st = ParseQueryOptions(argc, argv, first_option, &options);
+  QueryServer server(argv[1], argv[2], part_file, options);
+  if (st.ok()) {
+    st = server.Open();
+  }
+  if (!st.ok()) {
+    std::cerr << "Error: " << st.ToString() << std::endl;
+    return 1;
+  }
+
+  // A failed request is reported and the server goes on with the next one
+  std::string request;
+  while (std::getline(std::cin, request) && request != "quit") {
+    st = server.Run(request);
+    if (!st.ok()) {
+      std::cerr << "Error: " << st.ToString() << std::endl;
+    }
+  }
+
+  WriteProfile();
+  return 0;
+}
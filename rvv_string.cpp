@@ -0,0 +1,106 @@
+#include "rvv_kernels.h"
+
+#include "rvv_ops.h"
+
+#include <cstring>
+
+namespace rvv {
+
+using detail::RvvOps;
+
+namespace {
+
+// Clears bits [bit_pos, bit_pos + nbits) of bitmap.
+void clear_bits(uint8_t* bitmap, size_t bit_pos, size_t nbits) {
+  for (; nbits != 0 && (bit_pos & 7) != 0; bit_pos++, nbits--) {
+    bitmap[bit_pos / 8] &= static_cast<uint8_t>(~(1u << (bit_pos & 7)));
+  }
+  std::memset(bitmap + bit_pos / 8, 0, nbits / 8);
+  bit_pos += nbits & ~size_t(7);
+  for (nbits &= 7; nbits != 0; bit_pos++, nbits--) {
+    bitmap[bit_pos / 8] &= static_cast<uint8_t>(~(1u << (bit_pos & 7)));
+  }
+}
+
+}  // namespace
+
+// Candidates come out of the compare in position order, so the row holding
+// one is found by walking the offsets forward; once a row has matched, the
+// rest of its candidates are ignored.
+template <int LMUL>
+void contains_bitmap(const int32_t* offsets, const uint8_t* data, size_t n,
+                     const char* needle, size_t needle_length, uint8_t* out,
+                     size_t out_offset) {
+  using Ops = RvvOps<uint8_t, LMUL>;
+  if (needle_length == 0) {
+    for (size_t i = 0; i < n; i++) {
+      size_t bit = out_offset + i;
+      out[bit / 8] |= static_cast<uint8_t>(1 << (bit % 8));
+    }
+    return;
+  }
+  clear_bits(out, out_offset, n);
+  if (n == 0) {
+    return;
+  }
+
+  const uint8_t* pattern = reinterpret_cast<const uint8_t*>(needle);
+  const uint8_t first = pattern[0];
+  const uint8_t last = pattern[needle_length - 1];
+  // Candidate starts are [offsets[0], offsets[n] - needle_length]
+  const int64_t begin = offsets[0];
+  const int64_t end = static_cast<int64_t>(offsets[n]) -
+                      static_cast<int64_t>(needle_length) + 1;
+  size_t row = 0;
+  int64_t matched_until = begin;  // end of the last row that matched
+  uint8_t candidates[detail::kMaxMaskBytes];
+  size_t vl;
+  for (int64_t pos = begin; pos < end; pos += vl) {
+    vl = Ops::setvl(end - pos);
+    auto v_first = Ops::load(data + pos, vl);
+    auto v_last = Ops::load(data + pos + needle_length - 1, vl);
+    auto v_hit = __riscv_vmand(__riscv_vmseq(v_first, first, vl),
+                               __riscv_vmseq(v_last, last, vl), vl);
+    if (__riscv_vcpop(v_hit, vl) == 0) {
+      continue;
+    }
+    Ops::store_mask(candidates, v_hit, vl);
+    for (size_t j = 0; j < (vl + 7) / 8; j++) {
+      unsigned bits = candidates[j];
+      if (j == vl / 8) {
+        bits &= (1u << (vl & 7)) - 1;  // the mask tail is agnostic
+      }
+      for (; bits != 0; bits &= bits - 1) {
+        int64_t p = pos + 8 * j + __builtin_ctz(bits);
+        if (p < matched_until) {
+          continue;
+        }
+        while (offsets[row + 1] <= p) {
+          row++;
+        }
+        int64_t row_end = offsets[row + 1];
+        if (p + static_cast<int64_t>(needle_length) > row_end) {
+          continue;
+        }
+        if (needle_length > 2 &&
+            std::memcmp(data + p + 1, pattern + 1, needle_length - 2) != 0) {
+          continue;
+        }
+        size_t bit = out_offset + row;
+        out[bit / 8] |= static_cast<uint8_t>(1 << (bit % 8));
+        matched_until = row_end;
+      }
+    }
+  }
+}
+
+#define RVV_INSTANTIATE_STRING(LMUL)                                          \
+  template void contains_bitmap<LMUL>(const int32_t*, const uint8_t*, size_t, \
+                                      const char*, size_t, uint8_t*, size_t);
+
+RVV_INSTANTIATE_STRING(1)
+RVV_INSTANTIATE_STRING(2)
+RVV_INSTANTIATE_STRING(4)
+RVV_INSTANTIATE_STRING(8)
+
+}  // namespace rvv
@@ -0,0 +1,29 @@
+// The queries that are one pass over lineitem, as ScanQuery
+// implementations (shared_scan.h), so rvv_query_server can run several of
+// them over a single scan. Each prints and records its result in Finish(),
+// as its rvv_query binary did alone.
+#pragma once
+
+#include "query_options.h"
+#include "shared_scan.h"
+
+#include <parquet/metadata.h>
+
+#include <memory>
+#include <string>
+
+std::unique_ptr<ScanQuery> MakeQuery1(const QueryOptions& options);
+
+std::unique_ptr<ScanQuery> MakeQuery6(const QueryOptions& options);
+
+// Q12 joins lineitem with orders_file, whose order priorities a JoinBuild
+// scans after the lineitem scan, for the candidate orderkeys only;
+// orders_metadata is that file's footer, if parsed already.
+std::unique_ptr<ScanQuery> MakeQuery12(
+    const std::string& orders_file, const QueryOptions& options,
+    std::shared_ptr<parquet::FileMetaData> orders_metadata = nullptr);
+
+// Q14 joins lineitem with part_file, whose promotional parts a JoinBuild
+// scans in Start() (operators.h).
+std::unique_ptr<ScanQuery> MakeQuery14(const std::string& part_file,
+                                       const QueryOptions& options);
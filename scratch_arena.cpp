@@ -0,0 +1,64 @@
+#include "scratch_arena.h"
+
+#include "rvv_kernels.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr size_t kAlignment = 64;
+constexpr size_t kMinBlockSize = 1 << 20;
+
+// Allocation granule: whole register groups (VLEN is a power of two) and at
+// least the alignment.
+size_t Granule() {
+  static const size_t granule =
+      std::max(kAlignment, rvv::vector_group_bytes());
+  return granule;
+}
+
+}  // namespace
+
+ScratchArena& ScratchArena::ForThread() {
+  thread_local ScratchArena arena;
+  return arena;
+}
+
+void ScratchArena::Reset() {
+  if (blocks_.size() > 1) {
+    size_t total = capacity();
+    blocks_.clear();
+    AddBlock(total);
+  }
+  used_ = 0;
+}
+
+size_t ScratchArena::capacity() const {
+  size_t total = 0;
+  for (const auto& block : blocks_) {
+    total += block.size;
+  }
+  return total;
+}
+
+void* ScratchArena::AllocateBytes(size_t bytes) {
+  size_t granule = Granule();
+  size_t rounded = std::max(granule, (bytes + granule - 1) / granule * granule);
+  if (blocks_.empty() || used_ + rounded > blocks_.back().size) {
+    size_t last = blocks_.empty() ? 0 : blocks_.back().size;
+    AddBlock(std::max({rounded, 2 * last, kMinBlockSize}));
+  }
+  void* result = blocks_.back().base + used_;
+  used_ += rounded;
+  return result;
+}
+
+void ScratchArena::AddBlock(size_t size) {
+  Block block;
+  block.memory.reset(new uint8_t[size + kAlignment]);
+  auto address = reinterpret_cast<uintptr_t>(block.memory.get());
+  block.base = block.memory.get() + (kAlignment - address % kAlignment) % kAlignment;
+  block.size = size;
+  blocks_.push_back(std::move(block));
+  used_ = 0;
+}
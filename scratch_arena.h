@@ -0,0 +1,51 @@
+// Per-thread scratch memory for the batch-sized temporaries of the query
+// operators (decoded columns, compacted rows, selection bitmaps).
+//
+// An operator calls Reset() when it starts a batch and takes its buffers
+// from Allocate(); they stay valid until the next Reset(). Every buffer is
+// 64-byte aligned and rounded up to whole vector register groups. When a
+// batch outgrows the arena, Reset() folds its blocks into one, so after the
+// first batches nothing is allocated at all.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+class ScratchArena {
+ public:
+  ScratchArena() = default;
+  ScratchArena(const ScratchArena&) = delete;
+  ScratchArena& operator=(const ScratchArena&) = delete;
+
+  // The arena of the calling thread.
+  static ScratchArena& ForThread();
+
+  // n uninitialized elements.
+  template <typename T>
+  T* Allocate(size_t n) {
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "scratch buffers are never destroyed");
+    return static_cast<T*>(AllocateBytes(n * sizeof(T)));
+  }
+
+  // Makes all memory reusable; invalidates every buffer handed out.
+  void Reset();
+
+  size_t capacity() const;
+
+ private:
+  struct Block {
+    std::unique_ptr<uint8_t[]> memory;
+    uint8_t* base;  // memory rounded up to the alignment
+    size_t size;
+  };
+
+  void* AllocateBytes(size_t bytes);
+  void AddBlock(size_t size);
+
+  std::vector<Block> blocks_;
+  size_t used_ = 0;  // bytes taken from the last block
+};
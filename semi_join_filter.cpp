@@ -0,0 +1,165 @@
+#include "semi_join_filter.h"
+
+#include "join_cache.h"
+#include "rvv_kernels.h"
+
+#include <algorithm>
+
+namespace {
+
+// Bloom blocks are 64 bits; four keys per block is about 16 bits per key
+constexpr int64_t kBloomKeysPerBlock = 4;
+constexpr int kMinLogBlocks = 6;
+constexpr int kMaxLogBlocks = 40;
+constexpr int64_t kBloomBitsPerKey = 64 / kBloomKeysPerBlock;
+
+}  // namespace
+
+SemiJoinFilter::SemiJoinFilter(int64_t expected_keys)
+    : overflow_(static_cast<size_t>(std::max<int64_t>(expected_keys, 0))) {
+  log_blocks_ = kMinLogBlocks;
+  while (log_blocks_ < kMaxLogBlocks &&
+         (int64_t(1) << log_blocks_) * kBloomKeysPerBlock < expected_keys) {
+    log_blocks_++;
+  }
+  words_.assign(size_t(1) << log_blocks_, 0);
+}
+
+SemiJoinFilter SemiJoinFilter::ForRange(int64_t min, int64_t max,
+                                        int64_t expected_keys) {
+  uint64_t span = static_cast<uint64_t>(max) - static_cast<uint64_t>(min);
+  if (max < min || span / kBloomBitsPerKey >=
+                       static_cast<uint64_t>(std::max<int64_t>(expected_keys, 1))) {
+    return SemiJoinFilter(expected_keys);
+  }
+  SemiJoinFilter filter(0);
+  filter.dense_ = true;
+  filter.base_ = min;
+  filter.span_ = span + 1;
+  filter.words_.assign((filter.span_ + 63) / 64, 0);
+  return filter;
+}
+
+SemiJoinFilter SemiJoinFilter::ForColumn(const ParquetScanner& scanner,
+                                         const std::string& key_column,
+                                         int64_t expected_keys) {
+  int64_t min, max;
+  if (!scanner.ColumnRange(key_column, &min, &max)) {
+    return SemiJoinFilter(expected_keys);
+  }
+  return ForRange(min, max, expected_keys);
+}
+
+void SemiJoinFilter::Insert(int64_t key) {
+  min_key_ = size_ == 0 ? key : std::min(min_key_, key);
+  max_key_ = size_ == 0 ? key : std::max(max_key_, key);
+  if (dense_) {
+    uint64_t index = static_cast<uint64_t>(key) - static_cast<uint64_t>(base_);
+    if (index < span_) {
+      uint64_t bit = uint64_t(1) << (index & 63);
+      size_ += (words_[index / 64] & bit) == 0;
+      words_[index / 64] |= bit;
+    } else {
+      // Statistics said otherwise; keep the key exact on the side
+      size_ += overflow_.Insert(key).second;
+    }
+    return;
+  }
+  uint64_t hash = rvv::bloom_hash(key);
+  words_[rvv::bloom_block(hash, log_blocks_)] |= rvv::bloom_pattern(hash);
+  size_ += overflow_.Insert(key).second;
+}
+
+bool SemiJoinFilter::Contains(int64_t key) const {
+  if (dense_) {
+    uint64_t index = static_cast<uint64_t>(key) - static_cast<uint64_t>(base_);
+    if (index < span_) {
+      return (words_[index / 64] >> (index & 63)) & 1;
+    }
+  }
+  return overflow_.Contains(key);
+}
+
+bool SemiJoinFilter::KeyRange(int64_t* min, int64_t* max) const {
+  if (size_ == 0) {
+    return false;
+  }
+  *min = min_key_;
+  *max = max_key_;
+  return true;
+}
+
+bool SemiJoinFilter::MayContainRange(int64_t min, int64_t max) const {
+  if (size_ == 0 || max < min_key_ || min > max_key_) {
+    return false;
+  }
+  if (!dense_ || overflow_.size() != 0) {
+    return true;
+  }
+  // Every key is inside the bitmap; look for a set bit in [first, last]
+  uint64_t first = static_cast<uint64_t>(std::max(min, min_key_)) -
+                   static_cast<uint64_t>(base_);
+  uint64_t last = static_cast<uint64_t>(std::min(max, max_key_)) -
+                  static_cast<uint64_t>(base_);
+  for (uint64_t w = first / 64; w <= last / 64; w++) {
+    uint64_t word = words_[w];
+    if (w == first / 64) {
+      word &= ~uint64_t(0) << (first & 63);
+    }
+    if (w == last / 64) {
+      word &= ~uint64_t(0) >> (63 - (last & 63));
+    }
+    if (word != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+KeyFilter SemiJoinFilter::ScanFilter(const std::string& key_column) const {
+  return {key_column, [this](int64_t min, int64_t max) {
+            return MayContainRange(min, max);
+          }};
+}
+
+void SemiJoinFilter::Probe(const int64_t* keys, size_t n, uint8_t* out,
+                           size_t out_offset) const {
+  if (!dense_) {
+    rvv::probe_bloom(words_.data(), log_blocks_, keys, out, out_offset, n);
+    return;
+  }
+  rvv::probe_bitmap(words_.data(), base_, span_, keys, out, out_offset, n);
+  if (overflow_.size() == 0) {
+    return;
+  }
+  for (size_t i = 0; i < n; i++) {
+    if (overflow_.Contains(keys[i])) {
+      size_t bit = out_offset + i;
+      out[bit / 8] |= static_cast<uint8_t>(1 << (bit % 8));
+    }
+  }
+}
+
+void SemiJoinFilter::Save(JoinCacheWriter& out) const {
+  out.Value(dense_);
+  out.Value(base_);
+  out.Value(span_);
+  out.Array(words_);
+  out.Value(log_blocks_);
+  overflow_.Save(out);
+  out.Value(size_);
+  out.Value(min_key_);
+  out.Value(max_key_);
+}
+
+bool SemiJoinFilter::Load(JoinCacheReader& in) {
+  if (!in.Value(&dense_) || !in.Value(&base_) || !in.Value(&span_) ||
+      !in.Array(&words_) || !in.Value(&log_blocks_) || !overflow_.Load(in) ||
+      !in.Value(&size_) || !in.Value(&min_key_) || !in.Value(&max_key_)) {
+    return false;
+  }
+  // Probe() indexes words_ by span_ or by log_blocks_
+  return dense_ ? words_.size() == (span_ + 63) / 64
+                : log_blocks_ >= kMinLogBlocks && log_blocks_ <= kMaxLogBlocks &&
+                      words_.size() == size_t(1) << log_blocks_;
+}
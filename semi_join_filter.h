@@ -0,0 +1,81 @@
+// Semi-join filter over int64 keys, e.g. EXISTS (... l_orderkey = o_orderkey)
+// or p_partkey IN (green parts).
+//
+// Dense key ranges (known from column min/max) get one bit per possible key,
+// which is exact. Sparse ones get a blocked Bloom filter of about 16 bits
+// per key for the vector probe, plus an exact FlatHashSet that Contains()
+// consults for the candidates. Probe() turns a vector of probe-side keys
+// into a selection bitmap in one RVV pass, so rows that cannot match are
+// dropped before any other join lookup. ScanFilter() publishes the same
+// filter to a ParquetScanner, which skips row groups holding none of the keys.
+#pragma once
+
+#include "flat_hash_map.h"
+#include "parquet_scan.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class JoinCacheReader;
+class JoinCacheWriter;
+
+class SemiJoinFilter {
+ public:
+  // Bloom filter sized for expected_keys.
+  explicit SemiJoinFilter(int64_t expected_keys = 0);
+
+  // Bitmap over [min, max] when that costs no more than the Bloom filter,
+  // a Bloom filter otherwise.
+  static SemiJoinFilter ForRange(int64_t min, int64_t max,
+                                 int64_t expected_keys);
+
+  // The same for keys taken from key_column of scanner, using its file
+  // statistics.
+  static SemiJoinFilter ForColumn(const ParquetScanner& scanner,
+                                  const std::string& key_column,
+                                  int64_t expected_keys);
+
+  void Insert(int64_t key);
+
+  // Exact membership test.
+  bool Contains(int64_t key) const;
+
+  // Sets bit out_offset + i of out when keys[i] may be in the filter; with
+  // exact() a set bit means it is. Other bits are left untouched.
+  void Probe(const int64_t* keys, size_t n, uint8_t* out,
+             size_t out_offset = 0) const;
+
+  // Smallest and largest key inserted; false if the filter is empty.
+  bool KeyRange(int64_t* min, int64_t* max) const;
+
+  // Whether some key in [min, max] may be in the filter. Exact in bitmap
+  // mode; a check against KeyRange() otherwise.
+  bool MayContainRange(int64_t min, int64_t max) const;
+
+  // Row-group filter on key_column for ScanOptions::key_filters. The filter
+  // must outlive the ParquetScanner::Open() call.
+  KeyFilter ScanFilter(const std::string& key_column) const;
+
+  // Whether Probe() results need no Contains() check.
+  bool exact() const { return dense_; }
+
+  size_t size() const { return size_; }
+
+  // State for JoinCache (join_cache.h).
+  void Save(JoinCacheWriter& out) const;
+  bool Load(JoinCacheReader& in);
+
+ private:
+  bool dense_ = false;
+  int64_t base_ = 0;
+  uint64_t span_ = 0;             // number of keys the bitmap covers
+  std::vector<uint64_t> words_;   // bitmap, or the Bloom filter blocks
+  int log_blocks_ = 0;
+  // Bloom mode: every key. Dense mode: keys outside the statistics range.
+  FlatHashSet<int64_t> overflow_;
+  size_t size_ = 0;
+  int64_t min_key_ = 0;
+  int64_t max_key_ = 0;
+};
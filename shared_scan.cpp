@@ -0,0 +1,120 @@
+#include "shared_scan.h"
+
+#include <arrow/result.h>
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+namespace {
+
+bool Contains(const std::vector<std::string>& names, const std::string& name) {
+  return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+void AddUnique(const std::vector<std::string>& names,
+               std::vector<std::string>* into) {
+  for (const auto& name : names) {
+    if (!Contains(*into, name)) {
+      into->push_back(name);
+    }
+  }
+}
+
+// What one query makes of the shared scan
+struct QueryScan {
+  ScanOptions options;
+  std::vector<RowGroupMatch> match;
+  std::atomic<int64_t> rows_read{0};
+};
+
+}  // namespace
+
+arrow::Status RunSharedScan(const std::string& file_path,
+                            const std::vector<ScanQuery*>& queries,
+                            const InputOptions& input, int num_threads,
+                            std::shared_ptr<parquet::FileMetaData> metadata) {
+  std::vector<QueryScan> scans(queries.size());
+  ScanOptions options;
+  options.input = input;
+  options.metadata = std::move(metadata);
+  for (size_t q = 0; q < queries.size(); q++) {
+    scans[q].options = queries[q]->scan_options();
+    if (scans[q].options.columns.empty()) {
+      return arrow::Status::Invalid(
+          "Every query of a shared scan must name its columns");
+    }
+    AddUnique(scans[q].options.columns, &options.columns);
+    AddUnique(scans[q].options.dictionary_columns,
+              &options.dictionary_columns);
+  }
+  // A column comes in one type for everyone
+  for (const auto& scan : scans) {
+    for (const auto& column : scan.options.columns) {
+      if (Contains(options.dictionary_columns, column) &&
+          !Contains(scan.options.dictionary_columns, column)) {
+        return arrow::Status::Invalid(
+            column, " is read as a dictionary by one query of the shared "
+                    "scan and as plain strings by another");
+      }
+    }
+  }
+
+  std::unique_ptr<ParquetScanner> file;
+  ARROW_ASSIGN_OR_RAISE(file, ParquetScanner::Open(file_path, options));
+  options.metadata = file->metadata();
+  options.read_row_groups.assign(file->num_row_groups(), false);
+  for (auto& scan : scans) {
+    ARROW_ASSIGN_OR_RAISE(scan.match, file->MatchRowGroups(scan.options));
+    for (size_t rg = 0; rg < scan.match.size(); rg++) {
+      if (scan.match[rg] != RowGroupMatch::kNone) {
+        options.read_row_groups[rg] = true;
+      }
+    }
+  }
+  // ParallelScan starts no more workers than this either
+  num_threads = std::max(1, std::min(num_threads, file->num_row_groups()));
+  for (ScanQuery* query : queries) {
+    ARROW_RETURN_NOT_OK(query->Start(*file, num_threads));
+  }
+  file.reset();
+
+  ARROW_RETURN_NOT_OK(ParallelScan(
+      file_path, options, num_threads,
+      [&](int worker, const ParquetScanner& scanner,
+          const std::shared_ptr<arrow::RecordBatch>& batch) -> arrow::Status {
+        int rg = scanner.current_row_group();
+        for (size_t q = 0; q < queries.size(); q++) {
+          QueryScan& scan = scans[q];
+          if (scan.match[rg] == RowGroupMatch::kNone) {
+            continue;
+          }
+          ScanMorsel morsel{worker, rg, scan.match[rg] == RowGroupMatch::kAll,
+                            batch};
+          if (scan.options.columns.size() < options.columns.size()) {
+            std::vector<int> indices;
+            for (int i = 0; i < batch->num_columns(); i++) {
+              if (Contains(scan.options.columns, batch->column_name(i))) {
+                indices.push_back(i);
+              }
+            }
+            ARROW_ASSIGN_OR_RAISE(morsel.batch, batch->SelectColumns(indices));
+          }
+          scan.rows_read.fetch_add(batch->num_rows(),
+                                   std::memory_order_relaxed);
+          ARROW_RETURN_NOT_OK(queries[q]->Consume(morsel));
+        }
+        return arrow::Status::OK();
+      }));
+
+  for (size_t q = 0; q < queries.size(); q++) {
+    ScanStats stats;
+    stats.num_row_groups = static_cast<int>(scans[q].match.size());
+    stats.row_groups_skipped = static_cast<int>(
+        std::count(scans[q].match.begin(), scans[q].match.end(),
+                   RowGroupMatch::kNone));
+    stats.rows_read = scans[q].rows_read.load();
+    ARROW_RETURN_NOT_OK(queries[q]->Finish(stats));
+  }
+  return arrow::Status::OK();
+}
@@ -0,0 +1,64 @@
+// Scans shared by several queries over the same file.
+//
+// A query that needs one pass over a file implements ScanQuery: the columns
+// and prune predicates it reads the file with, a callback for the batches,
+// and Finish() for whatever follows the scan. RunSharedScan opens the file
+// once and makes a single parallel pass (ParallelScan) over the union of
+// the queries' columns, so e.g. Q1, Q6 and Q12 all run off one decode of
+// lineitem. Every batch goes to each query whose own predicates keep its
+// row group, on the worker thread that decoded it, while it is still in
+// cache; a row group is only skipped when no query needs it. Queries see
+// just their own columns and their own all-match flag, as if they had
+// scanned the file alone.
+//
+// The rvv_query binaries run their query through the same path, alone.
+#pragma once
+
+#include "parallel_scan.h"
+#include "parquet_scan.h"
+
+#include <arrow/record_batch.h>
+#include <arrow/status.h>
+#include <parquet/metadata.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+struct ScanMorsel {
+  int worker;
+  int row_group;
+  // Every row satisfies the query's prune predicates
+  bool all_match;
+  // The query's columns only, in file order
+  std::shared_ptr<arrow::RecordBatch> batch;
+};
+
+class ScanQuery {
+ public:
+  virtual ~ScanQuery() = default;
+
+  // Columns, dictionary_columns, prune and key_filters the query reads the
+  // file with; the other fields are ignored. Columns must not be empty.
+  virtual ScanOptions scan_options() const = 0;
+
+  // Before the first Consume(); file holds the statistics of the scanned
+  // file, workers run from 0 to num_workers - 1.
+  virtual arrow::Status Start(const ParquetScanner& file, int num_workers) = 0;
+
+  // One batch, on worker thread morsel.worker. Calls for different workers
+  // run concurrently, so state is kept per worker.
+  virtual arrow::Status Consume(const ScanMorsel& morsel) = 0;
+
+  // After the scan: the rest of the query, then its result. stats counts the
+  // row groups and rows of the query's own share of the scan.
+  virtual arrow::Status Finish(const ScanStats& stats) = 0;
+};
+
+// Runs queries over one scan of file_path with up to num_threads workers
+// (resolved already, as for ParallelScan). A footer parsed before can be
+// passed as metadata. Stops at the first error.
+arrow::Status RunSharedScan(
+    const std::string& file_path, const std::vector<ScanQuery*>& queries,
+    const InputOptions& input, int num_threads,
+    std::shared_ptr<parquet::FileMetaData> metadata = nullptr);